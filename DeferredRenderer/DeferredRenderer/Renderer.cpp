@@ -36,6 +36,25 @@ Renderer::~Renderer()
 {
 	mImageBasedLight.DeleteResources();
 
+	mClusteredLighting.DeleteClusteredLighting();
+
+	mGpuProfiler.DeleteGpuProfiler();
+
+	if (mIsUsingCascadedShadow)
+		mCascadedShadowMap.DeleteCascadedShadowMap();
+
+	if (mIsUsingLayeredPointShadow)
+	{
+		mPointShadowCubeMapArray.DeleteTexture();
+		mPointShadowFramebuffer.DeleteFramebuffer();
+		glDeleteBuffers(1, &mShadowFaceBuffer);
+		glDeleteBuffers(1, &mShadowDrawCommandBuffer);
+		glDeleteBuffers(1, &mShadowWorldBuffer);
+		glDeleteVertexArrays(1, &mShadowVertexArray);
+		glDeleteBuffers(1, &mShadowVertexBuffer);
+		glDeleteBuffers(1, &mShadowIndexBuffer);
+	}
+
 	for (auto& framebuffer : mFramebuffers)
 		framebuffer.second.DeleteFramebuffer();
 
@@ -45,6 +64,9 @@ Renderer::~Renderer()
 	 for (auto& texture : mBasicTextures)
 		 texture.second.DeleteTexture();
 
+	std::filesystem::create_directories(mProfileDirectoryName);
+	ExportCpuTraceToJSON(mProfileDirectoryName + "cpu_trace.json");
+
 	renderer = nullptr;
 
 	ImGui_ImplOpenGL3_Shutdown();
@@ -113,16 +135,29 @@ void Renderer::Initialize()
 	// Create G-Buffers.
 	BuildG_Buffers();
 
+	mClusteredLighting.CreateClusteredLighting(mMaxClusteredLightCount);
+
+	mGpuProfiler.CreateGpuProfiler();
+
 	for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.directionalLightCount; lightIndex++)
 		BuildDirectionalShadowResources(lightIndex);
 
+	if (mIsUsingCascadedShadow)
+		mCascadedShadowMap.CreateCascadedShadowMap(mCascadedShadowMapResolution, mCascadeCount);
+
 	// for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.pointLightCount; lightIndex++)
 	// 	BuildPointShadowResources(lightIndex);
 
+	if (mIsUsingLayeredPointShadow)
+		BuildPointShadowArrayResources();
+
 	mImageBasedLight.SetDirectoryAndFileName(mShaderDirectoryName, mTextureDirectoryName + "wooden_lounge_4k.hdr");
 	mImageBasedLight.BuildResources();
 
 	BuildRenderItems();
+
+	if (mIsUsingLayeredPointShadow)
+		BuildPointShadowGeometry();
 }
 
 void Renderer::RenderLoop()
@@ -137,6 +172,8 @@ void Renderer::RenderLoop()
 
 	while (!glfwWindowShouldClose(mWindow))
 	{
+		TRACE_CPU_ZONE("Frame");
+
 		float currentFrame = static_cast<float>(glfwGetTime());
 		mDeltaTime = currentFrame - mLastFrame;
 		mLastFrame = currentFrame;
@@ -147,7 +184,10 @@ void Renderer::RenderLoop()
 
 		ProcessKeyboardInput();
 		UpdateData();
+
+		mGpuProfiler.BeginFrame();
 		DrawScene();
+		mGpuProfiler.EndFrame();
 
 		glfwSwapBuffers(mWindow);
 		glfwPollEvents();
@@ -227,6 +267,15 @@ bool Renderer::InitializeWindow()
 		return false;
 	}
 
+	// reversed-Z needs glClipControl, core in 4.5 and ARB_clip_control before it. glad only loads it for 4.5.
+	if (!GLAD_GL_VERSION_4_5 && IsExtensionSupported("GL_ARB_clip_control"))
+		glad_glClipControl = reinterpret_cast<PFNGLCLIPCONTROLPROC>(glfwGetProcAddress("glClipControl"));
+	if (mIsUsingReversedDepth && glClipControl == nullptr)
+	{
+		std::cout << "glClipControl is not supported, reconstructing positions from standard depth" << std::endl;
+		mIsUsingReversedDepth = false;
+	}
+
 	glfwSetFramebufferSizeCallback(mWindow, _FramebufferSizeCallback);
 	glfwSetCursorPosCallback(mWindow, _MouseCallback);
 	glfwSetKeyCallback(mWindow, _KeyCallback);
@@ -262,15 +311,49 @@ void Renderer::ProcessKeyboardInput()
 void Renderer::UpdateData()
 {
 	UpdateSceneConstants();
+
+	if (mMenu.enableClusteredLighting)
+		UpdateClusteredLights();
+
+	if (mIsUsingCascadedShadow)
+	{
+		mCascadedShadowMap.TrackStaticCasters(mAllRenderItems[RenderLayer::Shadow], mSceneConstant.directionalLights[0].direction);
+		mCascadedShadowMap.UpdateCascades(mCamera, mSceneConstant.directionalLights[0].direction);
+	}
 }
 void Renderer::DrawScene()
 {
-	for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.directionalLightCount; lightIndex++)
-		DrawShadowMap(RenderLayer::Shadow, mProgramIDs["shadow"], lightIndex);
+	TRACE_CPU_ZONE("DrawScene");
+
+	// the first directional light uses cascades, the others keep a single shadow map.
+	// nothing samples the shadow maps when the menu disables shadows.
+	if (mMenu.enableShadow)
+	{
+		uint32_t firstShadowMapLightIndex = 0;
+		if (mIsUsingCascadedShadow)
+		{
+			mGpuProfiler.BeginZone("CascadedShadowMap");
+			DrawCascadedShadowMap(RenderLayer::Shadow, mProgramIDs["shadow"]);
+			mGpuProfiler.EndZone();
+			firstShadowMapLightIndex = 1;
+		}
+
+		mGpuProfiler.BeginZone("ShadowMap");
+		for (uint32_t lightIndex = firstShadowMapLightIndex; lightIndex < mSceneConstant.directionalLightCount; lightIndex++)
+			DrawShadowMap(RenderLayer::Shadow, mProgramIDs["shadow"], lightIndex);
+		mGpuProfiler.EndZone();
+	}
 
 	// for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.pointLightCount; lightIndex++)
 	// 	DrawShadowCubeMap(RenderLayer::Shadow, mProgramIDs["pointShadow"], lightIndex);
 
+	if (mIsUsingLayeredPointShadow && mMenu.enableShadow)
+	{
+		mGpuProfiler.BeginZone("PointShadowCubeMapArray");
+		DrawPointShadowCubeMapArray(RenderLayer::Shadow, mProgramIDs["pointShadowLayered"]);
+		mGpuProfiler.EndZone();
+	}
+
 	int windowWidth, windowHeight;
 	glfwGetFramebufferSize(mWindow, &windowWidth, &windowHeight);
 	glViewport(0, 0, windowWidth, windowHeight);
@@ -286,17 +369,22 @@ void Renderer::DrawScene()
 	// glEnable(GL_CULL_FACE);
 	// glCullFace(GL_BACK);
 
+	mGpuProfiler.BeginZone("G_Buffers");
 	DrawG_Buffers(RenderLayer::PBR, mProgramIDs["gBuffer"]);
-	DrawRenderItems(RenderLayer::PBR_Deferred, mProgramIDs["pbr_deferred"]);
+	mGpuProfiler.EndZone();
+	if (mMenu.enableClusteredLighting)
+	{
+		mGpuProfiler.BeginZone("LightCulling");
+		mClusteredLighting.CullLights(mProgramIDs["lightCulling"], mSceneConstant.view, mSceneConstant.projection,
+			mCamera.GetNearZ(), mCamera.GetFarZ(), windowWidth, windowHeight);
+		mGpuProfiler.EndZone();
+	}
+	mGpuProfiler.BeginZone("DeferredLighting");
+	DrawRenderItems(RenderLayer::PBR_Deferred, mPBRDeferredPermutation.GetProgram(GetShaderFeatureMask(mMenu)));
+	mGpuProfiler.EndZone();
+	mGpuProfiler.BeginZone("Environment");
 	DrawRenderItems(RenderLayer::Environment, mProgramIDs["cubeMapHDR"], mMenu.enableEnvironment);
-
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, mDeferredFramebuffer.GetFramebuffer());
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
-	// blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
-	// the internal formats are implementation defined. This works on all of my systems, but if it doesn't on yours you'll likely have to write to the 		
-	// depth buffer in another shader stage (or somehow see to match the default framebuffer's internal format with the FBO's internal format).
-	glBlitFramebuffer(0, 0, mWindowWidth, mWindowHeight, 0, 0, mWindowWidth, mWindowHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	mGpuProfiler.EndZone();
 
 	if (mShowImGuiWindow)
 	{
@@ -309,6 +397,8 @@ void Renderer::DrawScene()
 		ImGui::Checkbox("EnableEnvironment", &mMenu.enableEnvironment);
 		ImGui::Checkbox("EnableImageBasedLighting", &mMenu.enableImageBasedLighting);
 		ImGui::Checkbox("EnableShadow", &mMenu.enableShadow);
+		ImGui::Checkbox("EnableClusteredLighting", &mMenu.enableClusteredLighting);
+		ImGui::SliderInt("ExtraClusteredLights", &mExtraClusteredLightCount, 0, mMaxClusteredLightCount - PointLight::maxNumPointLights);
      
 		ImGui::SliderFloat4("ambient", &mSceneConstant.ambientLight.x, 0.0f, 1.0f);
 
@@ -318,18 +408,54 @@ void Renderer::DrawScene()
 		ImGui::SliderFloat("roughness", &pbrSphere.roughness, 0.0f, 1.0f);
 		ImGui::SliderFloat("ao", &pbrSphere.ao, 0.0f, 1.0f);
 
+		// results lag a few frames behind, see GpuProfiler::frameLatency.
+		if (ImGui::CollapsingHeader("GPU Profiler"))
+		{
+			for (const auto& zone : mGpuProfiler.GetZones())
+			{
+				ImGui::Text("%*s%-24s %7.3f ms  avg %7.3f  max %7.3f", static_cast<int>(zone.depth * 2), "",
+					zone.name.c_str(), zone.lastMilliseconds, zone.averageMilliseconds, zone.maxMilliseconds);
+			}
+
+			// build date and time tell exports of different builds apart.
+			std::string buildLabel = std::string(__DATE__) + " " + __TIME__;
+			if (ImGui::Button("Export CSV"))
+			{
+				std::filesystem::create_directories(mProfileDirectoryName);
+				mGpuProfiler.ExportToCSV(mProfileDirectoryName + "gpu_profile.csv", buildLabel);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Export JSON"))
+			{
+				std::filesystem::create_directories(mProfileDirectoryName);
+				mGpuProfiler.ExportToJSON(mProfileDirectoryName + "gpu_profile.json", buildLabel);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Reset"))
+				mGpuProfiler.ResetStatistics();
+		}
+
 		ImGui::End();
 	}
 
+	mGpuProfiler.BeginZone("ImGui");
 	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	mGpuProfiler.EndZone();
 }
 
 void Renderer::UpdateSceneConstants()
 {
+	TRACE_CPU_ZONE("UpdateSceneConstants");
+
 	mSceneConstant.view = mCamera.GetView();
 	mSceneConstant.projection = mCamera.GetProjection();
 	// mSceneConstant.projection = mCamera.GetOrthoProjection();
+	mSceneConstant.reversedProjection = mCamera.GetReversedProjection();
+
+	// the deferred pass inverts the projection the G-buffer was rasterized with.
+	mSceneConstant.invView = glm::inverse(mSceneConstant.view);
+	mSceneConstant.invProjection = glm::inverse(mIsUsingReversedDepth ? mSceneConstant.reversedProjection : mSceneConstant.projection);
 
 	mSceneConstant.cameraPos = mCamera.GetPosition();
 }
@@ -415,6 +541,104 @@ void Renderer::BuildPointShadowResources(uint32_t lightIndex)
 	glReadBuffer(GL_NONE);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
+void Renderer::BuildPointShadowArrayResources()
+{
+	TextureInfo shadowMapInfo;
+	shadowMapInfo.wrapSType = GL_CLAMP_TO_EDGE;
+	shadowMapInfo.wrapTType = GL_CLAMP_TO_EDGE;
+	shadowMapInfo.wrapRType = GL_CLAMP_TO_EDGE;
+	shadowMapInfo.minFilterType = GL_NEAREST;
+	shadowMapInfo.magFilterType = GL_NEAREST;
+	shadowMapInfo.isMipmap = false;
+	shadowMapInfo.nullData = true;
+	shadowMapInfo.width = mShadowMapWidth;
+	shadowMapInfo.height = mShadowMapHeight;
+	shadowMapInfo.textureInternalFormat = GL_DEPTH_COMPONENT32F;
+	shadowMapInfo.textureFormat = GL_DEPTH_COMPONENT;
+	mPointShadowCubeMapArray.CreateHDRTextureCubeArray(shadowMapInfo, mSceneConstant.pointLightCount);
+
+	// attaching the whole array makes the framebuffer layered, gl_Layer selects light and face.
+	mPointShadowFramebuffer.CreateFramebuffer(mShadowMapWidth, mShadowMapHeight, 0, false, false);
+	glBindFramebuffer(GL_FRAMEBUFFER, mPointShadowFramebuffer.GetFramebuffer());
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mPointShadowCubeMapArray.GetTexture(), 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Point shadow framebuffer is not complete!" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// face list, world matrices and draw commands are refilled every frame.
+	glGenBuffers(1, &mShadowFaceBuffer);
+	glGenBuffers(1, &mShadowDrawCommandBuffer);
+	glGenBuffers(1, &mShadowWorldBuffer);
+}
+void Renderer::BuildPointShadowGeometry()
+{
+	const auto& renderItems = mAllRenderItems[RenderLayer::Shadow];
+
+	// every shadow caster is copied into one vertex and index buffer, so the layered pass is a single multi-draw.
+	mShadowDrawCommands.clear();
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for (const auto& renderItem : renderItems)
+	{
+		DrawElementsIndirectCommand command{};
+		// only indexed triangle lists can share the draw, the others keep an empty command.
+		if (renderItem.mesh->GetPrimitiveType() == GL_TRIANGLES && renderItem.mesh->GetIndexFormat() == GL_UNSIGNED_INT)
+		{
+			command.count = renderItem.mesh->GetIndexCount();
+			command.firstIndex = indexCount;
+			command.baseVertex = static_cast<int32_t>(vertexCount);
+			vertexCount += static_cast<uint32_t>(renderItem.mesh->GetVertices().size());
+			indexCount += command.count;
+		}
+		mShadowDrawCommands.push_back(command);
+	}
+
+	glGenBuffers(1, &mShadowVertexBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mShadowVertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * vertexCount, nullptr, GL_STATIC_DRAW);
+	for (size_t itemIndex = 0; itemIndex < renderItems.size(); itemIndex++)
+	{
+		const auto& command = mShadowDrawCommands[itemIndex];
+		if (command.count == 0)
+			continue;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, renderItems[itemIndex].mesh->GetVertexBuffer());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, sizeof(Vertex) * command.baseVertex,
+			sizeof(Vertex) * renderItems[itemIndex].mesh->GetVertices().size());
+	}
+
+	glGenBuffers(1, &mShadowIndexBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mShadowIndexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, sizeof(uint32_t) * indexCount, nullptr, GL_STATIC_DRAW);
+	for (size_t itemIndex = 0; itemIndex < renderItems.size(); itemIndex++)
+	{
+		const auto& command = mShadowDrawCommands[itemIndex];
+		if (command.count == 0)
+			continue;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, renderItems[itemIndex].mesh->GetIndexBuffer());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, sizeof(uint32_t) * command.firstIndex,
+			sizeof(uint32_t) * command.count);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// positions per vertex, the visible face per instance.
+	glGenVertexArrays(1, &mShadowVertexArray);
+	glBindVertexArray(mShadowVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, mShadowVertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+	glBindBuffer(GL_ARRAY_BUFFER, mShadowFaceBuffer);
+	glEnableVertexAttribArray(4);
+	glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr);
+	glVertexAttribDivisor(4, 1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mShadowIndexBuffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 void Renderer::BuildMaterials()
 {
 	Material woodBox;
@@ -439,116 +663,189 @@ void Renderer::BuildMaterials()
 }
 void Renderer::BuildShaders()
 {
-	std::vector<uint32_t> shaderIDs;
+	TRACE_CPU_ZONE("BuildShaders");
+
+	mProgramCache.Initialize(mShaderCacheDirectoryName, (GLADloadproc)glfwGetProcAddress);
+
+	std::vector<Shader*> shaders;
+
+	// point shadows are rendered in one layered pass when the vertex shader can write gl_Layer,
+	// otherwise the geometry shader path below is kept.
+	std::vector<std::string> pointShadowLayeredDefines;
+	if (IsExtensionSupported("GL_ARB_shader_viewport_layer_array"))
+	{
+		mIsUsingLayeredPointShadow = true;
+		pointShadowLayeredDefines.push_back("USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY");
+	}
+	else if (IsExtensionSupported("GL_AMD_vertex_shader_layer"))
+		mIsUsingLayeredPointShadow = true;
 
 	Shader opaqueVertexShader;
 	Shader opaqueFragmentShader;
-	opaqueVertexShader.CompileShader(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
-	opaqueFragmentShader.CompileShader(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(opaqueVertexShader.GetShaderID());
-	shaderIDs.push_back(opaqueFragmentShader.GetShaderID());
-	LinkPrograms("opaque", shaderIDs);
-	shaderIDs.clear();
+	opaqueVertexShader.LoadShaderCode(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
+	opaqueFragmentShader.LoadShaderCode(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&opaqueVertexShader);
+	shaders.push_back(&opaqueFragmentShader);
+	LinkPrograms("opaque", shaders);
+	shaders.clear();
+
+	std::vector<std::string> gBufferDefines;
+	if (mIsUsingPackedG_Buffer)
+		gBufferDefines.push_back("PACKED_G_BUFFER");
 
 	Shader gBufferVertexShader;
 	Shader gBufferFragmentShader;
-	gBufferVertexShader.CompileShader(mShaderDirectoryName + "gBuffer.vert", GL_VERTEX_SHADER);
-	gBufferFragmentShader.CompileShader(mShaderDirectoryName + "gBuffer.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(gBufferVertexShader.GetShaderID());
-	shaderIDs.push_back(gBufferFragmentShader.GetShaderID());
-	LinkPrograms("gBuffer", shaderIDs);
-	shaderIDs.clear();
-
-	Shader pbrVertexShader;
-	Shader pbrFragmentShader;
-	pbrVertexShader.CompileShader(mShaderDirectoryName + "pbr.vert", GL_VERTEX_SHADER);
-	pbrFragmentShader.CompileShader(mShaderDirectoryName + "pbr.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(pbrVertexShader.GetShaderID());
-	shaderIDs.push_back(pbrFragmentShader.GetShaderID());
-	LinkPrograms("pbr", shaderIDs);
-	shaderIDs.clear();
-
-	Shader pbrDeferredVertexShader;
-	Shader pbrDeferredFragmentShader;
-	pbrDeferredVertexShader.CompileShader(mShaderDirectoryName + "pbr_deferred.vert", GL_VERTEX_SHADER);
-	pbrDeferredFragmentShader.CompileShader(mShaderDirectoryName + "pbr_deferred.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(pbrDeferredVertexShader.GetShaderID());
-	shaderIDs.push_back(pbrDeferredFragmentShader.GetShaderID());
-	LinkPrograms("pbr_deferred", shaderIDs);
-	shaderIDs.clear();
+	gBufferVertexShader.LoadShaderCode(mShaderDirectoryName + "gBuffer.vert", GL_VERTEX_SHADER);
+	gBufferFragmentShader.LoadShaderCode(mShaderDirectoryName + "gBuffer.frag", GL_FRAGMENT_SHADER, gBufferDefines);
+	shaders.push_back(&gBufferVertexShader);
+	shaders.push_back(&gBufferFragmentShader);
+	LinkPrograms("gBuffer", shaders);
+	shaders.clear();
+
+	// pbr_deferred variants are specialized per feature mask on first use.
+	std::vector<std::string> pbrDeferredDefines = gBufferDefines;
+	pbrDeferredDefines.push_back("RECONSTRUCT_POSITION_FROM_DEPTH");
+	if (mIsUsingReversedDepth)
+		pbrDeferredDefines.push_back("REVERSED_DEPTH");
+	// the light loops are unrolled over the scene's light counts.
+	pbrDeferredDefines.push_back("NUM_DIRECTIONAL_LIGHTS " + std::to_string(mSceneConstant.directionalLightCount));
+	pbrDeferredDefines.push_back("NUM_POINT_LIGHTS " + std::to_string(mSceneConstant.pointLightCount));
+	pbrDeferredDefines.push_back("NUM_SPOT_LIGHTS " + std::to_string(mSceneConstant.spotLightCount));
+	if (mIsUsingLayeredPointShadow)
+		pbrDeferredDefines.push_back("USE_POINT_SHADOW_ARRAY");
+	if (mIsUsingCascadedShadow)
+		pbrDeferredDefines.push_back("USE_CASCADED_SHADOW");
+	mPBRDeferredPermutation.Initialize(&mProgramCache, "pbr_deferred",
+		mShaderDirectoryName + "pbr_deferred.vert", mShaderDirectoryName + "pbr_deferred.frag", pbrDeferredDefines);
 
 	Shader cubeMapVertexShader;
 	Shader cubeMapFragmentShader;
-	cubeMapVertexShader.CompileShader(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
-	cubeMapFragmentShader.CompileShader(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(cubeMapFragmentShader.GetShaderID());
-	LinkPrograms("cubeMapHDR", shaderIDs);
-	shaderIDs.clear();
+	cubeMapVertexShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
+	cubeMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&cubeMapFragmentShader);
+	LinkPrograms("cubeMapHDR", shaders);
+	shaders.clear();
 
 	Shader equirectangularToCubeFragmentShader;
-	equirectangularToCubeFragmentShader.CompileShader(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(equirectangularToCubeFragmentShader.GetShaderID());
-	LinkPrograms("equirectangularToCube", shaderIDs);
-	shaderIDs.clear();
+	equirectangularToCubeFragmentShader.LoadShaderCode(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&equirectangularToCubeFragmentShader);
+	LinkPrograms("equirectangularToCube", shaders);
+	shaders.clear();
 
 	Shader irradianceMapFragmentShader;
-	std::vector<uint32_t> irradianceMapShaderIDs;
-	irradianceMapFragmentShader.CompileShader(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(irradianceMapFragmentShader.GetShaderID());
-	LinkPrograms("irradianceMap", shaderIDs);
-	shaderIDs.clear();
+	irradianceMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&irradianceMapFragmentShader);
+	LinkPrograms("irradianceMap", shaders);
+	shaders.clear();
 
 	Shader prefilterMapFragmentShader;
-	prefilterMapFragmentShader.CompileShader(mShaderDirectoryName + "prefilterMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(prefilterMapFragmentShader.GetShaderID());
-	LinkPrograms("prefilterMap", shaderIDs);
-	shaderIDs.clear();
+	prefilterMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "prefilterMap.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&prefilterMapFragmentShader);
+	LinkPrograms("prefilterMap", shaders);
+	shaders.clear();
 
 	Shader brdfVertexShader;
 	Shader brdfFragmentShader;
-	brdfVertexShader.CompileShader(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
-	brdfFragmentShader.CompileShader(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(brdfVertexShader.GetShaderID());
-	shaderIDs.push_back(brdfFragmentShader.GetShaderID());
-	LinkPrograms("brdf", shaderIDs);
-	shaderIDs.clear();
+	brdfVertexShader.LoadShaderCode(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
+	brdfFragmentShader.LoadShaderCode(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&brdfVertexShader);
+	shaders.push_back(&brdfFragmentShader);
+	LinkPrograms("brdf", shaders);
+	shaders.clear();
 
 	Shader shadowVertexShader;
 	Shader shadowFragmentShader;
-	shadowVertexShader.CompileShader(mShaderDirectoryName + "shadow.vert", GL_VERTEX_SHADER);
-	shadowFragmentShader.CompileShader(mShaderDirectoryName + "shadow.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(shadowVertexShader.GetShaderID());
-	shaderIDs.push_back(shadowFragmentShader.GetShaderID());
-	LinkPrograms("shadow", shaderIDs);
-	shaderIDs.clear();
+	shadowVertexShader.LoadShaderCode(mShaderDirectoryName + "shadow.vert", GL_VERTEX_SHADER);
+	shadowFragmentShader.LoadShaderCode(mShaderDirectoryName + "shadow.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&shadowVertexShader);
+	shaders.push_back(&shadowFragmentShader);
+	LinkPrograms("shadow", shaders);
+	shaders.clear();
 
 	Shader pointShadowVertexShader;
 	Shader pointShadowGeometryShader;
 	Shader pointShadowFragmentShader;
-	pointShadowVertexShader.CompileShader(mShaderDirectoryName + "pointShadow.vert", GL_VERTEX_SHADER);
-	pointShadowGeometryShader.CompileShader(mShaderDirectoryName + "pointShadow.geom", GL_GEOMETRY_SHADER);
-	pointShadowFragmentShader.CompileShader(mShaderDirectoryName + "pointShadow.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(pointShadowVertexShader.GetShaderID());
-	shaderIDs.push_back(pointShadowGeometryShader.GetShaderID());
-	shaderIDs.push_back(pointShadowFragmentShader.GetShaderID());
-	LinkPrograms("pointShadow", shaderIDs);
-	shaderIDs.clear();
+	pointShadowVertexShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.vert", GL_VERTEX_SHADER);
+	pointShadowGeometryShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.geom", GL_GEOMETRY_SHADER);
+	pointShadowFragmentShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&pointShadowVertexShader);
+	shaders.push_back(&pointShadowGeometryShader);
+	shaders.push_back(&pointShadowFragmentShader);
+	LinkPrograms("pointShadow", shaders);
+	shaders.clear();
+
+	Shader pointShadowLayeredVertexShader;
+	Shader pointShadowLayeredFragmentShader;
+	if (mIsUsingLayeredPointShadow)
+	{
+		pointShadowLayeredVertexShader.LoadShaderCode(mShaderDirectoryName + "pointShadowLayered.vert", GL_VERTEX_SHADER, pointShadowLayeredDefines);
+		pointShadowLayeredFragmentShader.LoadShaderCode(mShaderDirectoryName + "pointShadowLayered.frag", GL_FRAGMENT_SHADER);
+		shaders.push_back(&pointShadowLayeredVertexShader);
+		shaders.push_back(&pointShadowLayeredFragmentShader);
+		LinkPrograms("pointShadowLayered", shaders);
+		shaders.clear();
+	}
+
+	Shader lightCullingComputeShader;
+	lightCullingComputeShader.LoadShaderCode(mShaderDirectoryName + "lightCulling.comp", GL_COMPUTE_SHADER);
+	shaders.push_back(&lightCullingComputeShader);
+	LinkPrograms("lightCulling", shaders);
+	shaders.clear();
+
+	mProgramCache.BuildPrograms(mProgramIDs);
 }
 
 void Renderer::BuildFramebuffers()
 {
 	mShadowMapFramebuffer.CreateFramebuffer(mShadowMapWidth, mShadowMapHeight, 0, false, true);
-	mDeferredFramebuffer.CreateFramebuffer(mWindowWidth, mWindowHeight, 0, false, true);
+	// the depth texture for position reconstruction is attached in BuildG_Buffers.
+	mDeferredFramebuffer.CreateFramebuffer(mWindowWidth, mWindowHeight, 0, false, false);
 }
 
 void Renderer::BuildG_Buffers()
 {
+	TRACE_CPU_ZONE("BuildG_Buffers");
+
 	glBindFramebuffer(GL_FRAMEBUFFER, mDeferredFramebuffer.GetFramebuffer());
 
+	mG_BufferDepthMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+		false, true, mWindowWidth, mWindowHeight, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mG_BufferDepthMap.GetTexture(), 0);
+
+	if (mIsUsingPackedG_Buffer)
+	{
+		Texture albedoAoMap;
+		albedoAoMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+			false, true, mWindowWidth, mWindowHeight, GL_RGBA8, GL_RGBA);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoAoMap.GetTexture(), 0);
+		mG_Buffer.push_back(std::move(albedoAoMap));
+
+		Texture octahedralNormalMap;
+		octahedralNormalMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+			false, true, mWindowWidth, mWindowHeight, GL_RG16, GL_RG);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, octahedralNormalMap.GetTexture(), 0);
+		mG_Buffer.push_back(std::move(octahedralNormalMap));
+
+		Texture metallicRoughnessMap;
+		metallicRoughnessMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+			false, true, mWindowWidth, mWindowHeight, GL_RG8, GL_RG);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, metallicRoughnessMap.GetTexture(), 0);
+		mG_Buffer.push_back(std::move(metallicRoughnessMap));
+
+		std::array<uint32_t, 3> attachments = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, };
+		glDrawBuffers(3, attachments.data());
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER:: Packed G-buffer is not complete!" << std::endl;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return;
+	}
+
 	Texture albedoMap;
 	albedoMap.CreateTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
 		false, true, mWindowWidth, mWindowHeight, GL_RGB);
@@ -583,14 +880,68 @@ void Renderer::BuildG_Buffers()
 		GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, };
 	glDrawBuffers(5, attachments.data());
 
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: G-buffer is not complete!" << std::endl;
+
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void Renderer::UpdateClusteredLights()
+{
+	mClusteredPointLights.clear();
+	mClusteredSpotLights.clear();
+
+	for (uint32_t i = 0; i < mSceneConstant.pointLightCount; i++)
+		mClusteredPointLights.push_back(mSceneConstant.pointLights[i]);
+
+	for (uint32_t i = 0; i < mSceneConstant.spotLightCount; i++)
+		mClusteredSpotLights.push_back(mSceneConstant.spotLights[i]);
+
+	// extra lights orbit the scene on rings so the culling has dynamic work every frame,
+	// every fourth one is a spot light aimed at the center of the scene.
+	float time = static_cast<float>(glfwGetTime());
+	for (int i = 0; i < mExtraClusteredLightCount; i++)
+	{
+		float ring = static_cast<float>(i % 16);
+		float angle = 0.61803398875f * glm::two_pi<float>() * static_cast<float>(i) + time * (0.2f + 0.05f * ring);
+		float radius = 2.0f + 0.75f * ring;
+
+		glm::vec3 position = glm::vec3(radius * std::cos(angle), 0.5f * std::sin(time + static_cast<float>(i)), radius * std::sin(angle));
+		glm::vec3 diffuse = glm::vec3(
+			0.5f + 0.5f * std::sin(static_cast<float>(i) * 1.3f),
+			0.5f + 0.5f * std::sin(static_cast<float>(i) * 2.1f + 2.0f),
+			0.5f + 0.5f * std::sin(static_cast<float>(i) * 3.7f + 4.0f));
+
+		if (i % 4 == 3)
+		{
+			SpotLight spotLight{};
+			spotLight.position = position + glm::vec3(0.0f, 2.0f, 0.0f);
+			spotLight.direction = glm::normalize(-spotLight.position);
+			spotLight.diffuse = 4.0f * diffuse;
+			spotLight.cutOff = std::cos(glm::radians(20.0f));
+			spotLight.outerCutOff = std::cos(glm::radians(30.0f));
+			mClusteredSpotLights.push_back(spotLight);
+			continue;
+		}
+
+		PointLight pointLight{};
+		pointLight.position = position;
+		pointLight.diffuse = diffuse;
+		mClusteredPointLights.push_back(pointLight);
+	}
+
+	mClusteredLighting.UpdateLights(mClusteredPointLights, mClusteredSpotLights);
+}
+
 void Renderer::InitializeSceneConstant()
 {
 	mSceneConstant.view = mCamera.GetView();
 	mSceneConstant.projection = mCamera.GetProjection();
 	// mSceneConstant.projection = mCamera.GetOrthoProjection();
+	mSceneConstant.reversedProjection = mCamera.GetReversedProjection();
+
+	mSceneConstant.invView = glm::inverse(mSceneConstant.view);
+	mSceneConstant.invProjection = glm::inverse(mIsUsingReversedDepth ? mSceneConstant.reversedProjection : mSceneConstant.projection);
 
 	mSceneConstant.cameraPos = mCamera.GetPosition();
 
@@ -633,19 +984,10 @@ void Renderer::InitializeSceneConstant()
 	}
 }
 
-void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs)
+void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders)
 {
-	uint32_t programID = glCreateProgram();
-
-	for (const auto& shaderID : shaderIDs)
-		glAttachShader(programID, shaderID);
-	glLinkProgram(programID);
-	CheckCompileErrors(programID, "PROGRAM");
-
-	for (const auto& shaderID : shaderIDs)
-		glDetachShader(programID, shaderID);
-
-	mProgramIDs.insert({ shaderName, programID });
+	// linked later by mProgramCache.BuildPrograms, which tries the cached binary first.
+	mProgramCache.RequestProgram(shaderName, shaders);
 }
 void Renderer::UseProgram(uint32_t programID)
 {
@@ -670,6 +1012,7 @@ void Renderer::BuildRenderItems()
 	for (auto& modelComponent : miniModelComponents)
 	{
 		renderItem.mesh = &modelComponent.mesh;
+		renderItem.isStaticShadowCaster = true; // the shadow casters of this scene never move
 		world = glm::mat4(1.0f);
 		world = glm::scale(world, glm::vec3(0.05f, 0.05f, 0.05f));
 		world = glm::rotate(world, -glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -714,6 +1057,7 @@ void Renderer::BuildRenderItems()
 				0.0f
 			));
 			renderItem.mesh = &mBasicMeshes["sphere"];
+			renderItem.isStaticShadowCaster = true;
 			renderItem.world = world;
 			renderItem.material = &mBasicMaterials["pbrSphere"];
 			renderItem.albedoMaps.push_back(&mBasicTextures["rustediron2_basecolor"]);
@@ -737,6 +1081,7 @@ void Renderer::BuildRenderItems()
 	world = glm::mat4(1.0f);
 	world = glm::translate(world, glm::vec3(0.0f, -10.0f, -15.0f));
 	renderItem.mesh = &mBasicMeshes["grid"];
+	renderItem.isStaticShadowCaster = true;
 	renderItem.world = world;
 	renderItem.material = &mBasicMaterials["pbrSphere"];
 	renderItem.albedoMaps.push_back(&mBasicTextures["red-scifi-metal_albedo"]);
@@ -762,11 +1107,21 @@ void Renderer::BuildRenderItems()
 	renderItem.mesh = &mBasicMeshes["quad"];
 	renderItem.world = world;
 	renderItem.material = &mBasicMaterials["pbrSphere"];
-	renderItem.albedoMaps.push_back(&mG_Buffer[0]);
-	renderItem.normalMaps.push_back(&mG_Buffer[1]);
-	renderItem.metallicMaps.push_back(&mG_Buffer[2]);
-	renderItem.roughnessMaps.push_back(&mG_Buffer[3]);
-	renderItem.aoMaps.push_back(&mG_Buffer[4]);
+	if (mIsUsingPackedG_Buffer)
+	{
+		renderItem.albedoMaps.push_back(&mG_Buffer[0]);
+		renderItem.normalMaps.push_back(&mG_Buffer[1]);
+		renderItem.metallicRoughnessMaps.push_back(&mG_Buffer[2]);
+	}
+	else
+	{
+		renderItem.albedoMaps.push_back(&mG_Buffer[0]);
+		renderItem.normalMaps.push_back(&mG_Buffer[1]);
+		renderItem.metallicMaps.push_back(&mG_Buffer[2]);
+		renderItem.roughnessMaps.push_back(&mG_Buffer[3]);
+		renderItem.aoMaps.push_back(&mG_Buffer[4]);
+	}
+	renderItem.depthMaps.push_back(&mG_BufferDepthMap);
 	renderItem.irradianceMap = mImageBasedLight.GetIrradianceMap();
 	renderItem.prefilterMap = mImageBasedLight.GetPreFilteredEnvironmentMap();
 	renderItem.brdfLUT = mImageBasedLight.GetBRDFLookUpTable();
@@ -826,14 +1181,14 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 
 	UseProgram(programID);
 
-	SetBool(programID, "isUsingTexture", mMenu.isUsingTexture);
-	SetBool(programID, "isUsingNormalMap", mMenu.isUsingNormalMap);
-	SetBool(programID, "enableImageBasedLighting", mMenu.enableImageBasedLighting);
-	SetBool(programID, "enableShadow", mMenu.enableShadow);
-
 	SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
 	SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
+	SetMat4(programID, "sceneConstant.invView", mSceneConstant.invView);
+	SetMat4(programID, "sceneConstant.invProjection", mSceneConstant.invProjection);
 	SetVec3(programID, "sceneConstant.cameraPos", mSceneConstant.cameraPos);
+
+	if (mMenu.enableClusteredLighting)
+		mClusteredLighting.BindClusteredLighting(programID);
 	
 	SetVec4(programID, "sceneConstant.ambientLight", mSceneConstant.ambientLight);
 
@@ -912,6 +1267,16 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 			i++;
 		}
 
+		const auto& metallicRoughnessMaps = renderItem.metallicRoughnessMaps;
+		uint32_t metallicRoughnessMapCount = 0;
+		for (auto metallicRoughnessMap : metallicRoughnessMaps)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, metallicRoughnessMap->GetTexture());
+			SetInt(programID, "metallicRoughnessMap" + std::to_string(metallicRoughnessMapCount++), i);
+			i++;
+		}
+
 		const auto& aoMaps = renderItem.aoMaps;
 		uint32_t aoMapCount = 0;
 		for (auto aoMap : aoMaps)
@@ -922,6 +1287,16 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 			i++;
 		}
 
+		const auto& depthMaps = renderItem.depthMaps;
+		uint32_t depthMapCount = 0;
+		for (auto depthMap : depthMaps)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, depthMap->GetTexture());
+			SetInt(programID, "depthMap" + std::to_string(depthMapCount++), i);
+			i++;
+		}
+
 		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, renderItem.irradianceMap->GetTexture());
 		SetInt(programID, "irradianceMap", i);
@@ -957,6 +1332,20 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 			i++;
 		}
 
+		if (mIsUsingLayeredPointShadow)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, mPointShadowCubeMapArray.GetTexture());
+			SetInt(programID, "pointShadowCubeMapArray", i);
+			i++;
+		}
+
+		if (mIsUsingCascadedShadow)
+		{
+			mCascadedShadowMap.BindCascadedShadowMap(programID, i);
+			i++;
+		}
+
 		auto primitiveType = renderItem.mesh->GetPrimitiveType();
 		auto indexCount = renderItem.mesh->GetIndexCount();
 		auto indexFormat = renderItem.mesh->GetIndexFormat();
@@ -1004,6 +1393,60 @@ void Renderer::DrawShadowMap(RenderLayer renderLayer, uint32_t programID, uint32
 	glDisable(GL_CULL_FACE);
 }
 
+void Renderer::DrawCascadedShadowMap(RenderLayer renderLayer, uint32_t programID)
+{
+	// enable cull face for peter-panning
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+
+	const auto& renderItems = mAllRenderItems[renderLayer];
+
+	UseProgram(programID);
+
+	glViewport(0, 0, mCascadedShadowMapResolution, mCascadedShadowMapResolution);
+
+	auto drawCasters = [&](bool isStatic)
+	{
+		for (const auto& renderItem : renderItems)
+		{
+			if (renderItem.isStaticShadowCaster != isStatic)
+				continue;
+
+			SetMat4(programID, "world", renderItem.world);
+
+			auto primitiveType = renderItem.mesh->GetPrimitiveType();
+			auto indexCount = renderItem.mesh->GetIndexCount();
+			auto indexFormat = renderItem.mesh->GetIndexFormat();
+			auto vertexAttribArray = renderItem.mesh->GetVertexAttribArray();
+
+			glBindVertexArray(vertexAttribArray);
+			glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
+			glBindVertexArray(0);
+		}
+	};
+
+	for (uint32_t cascadeIndex = 0; cascadeIndex < mCascadedShadowMap.GetCascadeCount(); cascadeIndex++)
+	{
+		SetMat4(programID, "lightSpaceMatrix", mCascadedShadowMap.GetCascadeMatrix(cascadeIndex));
+
+		// static casters are re-rendered only when the cascade moved to another page or the light turned.
+		if (mCascadedShadowMap.IsStaticPageDirty(cascadeIndex))
+		{
+			mCascadedShadowMap.BeginStaticPage(cascadeIndex);
+			drawCasters(true);
+			mCascadedShadowMap.EndStaticPage(cascadeIndex);
+		}
+
+		mCascadedShadowMap.BeginDynamicPage(cascadeIndex);
+		drawCasters(false);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+}
+
 void Renderer::DrawShadowCubeMap(RenderLayer renderLayer, uint32_t programID, uint32_t lightIndex)
 {
 	// enable cull face for peter-panning
@@ -1019,10 +1462,8 @@ void Renderer::DrawShadowCubeMap(RenderLayer renderLayer, uint32_t programID, ui
 	glClear(GL_DEPTH_BUFFER_BIT);
 
 	for (int i = 0; i < 6; i++)
-	{
 		SetMat4(programID, "lightSpaceMatrices[" + std::to_string(i) + "]", mSceneConstant.pointLights[lightIndex].lightSpaceMatrices[i]);
-		SetVec3(programID, "lightPos", mSceneConstant.pointLights[lightIndex].position);
-	}
+	SetVec3(programID, "lightPos", mSceneConstant.pointLights[lightIndex].position);
 	SetFloat(programID, "farPlane", mSceneConstant.farPlaneForPointShadow);
 
 	for (auto renderItem : renderItems)
@@ -1045,9 +1486,103 @@ void Renderer::DrawShadowCubeMap(RenderLayer renderLayer, uint32_t programID, ui
 	glDisable(GL_CULL_FACE);
 }
 
+void Renderer::DrawPointShadowCubeMapArray(RenderLayer renderLayer, uint32_t programID)
+{
+	const auto& renderItems = mAllRenderItems[renderLayer];
+	const float farPlane = mSceneConstant.farPlaneForPointShadow;
+
+	// cull every render item against the faces of every light on the cpu,
+	// the visible faces become the instances of the item's command in one multi-draw.
+	mShadowFaces.clear();
+	mShadowWorlds.clear();
+	for (size_t itemIndex = 0; itemIndex < renderItems.size(); itemIndex++)
+	{
+		const auto& renderItem = renderItems[itemIndex];
+		auto& command = mShadowDrawCommands[itemIndex];
+		command.baseInstance = static_cast<uint32_t>(mShadowFaces.size());
+		mShadowWorlds.push_back(renderItem.world);
+
+		if (command.count != 0)
+		{
+			glm::vec3 center = glm::vec3(renderItem.world * glm::vec4(renderItem.mesh->GetBoundingBoxCenter(), 1.0f));
+			float maxScale = glm::max(glm::length(glm::vec3(renderItem.world[0])),
+				glm::max(glm::length(glm::vec3(renderItem.world[1])), glm::length(glm::vec3(renderItem.world[2]))));
+			float radius = static_cast<float>(renderItem.mesh->GetDiagnalLength()) * maxScale;
+
+			for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.pointLightCount; lightIndex++)
+			{
+				for (uint32_t face = 0; face < 6; face++)
+				{
+					if (IsSphereInCubeFace(mSceneConstant.pointLights[lightIndex].position, face, farPlane, center, radius))
+						mShadowFaces.push_back(static_cast<uint32_t>(itemIndex) << 8 | (lightIndex * 6 + face));
+				}
+			}
+		}
+
+		command.instanceCount = static_cast<uint32_t>(mShadowFaces.size()) - command.baseInstance;
+	}
+
+	glViewport(0, 0, mShadowMapWidth, mShadowMapHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, mPointShadowFramebuffer.GetFramebuffer());
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	if (mShadowFaces.empty())
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, mShadowFaceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * mShadowFaces.size(), mShadowFaces.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mShadowWorldBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * mShadowWorlds.size(), mShadowWorlds.data(), GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mShadowWorldBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mShadowDrawCommandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * mShadowDrawCommands.size(), mShadowDrawCommands.data(), GL_STREAM_DRAW);
+
+	// enable cull face for peter-panning
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+
+	UseProgram(programID);
+
+	// every light is set once for the whole pass.
+	for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.pointLightCount; lightIndex++)
+	{
+		for (uint32_t face = 0; face < 6; face++)
+			SetMat4(programID, "lightSpaceMatrices[" + std::to_string(lightIndex * 6 + face) + "]", mSceneConstant.pointLights[lightIndex].lightSpaceMatrices[face]);
+		SetVec3(programID, "lightPositions[" + std::to_string(lightIndex) + "]", mSceneConstant.pointLights[lightIndex].position);
+	}
+	SetFloat(programID, "farPlane", farPlane);
+
+	// all faces of all lights for every render item in one submission.
+	glBindVertexArray(mShadowVertexArray);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mShadowDrawCommands.size()), 0);
+	glBindVertexArray(0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+}
+
 void Renderer::DrawG_Buffers(RenderLayer renderLayer, uint32_t programID)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, mDeferredFramebuffer.GetFramebuffer());
+
+	// reversed-Z: zero-to-one clip depth, cleared to the far plane at 0 and tested with GL_GREATER.
+	if (mIsUsingReversedDepth)
+	{
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+		glClearDepth(0.0);
+		glDepthFunc(GL_GREATER);
+	}
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	const auto& renderItems = mAllRenderItems[renderLayer];
@@ -1058,7 +1593,7 @@ void Renderer::DrawG_Buffers(RenderLayer renderLayer, uint32_t programID)
 	SetBool(programID, "isUsingNormalMap", mMenu.isUsingNormalMap);
 
 	SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
-	SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
+	SetMat4(programID, "sceneConstant.projection", mIsUsingReversedDepth ? mSceneConstant.reversedProjection : mSceneConstant.projection);
 
 	for (auto renderItem : renderItems)
 	{
@@ -1131,5 +1666,12 @@ void Renderer::DrawG_Buffers(RenderLayer renderLayer, uint32_t programID)
 		glBindVertexArray(0);
 	}
 
+	if (mIsUsingReversedDepth)
+	{
+		glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+		glClearDepth(1.0);
+		glDepthFunc(GL_LESS);
+	}
+
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
\ No newline at end of file
@@ -1,11 +1,17 @@
 #pragma once
 #include "../../cores/BasicGeometryGenerator.h"
 #include "../../cores/Camera.h"
+#include "../../cores/CascadedShadowMap.h"
+#include "../../cores/ClusteredLighting.h"
+#include "../../cores/CpuTracer.h"
 #include "../../cores/Framebuffer.h"
+#include "../../cores/GpuProfiler.h"
 #include "../../cores/ImageBasedLight.h"
 #include "../../cores/Mesh.h"
 #include "../../cores/Model.h"
+#include "../../cores/ProgramCache.h"
 #include "../../cores/Shader.h"
+#include "../../cores/ShaderPermutation.h"
 #include "../../cores/Stdafx.h"
 #include "../../cores/Texture.h"
 #include "../../cores/Utility.h"
@@ -30,6 +36,10 @@ struct SceneConstant
 {
 	glm::mat4 view;
 	glm::mat4 projection;
+	glm::mat4 reversedProjection;
+
+	glm::mat4 invView;
+	glm::mat4 invProjection;
 
 	glm::vec3 cameraPos;
 	float pad0;
@@ -84,21 +94,27 @@ private:
 	void BuildTextures();
 	void BuildDirectionalShadowResources(uint32_t lightIndex); // textures and framebuffers
 	void BuildPointShadowResources(uint32_t lightIndex); // textures and framebuffers
+	void BuildPointShadowArrayResources(); // one cube map array for every point light and a layered framebuffer
+	void BuildPointShadowGeometry(); // shadow casters merged into one vertex and index buffer, after BuildRenderItems
 	void BuildMaterials();
 	void BuildShaders();
 	void BuildFramebuffers();
 
 	void BuildG_Buffers();
 
+	void UpdateClusteredLights();
+
 	void InitializeSceneConstant();
 
-	void LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs);
+	void LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders);
 	void UseProgram(uint32_t programID);
 
 	void BuildRenderItems();
 	void DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool isEnvironmentMap = false);
 	void DrawShadowMap(RenderLayer renderLayer, uint32_t programID, uint32_t lightIndex);
 	void DrawShadowCubeMap(RenderLayer renderLayer, uint32_t programID, uint32_t lightIndex);
+	void DrawPointShadowCubeMapArray(RenderLayer renderLayer, uint32_t programID);
+	void DrawCascadedShadowMap(RenderLayer renderLayer, uint32_t programID);
 
 	void DrawG_Buffers(RenderLayer renderLayer, uint32_t programID);
 private:
@@ -115,6 +131,8 @@ private:
 	static Renderer* renderer;
 
 	std::unordered_map<std::string, uint32_t> mProgramIDs;
+	ProgramCache mProgramCache;
+	ShaderPermutation mPBRDeferredPermutation;
 
 	Camera mCamera;
 	bool isCameraMove = false;
@@ -142,9 +160,11 @@ private:
 	std::unordered_map<RenderLayer, std::vector<RenderItem>> mAllRenderItems;
 
 	std::string mShaderDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\";
+	std::string mShaderCacheDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\cache\\";
 	std::string mTextureDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\textures\\";
 	std::string mModelDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\models\\";
 	std::string mImageDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\images\\";
+	std::string mProfileDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\profiles\\";
 
 	ImageBasedLight mImageBasedLight;
 	
@@ -153,9 +173,42 @@ private:
 	uint32_t mShadowMapWidth = 0;
 	uint32_t mShadowMapHeight = 0;
 
+	// layered point shadow resources, used when the driver can write gl_Layer from the vertex shader
+	bool mIsUsingLayeredPointShadow = false;
+	Texture mPointShadowCubeMapArray; // layer = light index * 6 + face
+	Framebuffer mPointShadowFramebuffer;
+	uint32_t mShadowFaceBuffer = 0; // visible faces per render item, read as an instanced vertex attribute
+	uint32_t mShadowDrawCommandBuffer = 0;
+	uint32_t mShadowWorldBuffer = 0; // world matrix per render item
+	uint32_t mShadowVertexArray = 0;
+	uint32_t mShadowVertexBuffer = 0;
+	uint32_t mShadowIndexBuffer = 0;
+	std::vector<uint32_t> mShadowFaces;
+	std::vector<glm::mat4> mShadowWorlds;
+	std::vector<DrawElementsIndirectCommand> mShadowDrawCommands; // one per render item, firstIndex and baseVertex into the merged buffers
+
+	// cascaded shadow map of the first directional light
+	bool mIsUsingCascadedShadow = true;
+	static constexpr uint32_t mCascadedShadowMapResolution = 2048;
+	static constexpr uint32_t mCascadeCount = 4;
+	CascadedShadowMap mCascadedShadowMap;
+
+	// per pass gpu timings shown in the Setting window
+	GpuProfiler mGpuProfiler;
+
 	// deferred rendering framebuffer
 	Framebuffer mDeferredFramebuffer;
 	std::vector<Texture> mG_Buffer; // not position map for research, only albedo map, normal map, metallic map, roughness map, ao map
+	bool mIsUsingPackedG_Buffer = true; // albedo + ao (RGBA8), octahedral normal (RG16), metallic + roughness (RG8)
+	bool mIsUsingReversedDepth = true; // reversed-Z float depth, standard depth without glClipControl
+	Texture mG_BufferDepthMap;
+
+	// clustered lighting resources
+	static constexpr uint32_t mMaxClusteredLightCount = 4096;
+	ClusteredLighting mClusteredLighting;
+	std::vector<PointLight> mClusteredPointLights;
+	std::vector<SpotLight> mClusteredSpotLights;
+	int mExtraClusteredLightCount = 0; // animated lights added on top of the scene point lights
 
 	// mouse variables
 	float mLastMousePosX = 0.0f;
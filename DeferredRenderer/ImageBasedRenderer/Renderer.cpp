@@ -2,7 +2,6 @@
 
 Renderer* Renderer::renderer = nullptr;
 const float Renderer::mRadius = 2.6f;
-const float Renderer::mDegreeDelta = 45.0f;
 
 void _FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
@@ -38,8 +37,18 @@ Renderer::Renderer()
 }
 Renderer::~Renderer()
 {
+	renderer = nullptr;
+
+	mImageWriter.DeleteImageWriter();
+
+	// offline tools and failed initialization never had a context to release.
+	if (!mIsContextCreated)
+		return;
+
 	for (auto& imageBasedLight: mImageBasedLights)
 		imageBasedLight.DeleteResources();
+	mTransientResourcePool.DeleteTransientResourcePool();
+	mBrdfLookUpTable.DeleteBrdfLookUpTable();
 
 	for (auto& framebuffer : mFramebuffers)
 		framebuffer.second.DeleteFramebuffer();
@@ -50,7 +59,17 @@ Renderer::~Renderer()
 	 for (auto& texture : mBasicTextures)
 		 texture.second.DeleteTexture();
 
-	renderer = nullptr;
+	std::filesystem::create_directories(mProfileDirectoryName);
+	ExportCpuTraceToJSON(mProfileDirectoryName + "cpu_trace.json");
+
+	mSceneRenderTarget.DeleteRenderTarget();
+	glDeleteBuffers(1, &mG_BufferPixelBuffer);
+
+	if (mIsHeadless)
+	{
+		mHeadlessContext.DeleteHeadlessContext();
+		return;
+	}
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -60,35 +79,77 @@ Renderer::~Renderer()
 	glfwTerminate();
 }
 
-void Renderer::Initialize()
+void Renderer::SetHeadlessBackend(HeadlessBackend backend)
 {
-	if (!InitializeWindow())
-	{
-		std::cerr << "Window creation failed!" << std::endl;
-		return;
-	}
+	mHeadlessBackend = backend;
+	mIsHeadless = backend != HeadlessBackend::None;
+}
+void Renderer::SetRenderTargetSize(uint32_t width, uint32_t height, uint32_t sampleCount)
+{
+	mRenderWidth = width;
+	mRenderHeight = height;
+	mRenderSampleCount = sampleCount;
+}
 
-	// Initialize imgui
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
+void Renderer::SetAnalyticBRDF(bool isUsingAnalyticBRDF)
+{
+	mIsUsingAnalyticBRDF = isUsingAnalyticBRDF;
+}
 
-	const char* glsl_version = "#version 430";
-	ImGui_ImplGlfw_InitForOpenGL(mWindow, true);
-	ImGui_ImplOpenGL3_Init(glsl_version);
+void Renderer::SetOutputFormat(const std::string& formatName, uint32_t threadCount)
+{
+	mOutputFormatName = formatName;
+	mOutputThreadCount = threadCount;
+}
 
-	ImGui::StyleColorsDark();
+void Renderer::SetSweepManifest(const std::string& manifestFileName)
+{
+	mSweepManifestFileName = manifestFileName;
+}
+void Renderer::SetSweepShard(uint32_t shardIndex, uint32_t shardCount, bool isSkippingCompleted)
+{
+	mShardIndex = shardIndex;
+	mShardCount = shardCount;
+	mIsSkippingCompletedWork = isSkippingCompleted;
+}
 
-	// Configure model directory name;
-	std::filesystem::path datasetDirectory(mDatasetDirectoryName);
-	for (const auto& entry : std::filesystem::directory_iterator(datasetDirectory))
+bool Renderer::Initialize()
+{
+	if (!BuildSweep())
 	{
-		if (std::filesystem::is_directory(entry))
+		std::cerr << "Sweep setup failed!" << std::endl;
+		return false;
+	}
+
+	if (mIsHeadless)
+	{
+		if (!InitializeHeadlessContext())
 		{
-			const auto& filename = entry.path().filename().string();
-			if (filename.ends_with(".glb")) // ends_with function is enabled only since C++20.
-				mModelDirectoryNames.push_back(filename);
+			std::cerr << "Headless context creation failed!" << std::endl;
+			return false;
 		}
 	}
+	else
+	{
+		if (!InitializeWindow())
+		{
+			std::cerr << "Window creation failed!" << std::endl;
+			return false;
+		}
+
+		// Initialize imgui
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+
+		const char* glsl_version = "#version 430";
+		ImGui_ImplGlfw_InitForOpenGL(mWindow, true);
+		ImGui_ImplOpenGL3_Init(glsl_version);
+
+		ImGui::StyleColorsDark();
+	}
+	mIsContextCreated = true;
+
+	mImageWriter.Initialize(mOutputFormat, mOutputThreadCount);
 
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
@@ -123,14 +184,69 @@ void Renderer::Initialize()
 	BuildImageBasedLightsAndDraw();
 
 	BuildRenderItems();
+
+	return true;
+}
+
+bool Renderer::BuildSweep()
+{
+	if (!mSweepManifestFileName.empty() && !mSweepScheduler.LoadManifest(mSweepManifestFileName, mSweepManifest))
+		return false;
+
+	// entries the manifest leaves out fall back to the dataset directory and the default hdrs.
+	if (mSweepManifest.datasetDirectoryName.empty())
+		mSweepManifest.datasetDirectoryName = mDatasetDirectoryName;
+
+	if (mSweepManifest.modelNames.empty())
+	{
+		std::filesystem::path datasetDirectory(mSweepManifest.datasetDirectoryName);
+		for (const auto& entry : std::filesystem::directory_iterator(datasetDirectory))
+		{
+			if (std::filesystem::is_directory(entry))
+			{
+				const auto& filename = entry.path().filename().string();
+				if (filename.ends_with(".glb")) // ends_with function is enabled only since C++20.
+					mSweepManifest.modelNames.push_back(filename);
+			}
+		}
+		// directory order is unspecified, sort so every shard enumerates the same units.
+		std::sort(mSweepManifest.modelNames.begin(), mSweepManifest.modelNames.end());
+	}
+
+	// the command line overrides the format of the manifest.
+	if (!mOutputFormatName.empty())
+		mSweepManifest.outputFormat = mOutputFormatName;
+	if (!ParseImageFileFormat(mSweepManifest.outputFormat, mOutputFormat))
+	{
+		std::cout << "ERROR::SWEEP_MANIFEST:: Unknown output format: " << mSweepManifest.outputFormat << std::endl;
+		return false;
+	}
+
+	if (mSweepManifest.hdrNames.empty())
+	{
+		mSweepManifest.hdrNames = {
+			"blue_photo_studio",
+			"dancing_hall",
+			"office",
+			"pine_attic",
+			"studio_small_03",
+			"thatch_chapel"
+		};
+	}
+
+	if (!mSweepScheduler.BuildWorkUnits(mSweepManifest, mShardIndex, mShardCount, mIsSkippingCompletedWork))
+		return false;
+	std::cout << "Sweep shard " << mShardIndex << "/" << mShardCount << ": " << mSweepScheduler.GetWorkUnitCount()
+		<< " images to render, " << mSweepScheduler.GetSkippedWorkUnitCount() << " already rendered" << std::endl;
+	return true;
 }
 
 void Renderer::RenderLoop()
 {
-	uint32_t modelIndex = 0;
-	ImageBasedLight currentImageBasedLight;
-	std::string imageDirectoryName = mDatasetDirectoryName + "\\" + mModelDirectoryNames[modelIndex];
-	std::string currentImageFileName = " ";
+	// nothing left for this shard.
+	SweepWorkUnit workUnit;
+	if (!mSweepScheduler.GetNextWorkUnit(workUnit))
+		return;
 
 	auto& PBRDeferredRenderItems = mAllRenderItems[RenderLayer::PBR_Deferred];
 	auto& environmentRenderItems = mAllRenderItems[RenderLayer::Environment];
@@ -138,59 +254,61 @@ void Renderer::RenderLoop()
 	auto& quadRenderItem = PBRDeferredRenderItems[0];
 	auto& environmentRenderItem = environmentRenderItems[0];
 
-	while (!glfwWindowShouldClose(mWindow))
+	while (mIsHeadless || !glfwWindowShouldClose(mWindow))
 	{
-		float currentFrame = static_cast<float>(glfwGetTime());
+		TRACE_CPU_ZONE("Frame");
+
+		float currentFrame = mIsHeadless ? 0.0f : static_cast<float>(glfwGetTime());
 		mDeltaTime = currentFrame - mLastFrame;
 		mLastFrame = currentFrame;
 
-		// Load albedo, normal, metallic, roughness, ao maps.
-		LoadG_Buffers(imageDirectoryName, mTheta, mPhi);
+		mTheta = workUnit.theta;
+		mPhi = workUnit.phi;
+
+		// Load albedo, normal, metallic, roughness, ao maps, once per view since the hdrs of a view are consecutive.
+		std::string imageDirectoryName = mSweepManifest.datasetDirectoryName + "\\" + mSweepManifest.modelNames[workUnit.modelIndex];
+		if (mSweepScheduler.IsNewView(workUnit))
+			LoadG_Buffers(imageDirectoryName, mTheta, mPhi);
 
-		currentImageBasedLight = mImageBasedLights[mImageBasedLightIndex];
+		ImageBasedLight& currentImageBasedLight = mImageBasedLights[workUnit.hdrIndex];
 		quadRenderItem.irradianceMap = currentImageBasedLight.GetIrradianceMap();
 		quadRenderItem.prefilterMap = currentImageBasedLight.GetPreFilteredEnvironmentMap();
-		quadRenderItem.brdfLUT = currentImageBasedLight.GetBRDFLookUpTable();
+		if (!mIsUsingAnalyticBRDF)
+			quadRenderItem.brdfLUT = currentImageBasedLight.GetBRDFLookUpTable();
 		environmentRenderItem.environmentMap = currentImageBasedLight.GetCubeMap();
 
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
-		ImGui::NewFrame();
+		if (!mIsHeadless)
+		{
+			ImGui_ImplOpenGL3_NewFrame();
+			ImGui_ImplGlfw_NewFrame();
+			ImGui::NewFrame();
 
-		ProcessKeyboardInput();
+			ProcessKeyboardInput();
+		}
 		UpdateData();
 		DrawScene();
 
-		currentImageFileName = "HDR" + std::to_string(mImageBasedLightIndex + 1) + "_IBL_IBR_"
-			+ std::to_string(static_cast<uint32_t>(mTheta)) + "_" + std::to_string(static_cast<uint32_t>(mPhi)) + ".png";
-		SaveScreenshotToPNG(imageDirectoryName + "\\" + currentImageFileName, mWindowWidth, mWindowHeight);
+		// read back here, encoded and written by the image writer while the next units render.
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneRenderTarget.GetResolveFramebuffer());
+		mImageWriter.SaveFramebuffer(workUnit.outputFileName, mRenderWidth, mRenderHeight);
+
+		std::cout << "Save Queued (" << mSweepScheduler.GetCompletedWorkUnitCount() << "/" << mSweepScheduler.GetWorkUnitCount() << ") "
+			<< workUnit.outputFileName << std::endl;
 
-		std::cout << "Save Completed " << mModelDirectoryNames[modelIndex] << "\\" << currentImageFileName << std::endl;
+		if (!mSweepScheduler.GetNextWorkUnit(workUnit))
+			break;
 
-		mImageBasedLightIndex++;
-		if (mImageBasedLightIndex == mNumImageBasedLights)
+		// headless frames are never presented, so the sweep is not paced by vsync.
+		if (!mIsHeadless)
 		{
-			mImageBasedLightIndex = 0;
-			mPhi += mDegreeDelta;
-			if (mPhi == 360.0f)
-			{
-				mTheta += mDegreeDelta;
-				mPhi = 0.0f;
-				if (mTheta == 225.0f)
-				{
-					modelIndex++;
-					if (modelIndex == static_cast<uint32_t>(mModelDirectoryNames.size()))
-						break;
-
-					imageDirectoryName = mDatasetDirectoryName + "\\" + mModelDirectoryNames[modelIndex];
-					mTheta = 0.0f;
-				}
-			}
+			glfwSwapBuffers(mWindow);
+			glfwPollEvents();
 		}
-
-		glfwSwapBuffers(mWindow);
-		glfwPollEvents();
 	}
+
+	mImageWriter.Flush();
+	if (mImageWriter.GetFailedImageCount() > 0)
+		std::cout << "Failed to write " << mImageWriter.GetFailedImageCount() << " images" << std::endl;
 }
 
 void Renderer::FramebufferSizeCallback(GLFWwindow* window, int width, int height)
@@ -244,7 +362,7 @@ bool Renderer::InitializeWindow()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	// glfwWindowHint(GLFW_SAMPLES, 4); 
-	glfwWindowHint(GLFW_SAMPLES, 9); // -> for antialiasing
+	glfwWindowHint(GLFW_SAMPLES, 0); // antialiasing is done in mSceneRenderTarget
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef _APPLE_
@@ -273,6 +391,11 @@ bool Renderer::InitializeWindow()
 
 	return true;
 }
+bool Renderer::InitializeHeadlessContext()
+{
+	// there is no default framebuffer, everything is drawn into mSceneRenderTarget.
+	return mHeadlessContext.CreateHeadlessContext(mHeadlessBackend, mRenderWidth, mRenderHeight);
+}
 
 void Renderer::ProcessKeyboardInput()
 {
@@ -296,7 +419,10 @@ void Renderer::ProcessKeyboardInput()
 			mCamera.Strafe(10.0f * dt);
 
 		if (glfwGetKey(mWindow, GLFW_KEY_I) == GLFW_PRESS)
-			SaveScreenshotToPNG(mImageDirectoryName + "image.png", mWindowWidth, mWindowHeight);
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneRenderTarget.GetResolveFramebuffer());
+			SaveScreenshotToPNG(mImageDirectoryName + "image.png", mRenderWidth, mRenderHeight);
+		}
 	}	
 }
 void Renderer::UpdateData()
@@ -305,18 +431,19 @@ void Renderer::UpdateData()
 }
 void Renderer::DrawScene()
 {
+	TRACE_CPU_ZONE("DrawScene");
+
 	// for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.directionalLightCount; lightIndex++)
 	//	DrawShadowMap(RenderLayer::Shadow, mProgramIDs["shadow"], lightIndex);
 
 	// for (uint32_t lightIndex = 0; lightIndex < mSceneConstant.pointLightCount; lightIndex++)
 	// 	DrawShadowCubeMap(RenderLayer::Shadow, mProgramIDs["pointShadow"], lightIndex);
 
-	int windowWidth, windowHeight;
-	glfwGetFramebufferSize(mWindow, &windowWidth, &windowHeight);
-	glViewport(0, 0, windowWidth, windowHeight);
+	mSceneRenderTarget.Bind();
 
 	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glStencilMask(0xFF);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
@@ -324,9 +451,39 @@ void Renderer::DrawScene()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_MULTISAMPLE);
 
-	DrawRenderItems(RenderLayer::PBR_Deferred, mProgramIDs["pbr_deferred"]);
+	// the mask marks the object pixels in the stencil first, so the IBL pass only shades those
+	// and the background costs one albedo fetch per pixel.
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_ALWAYS, 1, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	DrawG_BufferQuad(mProgramIDs["gBufferMask"]);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+
+	glStencilMask(0x00);
+	glStencilFunc(GL_EQUAL, 1, 0xFF);
+	DrawRenderItems(RenderLayer::PBR_Deferred, mPBRDeferredPermutation.GetProgram(GetShaderFeatureMask(mMenu)));
+
+	glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+	DrawG_BufferQuad(mProgramIDs["deferredBackground"]);
+
+	glStencilMask(0xFF);
+	glDisable(GL_STENCIL_TEST);
 	// DrawRenderItems(RenderLayer::Environment, mProgramIDs["cubeMapHDR"], mMenu.enableEnvironment);
 
+	mSceneRenderTarget.Resolve();
+	if (mIsHeadless)
+		return;
+
+	// show the resolved image scaled to the window, imgui draws on top of it.
+	int windowWidth, windowHeight;
+	glfwGetFramebufferSize(mWindow, &windowWidth, &windowHeight);
+	mSceneRenderTarget.BlitToFramebuffer(0, windowWidth, windowHeight);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+
 	if (mShowImGuiWindow)
 	{
 		ImGui::Begin("Setting");   
@@ -356,6 +513,8 @@ void Renderer::DrawScene()
 
 void Renderer::UpdateSceneConstants()
 {
+	TRACE_CPU_ZONE("UpdateSceneConstants");
+
 	// mSceneConstant.view = mCamera.GetView();
 	// mSceneConstant.projection = mCamera.GetProjection();
 
@@ -445,148 +604,313 @@ void Renderer::BuildMaterials()
 }
 void Renderer::BuildShaders()
 {
-	std::vector<uint32_t> shaderIDs;
-
-	// image-based renderer shader
-	Shader pbrDeferredVertexShader;
-	Shader pbrDeferredFragmentShader;
-	pbrDeferredVertexShader.CompileShader(mShaderDirectoryName + "pbr_deferred.vert", GL_VERTEX_SHADER);
-	pbrDeferredFragmentShader.CompileShader(mShaderDirectoryName + "pbr_deferred.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(pbrDeferredVertexShader.GetShaderID());
-	shaderIDs.push_back(pbrDeferredFragmentShader.GetShaderID());
-	LinkPrograms("pbr_deferred", shaderIDs);
-	shaderIDs.clear();
+	TRACE_CPU_ZONE("BuildShaders");
+
+	mProgramCache.Initialize(mShaderCacheDirectoryName,
+		mIsHeadless ? mHeadlessContext.GetProcAddressLoader() : (GLADloadproc)glfwGetProcAddress);
+
+	std::vector<Shader*> shaders;
+
+	// image-based renderer shader, specialized per feature mask on first use
+	std::vector<std::string> pbrDeferredDefines;
+	if (mIsUsingAnalyticBRDF)
+		pbrDeferredDefines.push_back("USE_ANALYTIC_BRDF");
+	pbrDeferredDefines.push_back("USE_MASK_STENCIL");
+	// hdr outputs keep the linear radiance, tonemapping and gamma are left to whoever reads them.
+	std::vector<std::string> outputDefines;
+	if (IsHDRImageFileFormat(mOutputFormat))
+		outputDefines.push_back("OUTPUT_LINEAR_HDR");
+	pbrDeferredDefines.insert(pbrDeferredDefines.end(), outputDefines.begin(), outputDefines.end());
+	mPBRDeferredPermutation.Initialize(&mProgramCache, "pbr_deferred",
+		mShaderDirectoryName + "pbr_deferred.vert", mShaderDirectoryName + "pbr_deferred.frag", pbrDeferredDefines);
 
 	// environment shader
 	Shader cubeMapVertexShader;
 	Shader cubeMapFragmentShader;
-	cubeMapVertexShader.CompileShader(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
-	cubeMapFragmentShader.CompileShader(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(cubeMapFragmentShader.GetShaderID());
-	LinkPrograms("cubeMapHDR", shaderIDs);
-	shaderIDs.clear();
+	cubeMapVertexShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
+	cubeMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER, outputDefines);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&cubeMapFragmentShader);
+	LinkPrograms("cubeMapHDR", shaders);
+	shaders.clear();
+
+	// mask to stencil and the unlit background around the object
+	Shader quadVertexShader;
+	Shader gBufferMaskFragmentShader;
+	Shader deferredBackgroundFragmentShader;
+	quadVertexShader.LoadShaderCode(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
+	gBufferMaskFragmentShader.LoadShaderCode(mShaderDirectoryName + "gBufferMask.frag", GL_FRAGMENT_SHADER);
+	deferredBackgroundFragmentShader.LoadShaderCode(mShaderDirectoryName + "gBufferMask.frag", GL_FRAGMENT_SHADER, { "WRITE_BACKGROUND" });
+	shaders.push_back(&quadVertexShader);
+	shaders.push_back(&gBufferMaskFragmentShader);
+	LinkPrograms("gBufferMask", shaders);
+	shaders.clear();
+	shaders.push_back(&quadVertexShader);
+	shaders.push_back(&deferredBackgroundFragmentShader);
+	LinkPrograms("deferredBackground", shaders);
+	shaders.clear();
 
 	//image-based light shader (from equiToCube to brdf)
+	// cube maps are captured in one instanced draw per level when the vertex shader can write gl_Layer.
+	std::string captureVertexShaderName = "equirectangularToCube.vert";
+	std::vector<std::string> captureDefines;
+	if (IsExtensionSupported("GL_ARB_shader_viewport_layer_array"))
+	{
+		captureVertexShaderName = "equirectangularToCubeLayered.vert";
+		captureDefines.push_back("USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY");
+	}
+	else if (IsExtensionSupported("GL_AMD_vertex_shader_layer"))
+		captureVertexShaderName = "equirectangularToCubeLayered.vert";
+
 	Shader equirectangularToCubeVertexShader;
 	Shader equirectangularToCubeFragmentShader;
-	equirectangularToCubeVertexShader.CompileShader(mShaderDirectoryName + "equirectangularToCube.vert", GL_VERTEX_SHADER);
-	equirectangularToCubeFragmentShader.CompileShader(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(equirectangularToCubeVertexShader.GetShaderID());
-	shaderIDs.push_back(equirectangularToCubeFragmentShader.GetShaderID());
- 	LinkPrograms("equirectangularToCube", shaderIDs);
-	shaderIDs.clear();
+	equirectangularToCubeVertexShader.LoadShaderCode(mShaderDirectoryName + captureVertexShaderName, GL_VERTEX_SHADER, captureDefines);
+	equirectangularToCubeFragmentShader.LoadShaderCode(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&equirectangularToCubeVertexShader);
+	shaders.push_back(&equirectangularToCubeFragmentShader);
+ 	LinkPrograms("equirectangularToCube", shaders);
+	shaders.clear();
 
 	Shader irradianceMapFragmentShader;
-	irradianceMapFragmentShader.CompileShader(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(equirectangularToCubeVertexShader.GetShaderID());
-	shaderIDs.push_back(irradianceMapFragmentShader.GetShaderID());
-	LinkPrograms("irradianceMap", shaderIDs);
-	shaderIDs.clear();
-
-	Shader prefilterMapFragmentShader;
-	prefilterMapFragmentShader.CompileShader(mShaderDirectoryName + "prefilterMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(equirectangularToCubeVertexShader.GetShaderID());
-	shaderIDs.push_back(prefilterMapFragmentShader.GetShaderID());
-	LinkPrograms("prefilterMap", shaderIDs);
-	shaderIDs.clear();
+	irradianceMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&equirectangularToCubeVertexShader);
+	shaders.push_back(&irradianceMapFragmentShader);
+	LinkPrograms("irradianceMap", shaders);
+	shaders.clear();
+
+	// all roughness mips and faces are prefiltered in one compute dispatch.
+	Shader prefilterMapComputeShader;
+	prefilterMapComputeShader.LoadShaderCode(mShaderDirectoryName + "prefilterMap.comp", GL_COMPUTE_SHADER);
+	shaders.push_back(&prefilterMapComputeShader);
+	LinkPrograms("prefilterMap", shaders);
+	shaders.clear();
 
 	Shader brdfVertexShader;
 	Shader brdfFragmentShader;
-	brdfVertexShader.CompileShader(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
-	brdfFragmentShader.CompileShader(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(brdfVertexShader.GetShaderID());
-	shaderIDs.push_back(brdfFragmentShader.GetShaderID());
-	LinkPrograms("brdf", shaderIDs);
-	shaderIDs.clear();
+	brdfVertexShader.LoadShaderCode(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
+	brdfFragmentShader.LoadShaderCode(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&brdfVertexShader);
+	shaders.push_back(&brdfFragmentShader);
+	LinkPrograms("brdf", shaders);
+	shaders.clear();
 
 	// shadow shader
 	// Shader shadowVertexShader;
 	// Shader shadowFragmentShader;
-	// shadowVertexShader.CompileShader(mShaderDirectoryName + "shadow.vert", GL_VERTEX_SHADER);
-	// shadowFragmentShader.CompileShader(mShaderDirectoryName + "shadow.frag", GL_FRAGMENT_SHADER);
-	// shaderIDs.push_back(shadowVertexShader.GetShaderID());
-	// shaderIDs.push_back(shadowFragmentShader.GetShaderID());
-	// LinkPrograms("shadow", shaderIDs);
-	// shaderIDs.clear();
+	// shadowVertexShader.LoadShaderCode(mShaderDirectoryName + "shadow.vert", GL_VERTEX_SHADER);
+	// shadowFragmentShader.LoadShaderCode(mShaderDirectoryName + "shadow.frag", GL_FRAGMENT_SHADER);
+	// shaders.push_back(&shadowVertexShader);
+	// shaders.push_back(&shadowFragmentShader);
+	// LinkPrograms("shadow", shaders);
+	// shaders.clear();
 
 	// Shader pointShadowVertexShader;
 	// Shader pointShadowGeometryShader;
 	// Shader pointShadowFragmentShader;
-	// pointShadowVertexShader.CompileShader(mShaderDirectoryName + "pointShadow.vert", GL_VERTEX_SHADER);
-	// pointShadowGeometryShader.CompileShader(mShaderDirectoryName + "pointShadow.geom", GL_GEOMETRY_SHADER);
-	// pointShadowFragmentShader.CompileShader(mShaderDirectoryName + "pointShadow.frag", GL_FRAGMENT_SHADER);
-	// shaderIDs.push_back(pointShadowVertexShader.GetShaderID());
-	// shaderIDs.push_back(pointShadowGeometryShader.GetShaderID());
-	// shaderIDs.push_back(pointShadowFragmentShader.GetShaderID());
-	// LinkPrograms("pointShadow", shaderIDs);
-	// shaderIDs.clear();
+	// pointShadowVertexShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.vert", GL_VERTEX_SHADER);
+	// pointShadowGeometryShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.geom", GL_GEOMETRY_SHADER);
+	// pointShadowFragmentShader.LoadShaderCode(mShaderDirectoryName + "pointShadow.frag", GL_FRAGMENT_SHADER);
+	// shaders.push_back(&pointShadowVertexShader);
+	// shaders.push_back(&pointShadowGeometryShader);
+	// shaders.push_back(&pointShadowFragmentShader);
+	// LinkPrograms("pointShadow", shaders);
+	// shaders.clear();
+
+	mProgramCache.BuildPrograms(mProgramIDs);
 }
 
 void Renderer::BuildFramebuffers()
 {
 	// mShadowMapFramebuffer.CreateFramebuffer(mShadowMapWidth, mShadowMapHeight, 0, false, true);
+
+	RenderTargetInfo sceneRenderTargetInfo;
+	sceneRenderTargetInfo.width = mRenderWidth;
+	sceneRenderTargetInfo.height = mRenderHeight;
+	sceneRenderTargetInfo.sampleCount = mRenderSampleCount;
+	sceneRenderTargetInfo.colorInternalFormat = IsHDRImageFileFormat(mOutputFormat) ? GL_RGBA16F : GL_RGBA8;
+	sceneRenderTargetInfo.isStencilAttachment = true; // object pixels of the mask
+	mSceneRenderTarget.CreateRenderTarget(sceneRenderTargetInfo);
 }
 
 void Renderer::BuildG_Buffers()
 {
+	TRACE_CPU_ZONE("BuildG_Buffers");
+
+	// allocate sized 8-bit formats matching the png data instead of 12-byte RGB32F texels for scalar maps.
 	Texture albedoMap;
-	albedoMap.CreateTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB);
+	albedoMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+		false, true, mRenderWidth, mRenderHeight, GL_RGBA8, GL_RGBA);
 	mG_Buffer.insert({ "albedoMap", std::move(albedoMap) });
 
 	Texture normalMap;
 	normalMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_RGB8, GL_RGB);
 	mG_Buffer.insert({ "normalMap", std::move(normalMap) });
 
 	Texture metallicMap;
 	metallicMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_R8, GL_RED);
 	mG_Buffer.insert({ "metallicMap", std::move(metallicMap) });
 
 	Texture roughnessMap;
 	roughnessMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_R8, GL_RED);
 	mG_Buffer.insert({ "roughnessMap", std::move(roughnessMap) });
 
 	Texture metallicRoughnessMap;
 	metallicRoughnessMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_RGB8, GL_RGB);
 	mG_Buffer.insert({ "metallicRoughnessMap", std::move(metallicRoughnessMap) });
 
 	Texture aoMap;
 	aoMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_R8, GL_RED);
 	mG_Buffer.insert({ "aoMap", std::move(aoMap) });
 
 	Texture maskMap;
-	maskMap.CreateTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB);
+	maskMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+		false, true, mRenderWidth, mRenderHeight, GL_R8, GL_RED);
 	mG_Buffer.insert({ "maskMap", std::move(maskMap) });
 
 	Texture depthMap;
-	depthMap.CreateTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB);
+	depthMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
+		false, true, mRenderWidth, mRenderHeight, GL_R8, GL_RED);
 	mG_Buffer.insert({ "depthMap", std::move(depthMap) });
 
 	Texture viewMap;
 	viewMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST,
-		false, true, mWindowWidth, mWindowHeight, GL_RGB32F, GL_RGB);
+		false, true, mRenderWidth, mRenderHeight, GL_RGB8, GL_RGB);
 	mG_Buffer.insert({ "viewMap", std::move(viewMap) });
 }
 
 void Renderer::LoadG_Buffers(const std::string& directoryName, float degree0, float degree1)
 {
+	TRACE_CPU_ZONE("LoadG_Buffers");
+
+	// a packed archive replaces the separate pngs of the model, it is opened once per model.
+	std::string archiveFileName = directoryName + "\\" + mG_BufferArchiveFileName;
+	if (archiveFileName != mOpenG_BufferArchiveFileName)
+	{
+		mG_BufferArchive.CloseGBufferArchive();
+		mOpenG_BufferArchiveFileName = archiveFileName;
+		if (std::filesystem::exists(archiveFileName))
+			mG_BufferArchive.OpenGBufferArchive(archiveFileName);
+	}
+	// the archive only holds 8-bit maps, half-float normal, depth and view maps of the view take precedence over it.
+	bool hasFloatG_Buffers = false;
+	for (const char* textureName : { "Normal", "Depth", "view" })
+	{
+		std::string textureFileName = directoryName + "\\" + textureName + "_" + std::to_string(static_cast<uint32_t>(degree0)) + "_" + std::to_string(static_cast<uint32_t>(degree1));
+		if (std::filesystem::exists(textureFileName + ".exr") || std::filesystem::exists(textureFileName + ".hdr"))
+			hasFloatG_Buffers = true;
+	}
+	if (!hasFloatG_Buffers && mG_BufferArchive.IsOpen())
+	{
+		int32_t viewIndex = mG_BufferArchive.FindView(degree0, degree1);
+		if (viewIndex >= 0)
+		{
+			LoadG_BuffersFromArchive(static_cast<uint32_t>(viewIndex));
+			return;
+		}
+	}
+
 	LoadTexture("albedo", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
-	LoadTexture("normal", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
+	LoadTexture("normal", GL_HALF_FLOAT, directoryName, degree0, degree1);
 	LoadTexture("metallic", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
 	LoadTexture("roughness", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
 	LoadTexture("metallicRoughness", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
 	LoadTexture("ao", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
 	LoadTexture("mask", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
-	LoadTexture("depth", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
-	LoadTexture("view", GL_UNSIGNED_BYTE, directoryName, degree0, degree1);
+	LoadTexture("depth", GL_HALF_FLOAT, directoryName, degree0, degree1);
+	LoadTexture("view", GL_HALF_FLOAT, directoryName, degree0, degree1);
+}
+void Renderer::LoadG_BuffersFromArchive(uint32_t viewIndex)
+{
+	// every map of the view is decoded in parallel into one mapped pixel buffer, then uploaded from it.
+	std::vector<size_t> mapOffsets(mG_BufferArchive.GetMapCount());
+	size_t pixelBufferSize = 0;
+	for (uint32_t map = 0; map < mG_BufferArchive.GetMapCount(); map++)
+	{
+		mapOffsets[map] = pixelBufferSize;
+		pixelBufferSize += mG_BufferArchive.GetMapSize(map);
+	}
+
+	if (mG_BufferPixelBuffer == 0)
+		glGenBuffers(1, &mG_BufferPixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mG_BufferPixelBuffer);
+	if (pixelBufferSize > mG_BufferPixelBufferSize)
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, pixelBufferSize, nullptr, GL_STREAM_DRAW);
+		mG_BufferPixelBufferSize = pixelBufferSize;
+	}
+
+	uint8_t* pixels = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pixelBufferSize,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	std::vector<uint8_t*> mapDestinations(mG_BufferArchive.GetMapCount(), nullptr);
+	for (uint32_t map = 0; map < mG_BufferArchive.GetMapCount(); map++)
+	{
+		// maps the renderer has no texture for are not decoded.
+		if (pixels != nullptr && mG_Buffer.count(mG_BufferArchive.GetMapInfo(map).name + "Map") != 0)
+			mapDestinations[map] = pixels + mapOffsets[map];
+	}
+	bool isDecoded = pixels != nullptr && mG_BufferArchive.DecodeView(viewIndex, mapDestinations);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	if (isDecoded)
+	{
+		uint32_t width = mG_BufferArchive.GetWidth();
+		uint32_t height = mG_BufferArchive.GetHeight();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (uint32_t map = 0; map < mG_BufferArchive.GetMapCount(); map++)
+		{
+			if (mapDestinations[map] == nullptr)
+				continue;
+
+			GLenum internalFormat = GL_RGB8, format = GL_RGB;
+			if (mG_BufferArchive.GetMapInfo(map).channelCount == 1)
+			{
+				internalFormat = GL_R8;
+				format = GL_RED;
+			}
+			else if (mG_BufferArchive.GetMapInfo(map).channelCount == 4)
+			{
+				internalFormat = GL_RGBA8;
+				format = GL_RGBA;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, mG_Buffer[mG_BufferArchive.GetMapInfo(map).name + "Map"].GetTexture());
+			int storageWidth = 0, storageHeight = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &storageWidth);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &storageHeight);
+
+			// the pointer is an offset into the bound pixel buffer.
+			const void* offset = reinterpret_cast<const void*>(mapOffsets[map]);
+			if (static_cast<uint32_t>(storageWidth) == width && static_cast<uint32_t>(storageHeight) == height)
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, offset);
+			else
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, offset);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	else
+		std::cout << "Failed to decode G-buffer view " << viewIndex << " of " << mOpenG_BufferArchiveFileName << std::endl;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+bool Renderer::PackG_BufferArchives()
+{
+	if (!BuildSweep())
+		return false;
+
+	bool isPacked = true;
+	for (const auto& modelName : mSweepManifest.modelNames)
+	{
+		std::string directoryName = mSweepManifest.datasetDirectoryName + "\\" + modelName;
+		if (!GBufferArchive::ConvertFromPNG(directoryName, mG_BufferMaps, directoryName + "\\" + mG_BufferArchiveFileName))
+			isPacked = false;
+	}
+	return isPacked;
 }
 void Renderer::LoadTexture(std::string textureName, GLenum textureType, const std::string& directoryName, float degree0, float degree1)
 {
@@ -597,6 +921,18 @@ void Renderer::LoadTexture(std::string textureName, GLenum textureType, const st
 
 	glBindTexture(GL_TEXTURE_2D, mG_Buffer[textureName + "Map"].GetTexture());
 
+	// channel count of the storage allocated in BuildG_Buffers.
+	int channelCount = 3;
+	if (textureName == "albedo")
+		channelCount = 4;
+	else if (textureName == "metallic" || textureName == "roughness" || textureName == "ao" ||
+		textureName == "mask" || textureName == "depth")
+		channelCount = 1;
+
+	int storageWidth = 0, storageHeight = 0;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &storageWidth);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &storageHeight);
+
 	if (textureName == "ao")
 		textureName = "AO";
 	else if (textureName == "metallicRoughness")
@@ -607,26 +943,45 @@ void Renderer::LoadTexture(std::string textureName, GLenum textureType, const st
 		textureName[0] = std::toupper(textureName[0]);
 
 	textureFileName = directoryName + "\\" + textureName + "_" + std::to_string(static_cast<uint32_t>(degree0)) + "_" + std::to_string(static_cast<uint32_t>(degree1));
-	textureFileName += ".png";
-	// if (textureName == "Albedo" || textureName == "Mask" || textureName == "Depth")
-	// 	textureFileName += ".png";
-	// else
-	// 	textureFileName += ".hdr";
+
+	// float maps come from an exr or hdr next to the png when there is one, otherwise from the png.
+	if (textureType == GL_HALF_FLOAT)
+	{
+		if (std::filesystem::exists(textureFileName + ".exr"))
+			textureFileName += ".exr";
+		else if (std::filesystem::exists(textureFileName + ".hdr"))
+			textureFileName += ".hdr";
+		else
+			textureType = GL_UNSIGNED_BYTE;
+	}
+	if (textureType == GL_UNSIGNED_BYTE)
+		textureFileName += ".png";
 
 	if (textureType == GL_UNSIGNED_BYTE)
 	{
-		unsigned char* data = stbi_load(textureFileName.c_str(), &_width, &_height, &_nrChannels, 0);
+		// expand or drop channels on load so the data always matches the allocated storage.
+		unsigned char* data = stbi_load(textureFileName.c_str(), &_width, &_height, &_nrChannels, channelCount);
 		if (data)
 		{
-			GLenum format = GL_RGB;
-			if (_nrChannels == 1)
+			GLenum internalFormat = GL_RGB8, format = GL_RGB;
+			if (channelCount == 1)
+			{
+				internalFormat = GL_R8;
 				format = GL_RED;
-			else if (_nrChannels == 3)
-				format = GL_RGB;
-			else if (_nrChannels == 4)
+			}
+			else if (channelCount == 4)
+			{
+				internalFormat = GL_RGBA8;
 				format = GL_RGBA;
+			}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, format, _width, _height, 0, format, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			// reuse the existing storage, only reallocate when the image size differs.
+			if (_width == storageWidth && _height == storageHeight)
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, format, GL_UNSIGNED_BYTE, data);
+			else
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, _width, _height, 0, format, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 			stbi_image_free(data);
 		}
 		else
@@ -635,36 +990,38 @@ void Renderer::LoadTexture(std::string textureName, GLenum textureType, const st
 			stbi_image_free(data);
 		}
 	}
-	else if (textureType == GL_FLOAT)
+	else if (textureType == GL_HALF_FLOAT)
 	{
-		float* data = stbi_loadf(textureFileName.c_str(), &_width, &_height, &_nrChannels, 0);
-		if (data)
+		// decoded straight to half floats, half the bytes of 32-bit float storage.
+		HalfFloatImage image;
+		if (LoadHalfFloatImage(textureFileName, channelCount, image))
 		{
-			GLenum internalFormat, format;
-			if (_nrChannels == 1)
+			GLenum internalFormat = GL_RGB16F, format = GL_RGB;
+			if (channelCount == 1)
 			{
-				internalFormat = GL_R32F;
+				internalFormat = GL_R16F;
 				format = GL_RED;
 			}
-			else if (_nrChannels == 3)
+			else if (channelCount == 4)
 			{
-				internalFormat = GL_RGB32F;
-				format = GL_RGB;
-			}
-			else if (_nrChannels == 4)
-			{
-				internalFormat = GL_RGBA32F;
+				internalFormat = GL_RGBA16F;
 				format = GL_RGBA;
 			}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, _width, _height, 0, format, GL_FLOAT, data);
-			stbi_image_free(data);
+			// the storage starts as 8-bit, it is reallocated once when the first float map arrives.
+			int storageInternalFormat = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &storageInternalFormat);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			if (image.width == static_cast<uint32_t>(storageWidth) && image.height == static_cast<uint32_t>(storageHeight) &&
+				static_cast<GLenum>(storageInternalFormat) == internalFormat)
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, format, GL_HALF_FLOAT, image.texels.data());
+			else
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_HALF_FLOAT, image.texels.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 		}
 		else
-		{
 			std::cout << "Failed to load " << textureName << " texture" << std::endl;
-			stbi_image_free(data);
-		}
 	}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -672,23 +1029,25 @@ void Renderer::LoadTexture(std::string textureName, GLenum textureType, const st
 
 void Renderer::BuildImageBasedLightsAndDraw()
 {
+	TRACE_CPU_ZONE("BuildImageBasedLightsAndDraw");
+
 	uint32_t equirectangularToCubeShaders = mProgramIDs["equirectangularToCube"];
 	uint32_t irradianceMapShaders = mProgramIDs["irradianceMap"]; // irradiacneMap -> irradianceMap
 	uint32_t prefilterMapShaders = mProgramIDs["prefilterMap"];
 	uint32_t brdfShaders = mProgramIDs["brdf"];
 
-	std::string hdrDirectoryName = mDatasetDirectoryName + "\\hdr\\";
-	std::array<std::string, 6> hdrFileNames = {
-		"blue_photo_studio",
-		"dancing_hall",
-		"office",
-		"pine_attic",
-		"studio_small_03",
-		"thatch_chapel"
-	};
-	for (int i = 0; i < 6; i++)
+	// one BRDF table for all lights, created on first use from the baked binary or by one brdf pass.
+	mBrdfLookUpTable.Initialize(brdfShaders, 512, mTextureDirectoryName + "brdfLUT_512.bin");
+
+	// resized once, the lights keep pointers into their own resources.
+	std::string hdrDirectoryName = mSweepManifest.datasetDirectoryName + "\\hdr\\";
+	const auto& hdrFileNames = mSweepManifest.hdrNames;
+	mImageBasedLights.resize(hdrFileNames.size());
+	for (size_t i = 0; i < hdrFileNames.size(); i++)
 	{
 		mImageBasedLights[i].SetDirectoryAndFileName(mShaderDirectoryName, hdrDirectoryName + hdrFileNames[i] + ".hdr", hdrFileNames[i]);
+		mImageBasedLights[i].SetTransientResourcePool(&mTransientResourcePool);
+		mImageBasedLights[i].SetBrdfLookUpTable(&mBrdfLookUpTable);
 		mImageBasedLights[i].BuildResources();
 		mImageBasedLights[i].Draw(
 			equirectangularToCubeShaders,
@@ -697,6 +1056,10 @@ void Renderer::BuildImageBasedLightsAndDraw()
 			brdfShaders
 		);
 	}
+
+	// every cube map is captured, the equirectangular sources the lights passed along are not needed anymore.
+	mTransientResourcePool.BeginFrame();
+	mTransientResourcePool.TrimUnused(0);
 }
 
 void Renderer::InitializeSceneConstant()
@@ -716,9 +1079,9 @@ void Renderer::InitializeSceneConstant()
 	mCurrentViewMatrix = glm::lookAt(mCurrentCameraPosition,
 		mCurrentCameraPosition + mCurrentCameraFront,
 		mCameraUp);
-	mProjectionMatrix = glm::perspective(glm::radians(45.0f), static_cast<float>(mWindowWidth) / static_cast<float>(mWindowHeight), 0.1f, 100.0f);
+	mProjectionMatrix = glm::perspective(glm::radians(45.0f), static_cast<float>(mRenderWidth) / static_cast<float>(mRenderHeight), 0.1f, 100.0f);
 
-	mSceneConstant.screenSize = glm::vec2(mWindowWidth, mWindowHeight);
+	mSceneConstant.screenSize = glm::vec2(mRenderWidth, mRenderHeight);
 	// mSceneConstant.cameraPos = mCamera.GetPosition();
 	mSceneConstant.cameraPos = mCurrentCameraPosition;
 	mSceneConstant.cameraFront = mCurrentCameraFront;
@@ -770,19 +1133,10 @@ void Renderer::InitializeSceneConstant()
 	*/
 }
 
-void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs)
+void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders)
 {
-	uint32_t programID = glCreateProgram();
-
-	for (const auto& shaderID : shaderIDs)
-		glAttachShader(programID, shaderID);
-	glLinkProgram(programID);
-	CheckCompileErrors(programID, "PROGRAM");
-
-	for (const auto& shaderID : shaderIDs)
-		glDetachShader(programID, shaderID);
-
-	mProgramIDs.insert({ shaderName, programID });
+	// linked later by mProgramCache.BuildPrograms, which tries the cached binary first.
+	mProgramCache.RequestProgram(shaderName, shaders);
 }
 void Renderer::UseProgram(uint32_t programID)
 {
@@ -813,7 +1167,8 @@ void Renderer::BuildRenderItems()
 	renderItem.viewMaps.push_back(&mG_Buffer["viewMap"]);
 	renderItem.irradianceMap = mImageBasedLights[0].GetIrradianceMap();
 	renderItem.prefilterMap = mImageBasedLights[0].GetPreFilteredEnvironmentMap();
-	renderItem.brdfLUT = mImageBasedLights[0].GetBRDFLookUpTable();
+	if (!mIsUsingAnalyticBRDF)
+		renderItem.brdfLUT = mImageBasedLights[0].GetBRDFLookUpTable();
 
 	for (auto& shadowMap : mSceneConstant.shadowMaps)
 		renderItem.shadowMaps.push_back(&shadowMap);
@@ -833,6 +1188,22 @@ void Renderer::BuildRenderItems()
 
 	mAllRenderItems.insert({ RenderLayer::Environment, mEnvironmentRenderItems });
 }
+void Renderer::DrawG_BufferQuad(uint32_t programID)
+{
+	UseProgram(programID);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, mG_Buffer["albedoMap"].GetTexture());
+	SetInt(programID, "albedoMap0", 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, mG_Buffer["maskMap"].GetTexture());
+	SetInt(programID, "maskMap0", 1);
+
+	Mesh& quad = mBasicMeshes["quad"];
+	glBindVertexArray(quad.GetVertexAttribArray());
+	glDrawElements(quad.GetPrimitiveType(), quad.GetIndexCount(), quad.GetIndexFormat(), nullptr);
+	glBindVertexArray(0);
+}
 void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool isEnvironmentMap)
 {
 	const auto& renderItems = mAllRenderItems[renderLayer];
@@ -870,9 +1241,6 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 
 	UseProgram(programID);
 
-	SetBool(programID, "enableImageBasedLighting", mMenu.enableImageBasedLighting);
-	SetBool(programID, "enableShadow", mMenu.enableShadow);
-
 	SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
 	SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
 	SetMat4(programID, "sceneConstant.invView", mSceneConstant.invView);
@@ -1031,10 +1399,13 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 		SetInt(programID, "prefilterMap", i);
 		i++;
 
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, renderItem.brdfLUT->GetTexture());
-		SetInt(programID, "brdfLUT", i);
-		i++;
+		if (renderItem.brdfLUT != nullptr)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, renderItem.brdfLUT->GetTexture());
+			SetInt(programID, "brdfLUT", i);
+			i++;
+		}
 
 		const auto& shadowMaps = renderItem.shadowMaps;
 		uint32_t shadowMapCount = 0;
@@ -1,13 +1,24 @@
 #pragma once
 #include "../../cores/BasicGeometryGenerator.h"
+#include "../../cores/BrdfLookUpTable.h"
 #include "../../cores/Camera.h"
+#include "../../cores/CpuTracer.h"
 #include "../../cores/Framebuffer.h"
+#include "../../cores/GBufferArchive.h"
+#include "../../cores/HalfFloatImage.h"
+#include "../../cores/HeadlessContext.h"
 #include "../../cores/ImageBasedLight.h"
+#include "../../cores/ImageWriter.h"
 #include "../../cores/Mesh.h"
 #include "../../cores/Model.h"
+#include "../../cores/ProgramCache.h"
+#include "../../cores/RenderTarget.h"
 #include "../../cores/Shader.h"
+#include "../../cores/ShaderPermutation.h"
 #include "../../cores/Stdafx.h"
+#include "../../cores/SweepScheduler.h"
 #include "../../cores/Texture.h"
+#include "../../cores/TransientResourcePool.h"
 #include "../../cores/Utility.h"
 
 #include "imgui/imgui.h"
@@ -67,7 +78,16 @@ public:
 	Renderer(const Renderer& rhs) = delete;
 	Renderer operator=(const Renderer& rhs) = delete;
 
-	void Initialize();
+	void SetHeadlessBackend(HeadlessBackend backend); // call before Initialize
+	void SetRenderTargetSize(uint32_t width, uint32_t height, uint32_t sampleCount); // call before Initialize
+	void SetAnalyticBRDF(bool isUsingAnalyticBRDF); // call before Initialize
+	void SetOutputFormat(const std::string& formatName, uint32_t threadCount = 0); // call before Initialize
+	void SetSweepManifest(const std::string& manifestFileName); // call before Initialize
+	void SetSweepShard(uint32_t shardIndex, uint32_t shardCount, bool isSkippingCompleted = true); // call before Initialize
+	bool Initialize(); // false when the sweep or the context cannot be set up, nothing may be drawn then
+
+	// offline: packs the png G-buffers of every model of the sweep into one archive per model, needs no context.
+	bool PackG_BufferArchives();
 
 	void RenderLoop();
 
@@ -79,6 +99,9 @@ public:
 
 private:
 	bool InitializeWindow();
+	bool InitializeHeadlessContext();
+
+	bool BuildSweep();
 
 	void ProcessKeyboardInput();
 	void UpdateData();
@@ -95,18 +118,21 @@ private:
 
 	void BuildG_Buffers();
 	void LoadG_Buffers(const std::string& directoryName, float degree0, float degree1);
+	void LoadG_BuffersFromArchive(uint32_t viewIndex);
 	void LoadTexture(std::string textureName, GLenum textureType, const std::string& directoryName, float degree0, float degree1);
 
 	void BuildImageBasedLightsAndDraw();
 
 	void InitializeSceneConstant();
 
-	void LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs);
+	void LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders);
 	void UseProgram(uint32_t programID);
 
 	void BuildRenderItems();
 
 	void DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool isEnvironmentMap = false);
+	// fullscreen quad reading the albedo and mask maps of the G-buffer.
+	void DrawG_BufferQuad(uint32_t programID);
 	void DrawShadowMap(RenderLayer renderLayer, uint32_t programID, uint32_t lightIndex);
 	void DrawShadowCubeMap(RenderLayer renderLayer, uint32_t programID, uint32_t lightIndex);
 
@@ -121,17 +147,29 @@ private:
 	// GLFW window pointer
 	GLFWwindow* mWindow = nullptr;
 
+	// headless backend renders with no window, swap or imgui
+	HeadlessBackend mHeadlessBackend = HeadlessBackend::None;
+	bool mIsHeadless = false;
+	HeadlessContext mHeadlessContext;
+	bool mIsContextCreated = false;
+
+	// the scene is rendered and saved at this size, independent of the window
+	uint32_t mRenderWidth = 800;
+	uint32_t mRenderHeight = 600;
+	uint32_t mRenderSampleCount = 1; // only geometry rasterized into the target would gain from msaa
+	RenderTarget mSceneRenderTarget;
+
 	static Renderer* renderer;
 
 	std::unordered_map<std::string, uint32_t> mProgramIDs;
+	ProgramCache mProgramCache;
+	ShaderPermutation mPBRDeferredPermutation;
 
 	// camera variables
 	Camera mCamera;
 	bool isCameraMove = false;
 	float mTheta = 0.0f, mPhi = 0.0f;
-	uint32_t mImageBasedLightIndex = 0;
 	static const float mRadius;
-	static const float mDegreeDelta;
 	glm::vec3 mCurrentCameraPosition;
 	glm::vec3 mCurrentCameraFront;
 	glm::vec3 mCameraUp;
@@ -158,15 +196,32 @@ private:
 	std::unordered_map<RenderLayer, std::vector<RenderItem>> mAllRenderItems;
 
 	std::string mShaderDirectoryName = "..\\..\\resources\\shaders\\";
+	std::string mShaderCacheDirectoryName = "..\\..\\resources\\shaders\\cache\\";
 	std::string mTextureDirectoryName = "..\\..\\resources\\textures\\";
 	std::string mModelDirectoryName = "..\\..\\resources\\models\\";
 	std::string mImageDirectoryName = "..\\..\\resources\\images\\";
+	std::string mProfileDirectoryName = "..\\..\\resources\\profiles\\";
 
 	std::string mDatasetDirectoryName = "..\\..\\resources\\IBL_rendered_examples";
-	std::vector<std::string> mModelDirectoryNames;
 
-	static constexpr uint32_t mNumImageBasedLights = 6;
-	std::array<ImageBasedLight, mNumImageBasedLights> mImageBasedLights;
+	// dataset sweep, split into shards that run as separate processes
+	std::string mSweepManifestFileName;
+	SweepManifest mSweepManifest;
+	SweepScheduler mSweepScheduler;
+	uint32_t mShardIndex = 0;
+	uint32_t mShardCount = 1;
+	bool mIsSkippingCompletedWork = true;
+
+	// format and encoder threads of the saved images, "png" unless the manifest or command line says otherwise
+	std::string mOutputFormatName;
+	ImageFileFormat mOutputFormat = ImageFileFormat::PNG;
+	uint32_t mOutputThreadCount = 0;
+	ImageWriter mImageWriter;
+
+	std::vector<ImageBasedLight> mImageBasedLights; // one per hdr of the sweep
+	TransientResourcePool mTransientResourcePool; // capture framebuffers and equirectangular sources shared by all image based lights
+	BrdfLookUpTable mBrdfLookUpTable; // shared by all image based lights
+	bool mIsUsingAnalyticBRDF = false; // fitted curve in the shader, the table is never created
 	
 	// shadow resources
 	Framebuffer mShadowMapFramebuffer;
@@ -175,6 +230,24 @@ private:
 
 	std::unordered_map<std::string, Texture> mG_Buffer; // not position map for research, only albedo map, normal map, metallic map, roughness map, ao map
 
+	// maps of the png layout, name + "Map" is the mG_Buffer key
+	std::vector<GBufferMapInfo> mG_BufferMaps = {
+		{ "albedo", "Albedo", 4 },
+		{ "normal", "Normal", 3 },
+		{ "metallic", "Metallic", 1 },
+		{ "roughness", "Roughness", 1 },
+		{ "metallicRoughness", "Metallic-Roughness", 3 },
+		{ "ao", "AO", 1 },
+		{ "mask", "Mask", 1 },
+		{ "depth", "Depth", 1 },
+		{ "view", "view", 3 }
+	};
+	std::string mG_BufferArchiveFileName = "gbuffers.gba";
+	std::string mOpenG_BufferArchiveFileName;
+	GBufferArchive mG_BufferArchive;
+	uint32_t mG_BufferPixelBuffer = 0;
+	size_t mG_BufferPixelBufferSize = 0;
+
 	// mouse variables
 	float mLastMousePosX = 0.0f;
 	float mLastMousePosY = 0.0f;
@@ -1,12 +1,74 @@
 #include "Renderer.h"
 
-int main()
+int main(int argc, char** argv)
 {
+	// the bake is cpu only and exits before the renderer exists, its destructor needs a gl context.
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.starts_with("--bake-brdf-lut="))
+			return BrdfLookUpTable::BakeBrdfLookUpTable(argument.substr(std::string("--bake-brdf-lut=").size()), 512) ? 0 : -1;
+	}
+
 	Renderer renderer;
 
+	// --headless=egl or --headless=osmesa runs the dataset sweep without a window.
+	// --resolution=WIDTHxHEIGHT and --samples=N set the output image size and msaa sample count,
+	// the lighting is a fullscreen pass over image G-buffers without geometry edges, so msaa is off by default.
+	// --manifest=FILE lists the models, hdrs and angles to render, --shard=INDEX/COUNT renders every COUNT-th view from INDEX,
+	// images that already exist are skipped unless --overwrite is given.
+	// --format=png|qoi|raw|exr|pfm sets the image format, exr and pfm keep the linear hdr radiance,
+	// --output-threads=N sets how many threads encode the images.
+	// --pack-gbuffers packs the png G-buffers of every model into one archive per model and exits.
+	// --analytic-brdf replaces the BRDF table with a fitted curve, --bake-brdf-lut=FILE writes the table offline and exits.
+	uint32_t renderWidth = 800, renderHeight = 600, sampleCount = 1;
+	uint32_t shardIndex = 0, shardCount = 1;
+	bool isSkippingCompleted = true;
+	bool isPackingG_Buffers = false;
+	std::string outputFormatName;
+	uint32_t outputThreadCount = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.starts_with("--headless="))
+			renderer.SetHeadlessBackend(ParseHeadlessBackend(argument.substr(std::string("--headless=").size())));
+		else if (argument.starts_with("--resolution="))
+			std::sscanf(argument.c_str(), "--resolution=%ux%u", &renderWidth, &renderHeight);
+		else if (argument.starts_with("--samples="))
+			std::sscanf(argument.c_str(), "--samples=%u", &sampleCount);
+		else if (argument.starts_with("--manifest="))
+			renderer.SetSweepManifest(argument.substr(std::string("--manifest=").size()));
+		else if (argument.starts_with("--shard="))
+		{
+			// a shard past the count would silently render nothing.
+			if (std::sscanf(argument.c_str(), "--shard=%u/%u", &shardIndex, &shardCount) != 2 || shardIndex >= shardCount)
+			{
+				std::cerr << "Invalid " << argument << ", expected --shard=INDEX/COUNT with INDEX below COUNT" << '\n';
+				return -1;
+			}
+		}
+		else if (argument == "--overwrite")
+			isSkippingCompleted = false;
+		else if (argument.starts_with("--format="))
+			outputFormatName = argument.substr(std::string("--format=").size());
+		else if (argument.starts_with("--output-threads="))
+			std::sscanf(argument.c_str(), "--output-threads=%u", &outputThreadCount);
+		else if (argument == "--pack-gbuffers")
+			isPackingG_Buffers = true;
+		else if (argument == "--analytic-brdf")
+			renderer.SetAnalyticBRDF(true);
+	}
+	renderer.SetRenderTargetSize(renderWidth, renderHeight, sampleCount);
+	renderer.SetSweepShard(shardIndex, shardCount, isSkippingCompleted);
+	renderer.SetOutputFormat(outputFormatName, outputThreadCount);
+
+	if (isPackingG_Buffers)
+		return renderer.PackG_BufferArchives() ? 0 : -1;
+
 	try
 	{
-		renderer.Initialize();
+		if (!renderer.Initialize())
+			return -1;
 
 		renderer.RenderLoop();
 	}
@@ -41,6 +41,12 @@ Renderer::~Renderer()
 	 for (auto& texture : mBasicTextures)
 		 texture.second.DeleteTexture();
 
+	mMultiViewTarget.DeleteMultiViewTarget();
+	mImageWriter.DeleteImageWriter();
+	mTextureStreamer.DeleteTextureStreamer();
+	mJobSystem.DeleteJobSystem();
+	mUploadRing.DeleteUploadRing();
+
 	renderer = nullptr;
 
 	ImGui_ImplOpenGL3_Shutdown();
@@ -69,6 +75,10 @@ void Renderer::Initialize()
 
 	ImGui::StyleColorsDark();
 
+	mImageWriter.Initialize(ImageFileFormat::PNG);
+	mJobSystem.Initialize();
+	mUploadRing.CreateUploadRing(1 << 20);
+
 	// Create meshes
 	BasicGeometryGenerator geoGenerator;
 	auto box = geoGenerator.CreateBox(2.0f, 2.0f, 2.0f);
@@ -89,7 +99,13 @@ void Renderer::Initialize()
 
 	// Load models
 	// model LoadModel ȣ⸸ configuremesh, buildtexture ÿ ȣ
-	mMiniModel.LoadModel(mModelDirectoryName + "Cerberus_by_Andrew_Maximov\\Cerberus_LP.fbx");
+	// the file is imported on a worker while the textures, shaders and framebuffers are built here,
+	// the meshes and textures of the model are created on this thread once it is done.
+	mTextureStreamer.Initialize(TextureStreamerInfo{});
+	mMiniModel.SetTextureStreamer(&mTextureStreamer);
+	std::string miniModelFileName = mModelDirectoryName + "Cerberus_by_Andrew_Maximov\\Cerberus_LP.fbx";
+	JobHandle importMiniModel = mJobSystem.Schedule([this, miniModelFileName] { mMiniModel.ImportModel(miniModelFileName); });
+	JobHandle configureMiniModel = mJobSystem.Schedule([this] { mMiniModel.ConfigureModel(); }, { importMiniModel }, JobAffinity::MainThread);
 
 	// Initialize scene constants
 	InitializeSceneConstant();
@@ -108,6 +124,8 @@ void Renderer::Initialize()
 
 	BuildShadowResources();
 
+	mJobSystem.Wait(configureMiniModel);
+
 	mImageBasedLight.SetDirectoryAndFileName(mShaderDirectoryName, mTextureDirectoryName + +"wooden_lounge_4k.hdr");
 	mImageBasedLight.BuildResources();
 
@@ -135,8 +153,18 @@ void Renderer::RenderLoop()
 		ImGui::NewFrame();
 
 		ProcessKeyboardInput();
+		mUploadRing.BeginFrame();
+		mJobSystem.ProcessMainThreadJobs();
 		UpdateData();
+
+		if (mIsCapturingMultiView)
+		{
+			CaptureMultiView();
+			mIsCapturingMultiView = false;
+		}
+
 		DrawScene();
+		mUploadRing.EndFrame();
 
 		glfwSwapBuffers(mWindow);
 		glfwPollEvents();
@@ -180,6 +208,9 @@ void Renderer::KeyCallback(GLFWwindow* window, int key, int scancode, int action
 {
 	if (key == GLFW_KEY_G && action == GLFW_PRESS)
 		mShowImGuiWindow = !mShowImGuiWindow;
+
+	if (key == GLFW_KEY_M && action == GLFW_PRESS)
+		mIsCapturingMultiView = true;
 }
 
 Renderer* Renderer::GetRendererPointer()
@@ -248,6 +279,12 @@ void Renderer::ProcessKeyboardInput()
 void Renderer::UpdateData()
 {
 	UpdateSceneConstants();
+	UpdateGridWaves();
+
+	int windowWidth, windowHeight;
+	glfwGetFramebufferSize(mWindow, &windowWidth, &windowHeight);
+	mMiniModel.RequestTextureSizes(mMiniModelWorld, mCamera.GetPosition(), mCamera.GetFovAngleY(), static_cast<float>(windowHeight));
+	mTextureStreamer.Update();
 }
 void Renderer::DrawScene()
 {
@@ -266,7 +303,7 @@ void Renderer::DrawScene()
 	// glEnable(GL_CULL_FACE);
 	// glCullFace(GL_BACK);
 
-	DrawRenderItems(RenderLayer::PBR, mProgramIDs["pbr"]);
+	DrawRenderItems(RenderLayer::PBR, mPBRPermutation.GetProgram(GetShaderFeatureMask(mMenu)));
 	DrawRenderItems(RenderLayer::Environment, mProgramIDs["cubeMapHDR"], mMenu.enableEnvironment);
 
 	if (mShowImGuiWindow)
@@ -277,6 +314,7 @@ void Renderer::DrawScene()
 		ImGui::Checkbox("IsUsingNormalMap", &mMenu.isUsingNormalMap);
 		ImGui::Checkbox("EnableEnvironment", &mMenu.enableEnvironment);
 		ImGui::Checkbox("EnableImageBasedLighting", &mMenu.enableImageBasedLighting);
+		ImGui::Checkbox("AnimateGrid", &mIsAnimatingGrid);
      
 		ImGui::SliderFloat4("ambient", &mSceneConstant.ambientLight.x, 0.0f, 1.0f);
 
@@ -301,6 +339,127 @@ void Renderer::UpdateSceneConstants()
 	mSceneConstant.cameraPos = mCamera.GetPosition();
 }
 
+void Renderer::UpdateGridWaves()
+{
+	Mesh& grid = mBasicMeshes["grid"];
+	if (!mIsAnimatingGrid)
+	{
+		grid.RestoreVertices();
+		return;
+	}
+
+	// y = a * sin(kx + t) * cos(kz + t), the normal and tangent follow its partial derivatives.
+	const float amplitude = 0.5f;
+	const float waveNumber = 0.5f;
+	float time = static_cast<float>(glfwGetTime());
+
+	const auto& vertices = grid.GetVertices();
+	mGridWaveVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Vertex vertex = vertices[i];
+		float sinX = std::sin(waveNumber * vertex.position.x + time);
+		float cosX = std::cos(waveNumber * vertex.position.x + time);
+		float sinZ = std::sin(waveNumber * vertex.position.z + time);
+		float cosZ = std::cos(waveNumber * vertex.position.z + time);
+
+		float dydx = amplitude * waveNumber * cosX * cosZ;
+		float dydz = -amplitude * waveNumber * sinX * sinZ;
+		vertex.position.y += amplitude * sinX * cosZ;
+		vertex.normal = glm::normalize(glm::vec3(-dydx, 1.0f, -dydz));
+		vertex.tangent = glm::normalize(glm::vec3(1.0f, dydx, 0.0f));
+		mGridWaveVertices[i] = vertex;
+	}
+
+	// every frame while animating, the allocation of an older frame is rewritten by the ring.
+	grid.UpdateVertices(mGridWaveVertices, mUploadRing);
+}
+
+void Renderer::CaptureMultiView()
+{
+	GLenum format = GL_NONE, type = GL_NONE;
+	uint32_t pixelSize = 0;
+	mImageWriter.GetReadBackFormat(format, type, pixelSize);
+
+	uint32_t width = mMultiViewTarget.GetWidth();
+	uint32_t height = mMultiViewTarget.GetHeight();
+	uint32_t viewCount = mMultiViewTarget.GetViewCount();
+	size_t layerSize = static_cast<size_t>(width) * height * pixelSize;
+
+	std::vector<uint8_t> pixels;
+	for (float theta : mMultiViewThetas)
+	{
+		// one ring of views around the origin, same angles as the dataset sweep.
+		std::vector<glm::mat4> views;
+		std::vector<glm::vec3> cameraPositions;
+		for (uint32_t view = 0; view < viewCount; view++)
+		{
+			float phi = 360.0f * view / viewCount;
+			glm::vec3 cameraPosition = glm::vec3(
+				mMultiViewRadius * cos(glm::radians(theta - 90.0f)) * cos(glm::radians(phi)),
+				mMultiViewRadius * sin(glm::radians(theta - 90.0f)),
+				mMultiViewRadius * cos(glm::radians(theta - 90.0f)) * sin(glm::radians(phi)));
+			cameraPositions.push_back(cameraPosition);
+			views.push_back(glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		}
+
+		DrawMultiView(views, cameraPositions);
+
+		// all views of the ring come back in one transfer and are encoded on the writer threads.
+		mMultiViewTarget.ReadBack(format, type, pixelSize, pixels);
+		for (uint32_t view = 0; view < viewCount; view++)
+		{
+			std::string fileName = mImageDirectoryName + "multiview_" + std::to_string(static_cast<uint32_t>(theta)) + "_"
+				+ std::to_string(360 * view / viewCount) + GetImageFileExtension(mImageWriter.GetFormat());
+			mImageWriter.SaveImage(fileName, width, height,
+				std::vector<uint8_t>(pixels.begin() + view * layerSize, pixels.begin() + (view + 1) * layerSize));
+		}
+	}
+	mImageWriter.Flush();
+
+	std::cout << "Multi-view capture saved " << mMultiViewThetas.size() * viewCount << " views" << std::endl;
+}
+void Renderer::DrawMultiView(const std::vector<glm::mat4>& views, const std::vector<glm::vec3>& cameraPositions)
+{
+	mMultiViewTarget.SetViews(views, cameraPositions);
+	mMultiViewTarget.Bind();
+
+	// the whole array is attached, so this clears every view.
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	uint32_t featureMask = GetShaderFeatureMask(mMenu);
+	if (mIsLayeredMultiView)
+	{
+		// every draw call is instanced once per view.
+		mInstanceCount = static_cast<uint32_t>(views.size());
+		DrawRenderItems(RenderLayer::PBR, mPBRMultiViewPermutation.GetProgram(featureMask));
+		DrawRenderItems(RenderLayer::Environment, mProgramIDs["cubeMapHDRMultiView"], mMenu.enableEnvironment);
+		mInstanceCount = 1;
+	}
+	else
+	{
+		glm::mat4 view = mSceneConstant.view;
+		glm::vec3 cameraPos = mSceneConstant.cameraPos;
+		for (uint32_t layer = 0; layer < views.size(); layer++)
+		{
+			mMultiViewTarget.BindLayer(layer);
+			mSceneConstant.view = views[layer];
+			mSceneConstant.cameraPos = cameraPositions[layer];
+			DrawRenderItems(RenderLayer::PBR, mPBRPermutation.GetProgram(featureMask));
+			DrawRenderItems(RenderLayer::Environment, mProgramIDs["cubeMapHDR"], mMenu.enableEnvironment);
+		}
+		mSceneConstant.view = view;
+		mSceneConstant.cameraPos = cameraPos;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 void Renderer::BuildTextures()
 {
 	TextureInfo textureSetup;
@@ -366,70 +525,98 @@ void Renderer::BuildMaterials()
 }
 void Renderer::BuildShaders()
 {
-	std::vector<uint32_t> shaderIDs;
+	mProgramCache.Initialize(mShaderCacheDirectoryName, (GLADloadproc)glfwGetProcAddress);
+
+	std::vector<Shader*> shaders;
 
 	Shader opaqueVertexShader;
 	Shader opaqueFragmentShader;
-	opaqueVertexShader.CompileShader(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
-	opaqueFragmentShader.CompileShader(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(opaqueVertexShader.GetShaderID());
-	shaderIDs.push_back(opaqueFragmentShader.GetShaderID());
-	LinkPrograms("opaque", shaderIDs);
-	shaderIDs.clear();
-
-	Shader pbrVertexShader;
-	Shader pbrFragmentShader;
-	pbrVertexShader.CompileShader(mShaderDirectoryName + "pbr.vert", GL_VERTEX_SHADER);
-	pbrFragmentShader.CompileShader(mShaderDirectoryName + "pbr.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(pbrVertexShader.GetShaderID());
-	shaderIDs.push_back(pbrFragmentShader.GetShaderID());
-	LinkPrograms("pbr", shaderIDs);
-	shaderIDs.clear();
+	opaqueVertexShader.LoadShaderCode(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
+	opaqueFragmentShader.LoadShaderCode(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&opaqueVertexShader);
+	shaders.push_back(&opaqueFragmentShader);
+	LinkPrograms("opaque", shaders);
+	shaders.clear();
+
+	// pbr variants are specialized per feature mask on first use.
+	mPBRPermutation.Initialize(&mProgramCache, "pbr",
+		mShaderDirectoryName + "pbr.vert", mShaderDirectoryName + "pbr.frag", { "USE_UPLOAD_RING" });
 
 	Shader cubeMapVertexShader;
 	Shader cubeMapFragmentShader;
-	cubeMapVertexShader.CompileShader(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
-	cubeMapFragmentShader.CompileShader(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(cubeMapFragmentShader.GetShaderID());
-	LinkPrograms("cubeMapHDR", shaderIDs);
-	shaderIDs.clear();
+	cubeMapVertexShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER);
+	cubeMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&cubeMapFragmentShader);
+	LinkPrograms("cubeMapHDR", shaders);
+	shaders.clear();
+
+	// multi-view variants write gl_Layer from the vertex shader, without it the views are drawn one pass each.
+	std::vector<std::string> multiViewDefines = { "MULTI_VIEW" };
+	if (IsExtensionSupported("GL_ARB_shader_viewport_layer_array"))
+	{
+		multiViewDefines.push_back("USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY");
+		mIsLayeredMultiView = true;
+	}
+	else if (IsExtensionSupported("GL_AMD_vertex_shader_layer"))
+		mIsLayeredMultiView = true;
+
+	// requested shaders are compiled by BuildPrograms below, so they must outlive the if block.
+	Shader cubeMapMultiViewVertexShader;
+	if (mIsLayeredMultiView)
+	{
+		std::vector<std::string> pbrMultiViewDefines = multiViewDefines;
+		pbrMultiViewDefines.push_back("USE_UPLOAD_RING");
+		mPBRMultiViewPermutation.Initialize(&mProgramCache, "pbrMultiView",
+			mShaderDirectoryName + "pbr.vert", mShaderDirectoryName + "pbr.frag", pbrMultiViewDefines);
+
+		cubeMapMultiViewVertexShader.LoadShaderCode(mShaderDirectoryName + "cubemapHDR.vert", GL_VERTEX_SHADER, multiViewDefines);
+		shaders.push_back(&cubeMapMultiViewVertexShader);
+		shaders.push_back(&cubeMapFragmentShader);
+		LinkPrograms("cubeMapHDRMultiView", shaders);
+		shaders.clear();
+	}
 
 	Shader equirectangularToCubeFragmentShader;
-	equirectangularToCubeFragmentShader.CompileShader(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(equirectangularToCubeFragmentShader.GetShaderID());
-	LinkPrograms("equirectangularToCube", shaderIDs);
-	shaderIDs.clear();
+	equirectangularToCubeFragmentShader.LoadShaderCode(mShaderDirectoryName + "equirectangularToCube.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&equirectangularToCubeFragmentShader);
+	LinkPrograms("equirectangularToCube", shaders);
+	shaders.clear();
 
 	Shader irradianceMapFragmentShader;
-	std::vector<uint32_t> irradianceMapShaderIDs;
-	irradianceMapFragmentShader.CompileShader(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(irradianceMapFragmentShader.GetShaderID());
-	LinkPrograms("irradianceMap", shaderIDs);
-	shaderIDs.clear();
+	irradianceMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "irradianceMap.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&irradianceMapFragmentShader);
+	LinkPrograms("irradianceMap", shaders);
+	shaders.clear();
 
 	Shader prefilterMapFragmentShader;
-	prefilterMapFragmentShader.CompileShader(mShaderDirectoryName + "prefilterMap.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	shaderIDs.push_back(prefilterMapFragmentShader.GetShaderID());
-	LinkPrograms("prefilterMap", shaderIDs);
-	shaderIDs.clear();
+	prefilterMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "prefilterMap.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&cubeMapVertexShader);
+	shaders.push_back(&prefilterMapFragmentShader);
+	LinkPrograms("prefilterMap", shaders);
+	shaders.clear();
 
 	Shader brdfVertexShader;
 	Shader brdfFragmentShader;
-	brdfVertexShader.CompileShader(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
-	brdfFragmentShader.CompileShader(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
-	shaderIDs.push_back(brdfVertexShader.GetShaderID());
-	shaderIDs.push_back(brdfFragmentShader.GetShaderID());
-	LinkPrograms("brdf", shaderIDs);
-	shaderIDs.clear();
+	brdfVertexShader.LoadShaderCode(mShaderDirectoryName + "brdf.vert", GL_VERTEX_SHADER);
+	brdfFragmentShader.LoadShaderCode(mShaderDirectoryName + "brdf.frag", GL_FRAGMENT_SHADER);
+	shaders.push_back(&brdfVertexShader);
+	shaders.push_back(&brdfFragmentShader);
+	LinkPrograms("brdf", shaders);
+	shaders.clear();
+
+	mProgramCache.BuildPrograms(mProgramIDs);
 }
 
 void Renderer::BuildFramebuffers()
 {
-	
+	MultiViewTargetInfo multiViewTargetInfo;
+	multiViewTargetInfo.width = mWindowWidth;
+	multiViewTargetInfo.height = mWindowHeight;
+	multiViewTargetInfo.viewCount = mMultiViewCount;
+	mMultiViewTarget.CreateMultiViewTarget(multiViewTargetInfo);
 }
 
 void Renderer::InitializeSceneConstant()
@@ -453,19 +640,10 @@ void Renderer::InitializeSceneConstant()
 		mSceneConstant.pointLights[i].diffuse = glm::vec3(300.0f, 300.0f, 300.0f);
 }
 
-void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs)
+void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders)
 {
-	uint32_t programID = glCreateProgram();
-
-	for (const auto& shaderID : shaderIDs)
-		glAttachShader(programID, shaderID);
-	glLinkProgram(programID);
-	CheckCompileErrors(programID, "PROGRAM");
-
-	for (const auto& shaderID : shaderIDs)
-		glDetachShader(programID, shaderID);
-
-	mProgramIDs.insert({ shaderName, programID });
+	// linked later by mProgramCache.BuildPrograms, which tries the cached binary first.
+	mProgramCache.RequestProgram(shaderName, shaders);
 }
 void Renderer::UseProgram(uint32_t programID)
 {
@@ -496,6 +674,7 @@ void Renderer::BuildRenderItems()
 		world = glm::rotate(world, -glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		world = glm::translate(world, glm::vec3(8.0f, 4.0f, 8.0f));
 		renderItem.world = world;
+		mMiniModelWorld = world;
 
 		for (auto& albedoMap : modelComponent.albedoMaps)
 			renderItem.albedoMaps.push_back(&albedoMap);
@@ -601,7 +780,7 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 			auto vertexAttribArray = renderItem.mesh->GetVertexAttribArray();
 
 			glBindVertexArray(vertexAttribArray);
-			glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
+			glDrawElementsInstanced(primitiveType, indexCount, indexFormat, nullptr, mInstanceCount);
 			glBindVertexArray(0);
 		}
 
@@ -611,35 +790,79 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 
 	UseProgram(programID);
 
-	SetBool(programID, "isUsingTexture", mMenu.isUsingTexture);
-	SetBool(programID, "isUsingNormalMap", mMenu.isUsingNormalMap);
-	SetBool(programID, "enableImageBasedLighting", mMenu.enableImageBasedLighting);
+	// programs built with USE_UPLOAD_RING read the constants from the ring instead of uniforms.
+	bool isUsingUploadRing = glGetUniformBlockIndex(programID, "DrawConstantBuffer") != GL_INVALID_INDEX;
+	if (isUsingUploadRing)
+	{
+		// only what the uniform path sets, the rest stays zero like the uniforms never set.
+		SceneConstantBufferData sceneConstantData{};
+		sceneConstantData.view = mSceneConstant.view;
+		sceneConstantData.projection = mSceneConstant.projection;
+		sceneConstantData.cameraPos = mSceneConstant.cameraPos;
+		sceneConstantData.ambientLight = mSceneConstant.ambientLight;
+
+		sceneConstantData.directionalLights[0].direction = mSceneConstant.directionalLights[0].direction;
+		sceneConstantData.directionalLights[0].diffuse = mSceneConstant.directionalLights[0].diffuse;
+		sceneConstantData.directionalLights[0].specular = mSceneConstant.directionalLights[0].specular;
+
+		for (size_t i = 0; i < sceneConstantData.pointLights.size() && i < mSceneConstant.pointLights.size(); i++)
+		{
+			sceneConstantData.pointLights[i].position = mSceneConstant.pointLights[i].position;
+			sceneConstantData.pointLights[i].diffuse = mSceneConstant.pointLights[i].diffuse;
+		}
 
-	SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
-	SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
-	SetVec3(programID, "sceneConstant.cameraPos", mSceneConstant.cameraPos);
-	
-	SetVec4(programID, "sceneConstant.ambientLight", mSceneConstant.ambientLight);
+		UploadAllocation allocation;
+		if (mUploadRing.Upload(&sceneConstantData, sizeof(sceneConstantData), allocation))
+			mUploadRing.BindUniformBuffer(SceneConstantBufferData::binding, allocation);
+	}
+	else
+	{
+		SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
+		SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
+		SetVec3(programID, "sceneConstant.cameraPos", mSceneConstant.cameraPos);
 
-	SetVec3(programID, "sceneConstant.directionalLights[0].direction", mSceneConstant.directionalLights[0].direction);
-	SetVec3(programID, "sceneConstant.directionalLights[0].diffuse", mSceneConstant.directionalLights[0].diffuse);
-	SetVec3(programID, "sceneConstant.directionalLights[0].specular", mSceneConstant.directionalLights[0].specular);
+		SetVec4(programID, "sceneConstant.ambientLight", mSceneConstant.ambientLight);
 
-	for (auto i = 0; i != mSceneConstant.pointLights.size(); i++)
-	{
-		SetVec3(programID, "sceneConstant.pointLights[" + std::to_string(i) + "].position", mSceneConstant.pointLights[i].position);
-		SetVec3(programID, "sceneConstant.pointLights[" + std::to_string(i) + "].diffuse", mSceneConstant.pointLights[i].diffuse);
+		SetVec3(programID, "sceneConstant.directionalLights[0].direction", mSceneConstant.directionalLights[0].direction);
+		SetVec3(programID, "sceneConstant.directionalLights[0].diffuse", mSceneConstant.directionalLights[0].diffuse);
+		SetVec3(programID, "sceneConstant.directionalLights[0].specular", mSceneConstant.directionalLights[0].specular);
+
+		for (auto i = 0; i != mSceneConstant.pointLights.size(); i++)
+		{
+			SetVec3(programID, "sceneConstant.pointLights[" + std::to_string(i) + "].position", mSceneConstant.pointLights[i].position);
+			SetVec3(programID, "sceneConstant.pointLights[" + std::to_string(i) + "].diffuse", mSceneConstant.pointLights[i].diffuse);
+		}
 	}
 
 	for (auto renderItem : renderItems)
 	{
-		SetMat4(programID, "world", renderItem.world);
-		SetVec3(programID, "material.ka", renderItem.material->ka);
-		SetVec3(programID, "material.kd", renderItem.material->kd);
-		SetVec3(programID, "material.ks", renderItem.material->ks);
-		SetFloat(programID, "material.metallic", renderItem.material->metallic);
-		SetFloat(programID, "material.roughness", renderItem.material->roughness);
-		SetFloat(programID, "material.ao", renderItem.material->ao);
+		if (isUsingUploadRing)
+		{
+			DrawConstantBufferData drawConstantData{};
+			drawConstantData.world = renderItem.world;
+			drawConstantData.ka = renderItem.material->ka;
+			drawConstantData.kd = renderItem.material->kd;
+			drawConstantData.ks = renderItem.material->ks;
+			drawConstantData.metallic = renderItem.material->metallic;
+			drawConstantData.roughness = renderItem.material->roughness;
+			drawConstantData.ao = renderItem.material->ao;
+
+			// a full ring region skips the draw rather than drawing with the previous item's constants.
+			UploadAllocation allocation;
+			if (!mUploadRing.Upload(&drawConstantData, sizeof(drawConstantData), allocation))
+				continue;
+			mUploadRing.BindUniformBuffer(DrawConstantBufferData::binding, allocation);
+		}
+		else
+		{
+			SetMat4(programID, "world", renderItem.world);
+			SetVec3(programID, "material.ka", renderItem.material->ka);
+			SetVec3(programID, "material.kd", renderItem.material->kd);
+			SetVec3(programID, "material.ks", renderItem.material->ks);
+			SetFloat(programID, "material.metallic", renderItem.material->metallic);
+			SetFloat(programID, "material.roughness", renderItem.material->roughness);
+			SetFloat(programID, "material.ao", renderItem.material->ao);
+		}
 
 		const auto& albedoMaps = renderItem.albedoMaps;
 		uint32_t i = 0;
@@ -713,7 +936,8 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 		auto vertexAttribArray = renderItem.mesh->GetVertexAttribArray();
 
 		glBindVertexArray(vertexAttribArray);
-		glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
+		// one instance per view when drawing multi-view.
+		glDrawElementsInstanced(primitiveType, indexCount, indexFormat, nullptr, mInstanceCount);
 		glBindVertexArray(0);
 	}
 }
\ No newline at end of file
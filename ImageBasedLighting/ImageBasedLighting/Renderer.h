@@ -3,11 +3,18 @@
 #include "../../cores/Camera.h"
 #include "../../cores/Framebuffer.h"
 #include "../../cores/ImageBasedLight.h"
+#include "../../cores/ImageWriter.h"
+#include "../../cores/JobSystem.h"
 #include "../../cores/Mesh.h"
 #include "../../cores/Model.h"
+#include "../../cores/MultiViewTarget.h"
+#include "../../cores/ProgramCache.h"
 #include "../../cores/Shader.h"
+#include "../../cores/ShaderPermutation.h"
 #include "../../cores/Stdafx.h"
 #include "../../cores/Texture.h"
+#include "../../cores/TextureStreamer.h"
+#include "../../cores/UploadRing.h"
 #include "../../cores/Utility.h"
 
 #include "imgui/imgui.h"
@@ -39,6 +46,86 @@ struct SceneConstant
 	std::array<SpotLight, SpotLight::maxNumSpotLights> spotLights;
 };
 
+// std140 mirrors of the SceneConstantBuffer and DrawConstantBuffer blocks of pbr.vert and pbr.frag (USE_UPLOAD_RING).
+struct DirectionalLightBufferData
+{
+	glm::vec3 diffuse;
+	float pad0;
+	glm::vec3 specular;
+	float pad1;
+	glm::vec3 direction;
+	float pad2;
+	glm::mat4 lightSpaceMatrix;
+};
+
+struct PointLightBufferData
+{
+	glm::vec3 diffuse;
+	float pad0;
+	glm::vec3 specular;
+	float pad1;
+	glm::vec3 position;
+	float constant;
+	float linear;
+	float quadratic;
+	float pad2[2];
+};
+
+struct SpotLightBufferData
+{
+	glm::vec3 diffuse;
+	float pad0;
+	glm::vec3 specular;
+	float pad1;
+	glm::vec3 direction;
+	float pad2;
+	glm::vec3 position;
+	float constant;
+	float linear;
+	float quadratic;
+	float cutOff;
+	float outerCutOff;
+};
+
+struct SceneConstantBufferData
+{
+	static constexpr uint32_t binding = 2;
+
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	glm::vec3 cameraPos;
+	float pad0;
+
+	glm::vec4 ambientLight;
+	std::array<DirectionalLightBufferData, 4> directionalLights;
+	std::array<PointLightBufferData, 4> pointLights;
+	std::array<SpotLightBufferData, 4> spotLights;
+
+	float farPlane;
+	float pad1[3];
+};
+static_assert(sizeof(DirectionalLightBufferData) == 112 && sizeof(PointLightBufferData) == 64 && sizeof(SpotLightBufferData) == 80);
+static_assert(offsetof(SceneConstantBufferData, pointLights) == 608 && sizeof(SceneConstantBufferData) == 1200);
+
+struct DrawConstantBufferData
+{
+	static constexpr uint32_t binding = 3;
+
+	glm::mat4 world;
+
+	glm::vec3 ka;
+	float pad0;
+	glm::vec3 kd;
+	float pad1;
+	glm::vec3 ks;
+	float metallic;
+	float roughness;
+	float ao;
+	float pad2[2];
+};
+static_assert(sizeof(DrawConstantBufferData) == 128);
+
 void _FramebufferSizeCallback(GLFWwindow* window, int width, int height);
 void _MouseCallback(GLFWwindow* window, double xposIn, double yposIn);
 void _KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -69,6 +156,11 @@ private:
 	void DrawScene();
 
 	void UpdateSceneConstants();
+	void UpdateGridWaves();
+
+	// renders the orbit views of mMultiViewThetas, one ring of views per submission, and saves them.
+	void CaptureMultiView();
+	void DrawMultiView(const std::vector<glm::mat4>& views, const std::vector<glm::vec3>& cameraPositions);
 
 	void BuildTextures();
 	void BuildShadowResources(); // textures and framebuffers
@@ -78,7 +170,7 @@ private:
 
 	void InitializeSceneConstant();
 
-	void LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs);
+	void LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders);
 	void UseProgram(uint32_t programID);
 
 	void BuildRenderItems();
@@ -97,10 +189,25 @@ private:
 	static Renderer* renderer;
 
 	std::unordered_map<std::string, uint32_t> mProgramIDs;
+	ProgramCache mProgramCache;
+	ShaderPermutation mPBRPermutation;
+	ShaderPermutation mPBRMultiViewPermutation;
 
 	Camera mCamera;
 
+	// cpu work fans out to the workers, gl work comes back to this thread
+	JobSystem mJobSystem;
+
+	// per-frame and per-draw constants of the pbr programs, one region per frame in flight
+	UploadRing mUploadRing;
+	// the grid ripples with vertices streamed through mUploadRing
+	bool mIsAnimatingGrid = false;
+	std::vector<Vertex> mGridWaveVertices;
+
+	// model textures stream their mips in within a vram budget
+	TextureStreamer mTextureStreamer;
 	Model mMiniModel;
+	glm::mat4 mMiniModelWorld = glm::mat4(1.0f);
 
 	std::unordered_map<std::string, Mesh> mBasicMeshes;
 	std::unordered_map<std::string, Texture> mBasicTextures;
@@ -122,12 +229,23 @@ private:
 	std::unordered_map<RenderLayer, std::vector<RenderItem>> mAllRenderItems;
 
 	std::string mShaderDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\";
+	std::string mShaderCacheDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\cache\\";
 	std::string mTextureDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\textures\\";
 	std::string mModelDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\models\\";
 	std::string mImageDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\images\\";
 
 	ImageBasedLight mImageBasedLight;
 
+	// multi-view capture, M renders every view of the orbit into mMultiViewTarget
+	MultiViewTarget mMultiViewTarget;
+	bool mIsLayeredMultiView = false; // instanced into all layers at once, otherwise one pass per layer
+	bool mIsCapturingMultiView = false;
+	uint32_t mInstanceCount = 1; // views drawn by each draw call
+	uint32_t mMultiViewCount = 8; // views of one ring
+	std::vector<float> mMultiViewThetas = { 45.0f, 90.0f, 135.0f };
+	float mMultiViewRadius = 3.0f;
+	ImageWriter mImageWriter;
+
 	// mouse variables
 	float mLastMousePosX = 0.0f;
 	float mLastMousePosY = 0.0f;
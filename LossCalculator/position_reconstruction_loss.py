@@ -0,0 +1,31 @@
+import os
+import numpy as np
+import cv2 as cv
+from skimage.metrics import mean_squared_error as mse
+
+# Compare deferred renderer screenshots ('I' key) taken with the position map / interpolated position
+# against the same view rendered with position reconstructed from reversed-Z depth.
+image_directory = os.path.join('..', 'resources', 'images')
+reference_image_path = os.path.join(image_directory, 'image_position_map.png')
+reconstructed_image_path = os.path.join(image_directory, 'image.png')
+diff_image_path = os.path.join(image_directory, 'image_position_diff.png')
+
+# 8-bit quantization alone allows about half a level of error per channel.
+rmse_threshold = 1.0
+
+reference_image = cv.imread(reference_image_path)
+reconstructed_image = cv.imread(reconstructed_image_path)
+
+assert reference_image is not None and reconstructed_image is not None, "Screenshots are not found!"
+assert reference_image.shape == reconstructed_image.shape, "Shape is not same!"
+
+_mse = mse(reference_image, reconstructed_image)
+_rmse = np.sqrt(_mse)
+
+diff_image = cv.absdiff(reference_image, reconstructed_image)
+cv.imwrite(diff_image_path, diff_image)
+
+print("MSE: " + str(_mse))
+print("RMSE: " + str(_rmse))
+print("Max difference: " + str(np.max(diff_image)))
+print("PASS" if _rmse <= rmse_threshold else "FAIL")
\ No newline at end of file
@@ -90,33 +90,31 @@ void Renderer::Initialize()
 	BuildMaterials();
 
 	// Create vertex and fragment shader
+	mProgramCache.Initialize(mShaderCacheDirectoryName, (GLADloadproc)glfwGetProcAddress);
 
 	Shader opaqueVertexShader;
 	Shader opaqueFragmentShader;
-	std::vector<uint32_t> opaqueShaderIDs;
-	opaqueVertexShader.CompileShader(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
-	opaqueFragmentShader.CompileShader(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
-	opaqueShaderIDs.push_back(opaqueVertexShader.GetShaderID());
-	opaqueShaderIDs.push_back(opaqueFragmentShader.GetShaderID());
-	LinkPrograms("opaque", opaqueShaderIDs);
-
-	Shader pbrVertexShader;
-	Shader pbrFragmentShader;
-	std::vector<uint32_t> pbrShaderIDs;
-	pbrVertexShader.CompileShader(mShaderDirectoryName + "pbr.vert", GL_VERTEX_SHADER);
-	pbrFragmentShader.CompileShader(mShaderDirectoryName + "pbr.frag", GL_FRAGMENT_SHADER);
-	pbrShaderIDs.push_back(pbrVertexShader.GetShaderID());
-	pbrShaderIDs.push_back(pbrFragmentShader.GetShaderID());
-	LinkPrograms("pbr", pbrShaderIDs);
+	std::vector<Shader*> opaqueShaders;
+	opaqueVertexShader.LoadShaderCode(mShaderDirectoryName + "opaque.vert", GL_VERTEX_SHADER);
+	opaqueFragmentShader.LoadShaderCode(mShaderDirectoryName + "opaque.frag", GL_FRAGMENT_SHADER);
+	opaqueShaders.push_back(&opaqueVertexShader);
+	opaqueShaders.push_back(&opaqueFragmentShader);
+	LinkPrograms("opaque", opaqueShaders);
+
+	// pbr variants are specialized per feature mask on first use.
+	mPBRPermutation.Initialize(&mProgramCache, "pbr",
+		mShaderDirectoryName + "pbr.vert", mShaderDirectoryName + "pbr.frag");
 
 	Shader cubeMapVertexShader;
 	Shader cubeMapFragmentShader;
-	std::vector<uint32_t> cubeMapShaderIDs;
-	cubeMapVertexShader.CompileShader(mShaderDirectoryName + "cubemap.vert", GL_VERTEX_SHADER);
-	cubeMapFragmentShader.CompileShader(mShaderDirectoryName + "cubemap.frag", GL_FRAGMENT_SHADER);
-	cubeMapShaderIDs.push_back(cubeMapVertexShader.GetShaderID());
-	cubeMapShaderIDs.push_back(cubeMapFragmentShader.GetShaderID());
-	LinkPrograms("cubeMap", cubeMapShaderIDs);
+	std::vector<Shader*> cubeMapShaders;
+	cubeMapVertexShader.LoadShaderCode(mShaderDirectoryName + "cubemap.vert", GL_VERTEX_SHADER);
+	cubeMapFragmentShader.LoadShaderCode(mShaderDirectoryName + "cubemap.frag", GL_FRAGMENT_SHADER);
+	cubeMapShaders.push_back(&cubeMapVertexShader);
+	cubeMapShaders.push_back(&cubeMapFragmentShader);
+	LinkPrograms("cubeMap", cubeMapShaders);
+
+	mProgramCache.BuildPrograms(mProgramIDs);
 
 	BuildRenderItems();
 }
@@ -255,7 +253,14 @@ void Renderer::DrawScene()
 	// glEnable(GL_CULL_FACE);
 	// glCullFace(GL_BACK);
 
-	auto currentProgramID = mProgramIDs["pbr"];
+	// this engine has its own Menu, so the feature mask is built here.
+	uint32_t featureMask = 0;
+	if (mMenu.isUsingTexture)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::Texture);
+	if (mMenu.isUsingNormalMap)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::NormalMap);
+
+	auto currentProgramID = mPBRPermutation.GetProgram(featureMask);
 	DrawRenderItems(RenderLayer::PBR, currentProgramID);
 
 	currentProgramID = mProgramIDs["cubeMap"];
@@ -359,19 +364,10 @@ void Renderer::InitializeSceneConstant()
 	mSceneConstant.pointLights[0].diffuse = glm::vec3(150.0f, 150.0f, 150.0f);
 }
 
-void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs)
+void Renderer::LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders)
 {
-	uint32_t programID = glCreateProgram();
-
-	for (const auto& shaderID : shaderIDs)
-		glAttachShader(programID, shaderID);
-	glLinkProgram(programID);
-	CheckCompileErrors(programID, "PROGRAM");
-
-	for (const auto& shaderID : shaderIDs)
-		glDetachShader(programID, shaderID);
-
-	mProgramIDs.insert({ shaderName, programID });
+	// linked later by mProgramCache.BuildPrograms, which tries the cached binary first.
+	mProgramCache.RequestProgram(shaderName, shaders);
 }
 void Renderer::UseProgram(uint32_t programID)
 {
@@ -475,9 +471,6 @@ void Renderer::DrawRenderItems(RenderLayer renderLayer, uint32_t programID, bool
 
 	UseProgram(programID);
 
-	SetBool(programID, "isUsingTexture", mMenu.isUsingTexture);
-	SetBool(programID, "isUsingNormalMap", mMenu.isUsingNormalMap);
-
 	SetMat4(programID, "sceneConstant.view", mSceneConstant.view);
 	SetMat4(programID, "sceneConstant.projection", mSceneConstant.projection);
 	SetVec3(programID, "sceneConstant.cameraPos", mSceneConstant.cameraPos);
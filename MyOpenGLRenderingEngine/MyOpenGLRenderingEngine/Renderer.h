@@ -4,7 +4,9 @@
 #include "../../cores/Framebuffer.h"
 #include "../../cores/Mesh.h"
 #include "../../cores/Model.h"
+#include "../../cores/ProgramCache.h"
 #include "../../cores/Shader.h"
+#include "../../cores/ShaderPermutation.h"
 #include "../../cores/Stdafx.h"
 #include "../../cores/Texture.h"
 #include "../../cores/Utility.h"
@@ -97,7 +99,7 @@ private:
 
 	void InitializeSceneConstant();
 
-	void LinkPrograms(const std::string& shaderName, const std::vector<uint32_t>& shaderIDs);
+	void LinkPrograms(const std::string& shaderName, const std::vector<Shader*>& shaders);
 	void UseProgram(uint32_t programID);
 
 	void BuildRenderItems();
@@ -116,6 +118,8 @@ private:
 	static Renderer* renderer;
 
 	std::unordered_map<std::string, uint32_t> mProgramIDs;
+	ProgramCache mProgramCache;
+	ShaderPermutation mPBRPermutation;
 
 	Camera mCamera;
 
@@ -138,6 +142,7 @@ private:
 	std::unordered_map<RenderLayer, std::vector<RenderItem>> mAllRenderItems;
 
 	std::string mShaderDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\";
+	std::string mShaderCacheDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\shaders\\cache\\";
 	std::string mTextureDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\textures\\";
 	std::string mModelDirectoryName = "E:\\SeoulTech_CG_Lab_projects\\resources\\models\\";
 
@@ -0,0 +1,212 @@
+#include "BrdfLookUpTable.h"
+
+namespace
+{
+	// same sequence and integrand as brdf.frag, so the baked and rendered tables agree.
+	float RadicalInverse_VdC(uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	float GeometrySchlickGGX(float NdotV, float roughness)
+	{
+		float k = (roughness * roughness) / 2.0f;
+		return NdotV / (NdotV * (1.0f - k) + k);
+	}
+
+	glm::vec2 IntegrateBRDF(float NdotV, float roughness, uint32_t sampleCount)
+	{
+		glm::vec3 V = glm::vec3(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+		float a = roughness * roughness;
+
+		float A = 0.0f;
+		float B = 0.0f;
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			float phi = 2.0f * glm::pi<float>() * static_cast<float>(i) / static_cast<float>(sampleCount);
+			float Xi = RadicalInverse_VdC(i);
+			float cosTheta = std::sqrt((1.0f - Xi) / (1.0f + (a * a - 1.0f) * Xi));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+			// tangent frame of N = +z used by ImportanceSampleGGX.
+			glm::vec3 H = glm::vec3(std::sin(phi) * sinTheta, -std::cos(phi) * sinTheta, cosTheta);
+			glm::vec3 L = glm::normalize(2.0f * glm::dot(V, H) * H - V);
+
+			float NdotL = glm::max(L.z, 0.0f);
+			float NdotH = glm::max(H.z, 0.0f);
+			float VdotH = glm::max(glm::dot(V, H), 0.0f);
+			if (NdotL > 0.0f)
+			{
+				float G = GeometrySchlickGGX(NdotV, roughness) * GeometrySchlickGGX(NdotL, roughness);
+				float G_Vis = (G * VdotH) / (NdotH * NdotV);
+				float Fc = std::pow(1.0f - VdotH, 5.0f);
+				A += (1.0f - Fc) * G_Vis;
+				B += Fc * G_Vis;
+			}
+		}
+
+		return glm::vec2(A, B) / static_cast<float>(sampleCount);
+	}
+}
+
+void BrdfLookUpTable::Initialize(uint32_t programID, uint32_t size, const std::string& binaryFileName)
+{
+	mProgramID = programID;
+	mSize = size;
+	mBinaryFileName = binaryFileName;
+}
+void BrdfLookUpTable::DeleteBrdfLookUpTable()
+{
+	if (mIsCreated)
+		mTexture.DeleteTexture();
+	mIsCreated = false;
+}
+
+Texture* BrdfLookUpTable::GetTexture()
+{
+	if (!mIsCreated)
+	{
+		mTexture.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false, true, mSize, mSize, GL_RG16F, GL_RG);
+		mIsCreated = true;
+
+		if (!LoadFromFile())
+		{
+			Render();
+			SaveToFile();
+		}
+	}
+
+	return &mTexture;
+}
+bool BrdfLookUpTable::IsCreated()
+{
+	return mIsCreated;
+}
+
+bool BrdfLookUpTable::BakeBrdfLookUpTable(const std::string& binaryFileName, uint32_t size, uint32_t sampleCount)
+{
+	std::vector<uint16_t> texels(2 * size * size);
+
+	// rows are independent, split them over the hardware threads.
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			for (uint32_t y = t; y < size; y += threadCount)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					// texel centers, x is NdotV and y is roughness like the quad texcoords of brdf.frag.
+					float NdotV = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+					float roughness = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+					glm::vec2 brdf = IntegrateBRDF(NdotV, roughness, sampleCount);
+
+					uint32_t index = 2 * (y * size + x);
+					texels[index] = glm::packHalf1x16(brdf.x);
+					texels[index + 1] = glm::packHalf1x16(brdf.y);
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	std::ofstream file(binaryFileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write BRDF look-up table: " << binaryFileName << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&mFileMagic), sizeof(mFileMagic));
+	file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint16_t));
+	return true;
+}
+
+bool BrdfLookUpTable::LoadFromFile()
+{
+	if (mBinaryFileName.empty())
+		return false;
+
+	std::ifstream file(mBinaryFileName, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	uint32_t magic = 0;
+	uint32_t size = 0;
+	file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char*>(&size), sizeof(size));
+	if (!file || magic != mFileMagic || size != mSize)
+		return false;
+
+	std::vector<uint16_t> texels(2 * size * size);
+	file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(uint16_t));
+	if (!file)
+		return false;
+
+	glBindTexture(GL_TEXTURE_2D, mTexture.GetTexture());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RG, GL_HALF_FLOAT, texels.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void BrdfLookUpTable::Render()
+{
+	if (mProgramID == 0)
+	{
+		std::cout << "ERROR::BRDF_LOOK_UP_TABLE:: No binary and no program to render it!" << std::endl;
+		return;
+	}
+
+	BasicGeometryGenerator geoGenerator;
+	Mesh quad = geoGenerator.CreateQuad(-1.0f, -1.0f, 2.0f, 2.0f, 0.0f);
+	quad.ConfigureMesh();
+
+	Framebuffer framebuffer;
+	framebuffer.CreateFramebuffer(mSize, mSize, 0, false, false);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.GetFramebuffer());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture.GetTexture(), 0);
+	glViewport(0, 0, mSize, mSize);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glUseProgram(mProgramID);
+	glBindVertexArray(quad.GetVertexAttribArray());
+	glDrawElements(quad.GetPrimitiveType(), quad.GetIndexCount(), quad.GetIndexFormat(), nullptr);
+	glBindVertexArray(0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	framebuffer.DeleteFramebuffer();
+	quad.DeleteMesh();
+}
+
+void BrdfLookUpTable::SaveToFile()
+{
+	if (mBinaryFileName.empty() || mProgramID == 0)
+		return;
+
+	std::vector<uint16_t> texels(2 * mSize * mSize);
+	glBindTexture(GL_TEXTURE_2D, mTexture.GetTexture());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_HALF_FLOAT, texels.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	std::ofstream file(mBinaryFileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write BRDF look-up table: " << mBinaryFileName << std::endl;
+		return;
+	}
+
+	file.write(reinterpret_cast<const char*>(&mFileMagic), sizeof(mFileMagic));
+	file.write(reinterpret_cast<const char*>(&mSize), sizeof(mSize));
+	file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint16_t));
+}
\ No newline at end of file
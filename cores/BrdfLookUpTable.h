@@ -0,0 +1,37 @@
+#pragma once
+#include "BasicGeometryGenerator.h"
+#include "Framebuffer.h"
+#include "Mesh.h"
+#include "Stdafx.h"
+#include "Texture.h"
+
+// split-sum BRDF look-up table, independent of the environment so every image based light can share one.
+// created on the first GetTexture: loaded from the binary file if present, otherwise rendered with brdf.frag and saved.
+class BrdfLookUpTable
+{
+public:
+	BrdfLookUpTable() = default;
+
+	void Initialize(uint32_t programID, uint32_t size, const std::string& binaryFileName);
+	void DeleteBrdfLookUpTable();
+
+	Texture* GetTexture();
+	bool IsCreated();
+
+	// integrates the table on the cpu and writes the binary, so it can be baked offline and shipped.
+	static bool BakeBrdfLookUpTable(const std::string& binaryFileName, uint32_t size, uint32_t sampleCount = 1024);
+private:
+	bool LoadFromFile();
+	void Render();
+	void SaveToFile();
+private:
+	uint32_t mProgramID = 0;
+	uint32_t mSize = 512;
+	std::string mBinaryFileName;
+
+	Texture mTexture;
+	bool mIsCreated = false;
+
+	// file layout: magic, size, then size * size RG half floats in GL row order.
+	static constexpr uint32_t mFileMagic = 0x54554C42; // "BLUT"
+};
\ No newline at end of file
@@ -8,6 +8,7 @@ Camera::Camera()
 {
 	mView = glm::mat4(1.0f);
 	mProjection = glm::mat4(1.0f);
+	mReversedProjection = glm::mat4(1.0f);
 }
 
 vec3 Camera::GetPosition()
@@ -44,11 +45,32 @@ mat4 Camera::GetProjection()
 {
 	return mProjection;
 }
+mat4 Camera::GetReversedProjection()
+{
+	return mReversedProjection;
+}
 glm::mat4 Camera::GetOrthoProjection()
 {
 	return mOrthoProjection;
 }
 
+float Camera::GetNearZ()
+{
+	return mNearZ;
+}
+float Camera::GetFarZ()
+{
+	return mFarZ;
+}
+float Camera::GetFovAngleY()
+{
+	return mFovAngleY;
+}
+float Camera::GetAspectRatio()
+{
+	return mAspectRatio;
+}
+
 void Camera::LookAt(
 	const vec3& position,
 	const vec3& target,
@@ -84,6 +106,8 @@ void Camera::SetLens(float fovAngleY, float aspectRatio, float zn, float zf)
 	mFarZ = zf;
 
 	mProjection = glm::perspective(fovAngleY, aspectRatio, zn, zf);
+	// swapping the planes of a zero-to-one projection maps the near plane to 1 and the far plane to 0.
+	mReversedProjection = glm::perspectiveRH_ZO(fovAngleY, aspectRatio, zf, zn);
 }
 
 void Camera::SetOrthoLens(
@@ -16,8 +16,14 @@ public:
 
 	glm::mat4 GetView();
 	glm::mat4 GetProjection();
+	glm::mat4 GetReversedProjection(); // zero-to-one clip depth, near plane at 1 and far plane at 0
 	glm::mat4 GetOrthoProjection();
 
+	float GetNearZ();
+	float GetFarZ();
+	float GetFovAngleY();
+	float GetAspectRatio();
+
 	void LookAt(
 		const glm::vec3& position,
 		const glm::vec3& target,
@@ -71,5 +77,6 @@ private:
 
 	glm::mat4 mView;
 	glm::mat4 mProjection;
+	glm::mat4 mReversedProjection;
 	glm::mat4 mOrthoProjection;
 };
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "CascadedShadowMap.h"
+
+void CascadedShadowMap::CreateCascadedShadowMap(uint32_t resolution, uint32_t cascadeCount)
+{
+	mResolution = resolution;
+	mCascadeCount = glm::min(cascadeCount, maxCascadeCount);
+	mIsStaticPageValid.fill(false);
+
+	TextureInfo shadowMapInfo;
+	shadowMapInfo.wrapSType = GL_CLAMP_TO_BORDER;
+	shadowMapInfo.wrapTType = GL_CLAMP_TO_BORDER;
+	shadowMapInfo.minFilterType = GL_NEAREST;
+	shadowMapInfo.magFilterType = GL_NEAREST;
+	shadowMapInfo.isMipmap = false;
+	shadowMapInfo.nullData = true;
+	shadowMapInfo.isBorderColor = true;
+	shadowMapInfo.borderColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+	shadowMapInfo.width = resolution;
+	shadowMapInfo.height = resolution;
+	shadowMapInfo.textureInternalFormat = GL_DEPTH_COMPONENT32F;
+	shadowMapInfo.textureFormat = GL_DEPTH_COMPONENT;
+	mStaticShadowMapArray.CreateHDRTexture2DArray(shadowMapInfo, mCascadeCount);
+	mShadowMapArray.CreateHDRTexture2DArray(shadowMapInfo, mCascadeCount);
+
+	// layers are attached per page in Begin*Page.
+	mShadowMapFramebuffer.CreateFramebuffer(resolution, resolution, 0, false, false);
+	glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFramebuffer.GetFramebuffer());
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+void CascadedShadowMap::DeleteCascadedShadowMap()
+{
+	mStaticShadowMapArray.DeleteTexture();
+	mShadowMapArray.DeleteTexture();
+	mShadowMapFramebuffer.DeleteFramebuffer();
+}
+
+void CascadedShadowMap::UpdateCascades(Camera& camera, const glm::vec3& lightDirection)
+{
+	float nearZ = camera.GetNearZ();
+	float farZ = glm::min(camera.GetFarZ(), mMaxShadowDistance);
+	float tanHalfFovY = std::tan(camera.GetFovAngleY() * 0.5f);
+	float aspectRatio = camera.GetAspectRatio();
+
+	glm::vec3 cameraPos = camera.GetPosition();
+	glm::vec3 front = camera.GetFront();
+	glm::vec3 right = camera.GetRight();
+	glm::vec3 up = camera.GetUp();
+
+	// light view is anchored at the world origin so snapping happens on a fixed grid.
+	glm::vec3 direction = glm::normalize(lightDirection);
+	glm::vec3 lightUp = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, lightUp);
+
+	float splitNear = nearZ;
+	for (uint32_t i = 0; i < mCascadeCount; i++)
+	{
+		// practical split scheme
+		float ratio = static_cast<float>(i + 1) / static_cast<float>(mCascadeCount);
+		float logSplit = nearZ * std::pow(farZ / nearZ, ratio);
+		float uniformSplit = nearZ + (farZ - nearZ) * ratio;
+		float splitFar = mSplitLambda * logSplit + (1.0f - mSplitLambda) * uniformSplit;
+		mCascadeSplits[i] = splitFar;
+
+		std::array<glm::vec3, 8> corners;
+		uint32_t cornerIndex = 0;
+		for (float depth : { splitNear, splitFar })
+		{
+			float halfHeight = depth * tanHalfFovY;
+			float halfWidth = halfHeight * aspectRatio;
+			glm::vec3 center = cameraPos + front * depth;
+			corners[cornerIndex++] = center - right * halfWidth - up * halfHeight;
+			corners[cornerIndex++] = center + right * halfWidth - up * halfHeight;
+			corners[cornerIndex++] = center - right * halfWidth + up * halfHeight;
+			corners[cornerIndex++] = center + right * halfWidth + up * halfHeight;
+		}
+
+		glm::vec3 sphereCenter = glm::vec3(0.0f);
+		for (const auto& corner : corners)
+			sphereCenter += corner;
+		sphereCenter /= 8.0f;
+
+		float radius = 0.0f;
+		for (const auto& corner : corners)
+			radius = glm::max(radius, glm::length(corner - sphereCenter));
+		// the radius only depends on the lens, rounding removes float noise between frames.
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// one page of padding on each side keeps the sphere inside after snapping.
+		float texelSize = 2.0f * radius / static_cast<float>(mResolution - 2 * mPageTexelCount);
+		float pageSize = texelSize * static_cast<float>(mPageTexelCount);
+		float halfExtent = radius + pageSize;
+
+		glm::vec3 lightSpaceCenter = glm::vec3(lightView * glm::vec4(sphereCenter, 1.0f));
+		lightSpaceCenter = glm::floor(lightSpaceCenter / pageSize) * pageSize;
+
+		float depthExtent = radius + pageSize + mCasterDepthMargin;
+		glm::mat4 lightProjection = glm::ortho(
+			lightSpaceCenter.x - halfExtent, lightSpaceCenter.x + halfExtent,
+			lightSpaceCenter.y - halfExtent, lightSpaceCenter.y + halfExtent,
+			-lightSpaceCenter.z - depthExtent, -lightSpaceCenter.z + depthExtent);
+		mCascadeMatrices[i] = lightProjection * lightView;
+
+		splitNear = splitFar;
+	}
+}
+
+void CascadedShadowMap::InvalidateStaticCache()
+{
+	mIsStaticPageValid.fill(false);
+}
+void CascadedShadowMap::TrackStaticCasters(const std::vector<RenderItem>& renderItems, const glm::vec3& lightDirection)
+{
+	// a light that turns also moves the cascade matrices, but a caster moving within its page would not.
+	bool isChanged = lightDirection != mStaticLightDirection;
+	mStaticLightDirection = lightDirection;
+
+	size_t staticCasterCount = 0;
+	for (const auto& renderItem : renderItems)
+	{
+		if (!renderItem.isStaticShadowCaster)
+			continue;
+
+		if (staticCasterCount == mStaticCasterWorlds.size())
+		{
+			mStaticCasterWorlds.push_back(renderItem.world);
+			isChanged = true;
+		}
+		else if (mStaticCasterWorlds[staticCasterCount] != renderItem.world)
+		{
+			mStaticCasterWorlds[staticCasterCount] = renderItem.world;
+			isChanged = true;
+		}
+		staticCasterCount++;
+	}
+	if (staticCasterCount != mStaticCasterWorlds.size())
+	{
+		mStaticCasterWorlds.resize(staticCasterCount);
+		isChanged = true;
+	}
+
+	if (isChanged)
+		InvalidateStaticCache();
+}
+
+bool CascadedShadowMap::IsStaticPageDirty(uint32_t cascadeIndex)
+{
+	return !mIsStaticPageValid[cascadeIndex] || mStaticPageMatrices[cascadeIndex] != mCascadeMatrices[cascadeIndex];
+}
+void CascadedShadowMap::BeginStaticPage(uint32_t cascadeIndex)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFramebuffer.GetFramebuffer());
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mStaticShadowMapArray.GetTexture(), 0, cascadeIndex);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+void CascadedShadowMap::EndStaticPage(uint32_t cascadeIndex)
+{
+	mStaticPageMatrices[cascadeIndex] = mCascadeMatrices[cascadeIndex];
+	mIsStaticPageValid[cascadeIndex] = true;
+}
+
+void CascadedShadowMap::BeginDynamicPage(uint32_t cascadeIndex)
+{
+	// start from the cached static casters instead of a cleared page.
+	glCopyImageSubData(
+		mStaticShadowMapArray.GetTexture(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascadeIndex,
+		mShadowMapArray.GetTexture(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascadeIndex,
+		mResolution, mResolution, 1);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFramebuffer.GetFramebuffer());
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mShadowMapArray.GetTexture(), 0, cascadeIndex);
+}
+
+void CascadedShadowMap::BindCascadedShadowMap(uint32_t programID, uint32_t textureUnit)
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMapArray.GetTexture());
+	SetInt(programID, "cascadedShadowMap", textureUnit);
+
+	for (uint32_t i = 0; i < mCascadeCount; i++)
+	{
+		SetMat4(programID, "cascadeMatrices[" + std::to_string(i) + "]", mCascadeMatrices[i]);
+		SetFloat(programID, "cascadeSplits[" + std::to_string(i) + "]", mCascadeSplits[i]);
+	}
+	SetInt(programID, "cascadeCount", static_cast<int>(mCascadeCount));
+}
+
+uint32_t CascadedShadowMap::GetCascadeCount()
+{
+	return mCascadeCount;
+}
+uint32_t CascadedShadowMap::GetResolution()
+{
+	return mResolution;
+}
+glm::mat4 CascadedShadowMap::GetCascadeMatrix(uint32_t cascadeIndex)
+{
+	return mCascadeMatrices[cascadeIndex];
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "Stdafx.h"
+#include "Texture.h"
+#include "Utility.h"
+
+// cascaded shadow map of one directional light.
+// cascades are bounding spheres of the camera frustum slices, snapped to whole shadow pages in light space,
+// so a cascade matrix only changes when the camera crosses a page or the light turns.
+// static casters are rendered into a cached page per cascade and copied under the dynamic casters every frame.
+class CascadedShadowMap
+{
+public:
+	CascadedShadowMap() = default;
+
+	void CreateCascadedShadowMap(uint32_t resolution, uint32_t cascadeCount);
+	void DeleteCascadedShadowMap();
+
+	void UpdateCascades(Camera& camera, const glm::vec3& lightDirection);
+
+	// call when a static caster is added, removed or moved.
+	void InvalidateStaticCache();
+	// once per frame, invalidates the static pages when the light or a static caster changed since the last call.
+	void TrackStaticCasters(const std::vector<RenderItem>& renderItems, const glm::vec3& lightDirection);
+
+	// static page: rendered only when dirty, holds static casters.
+	bool IsStaticPageDirty(uint32_t cascadeIndex);
+	void BeginStaticPage(uint32_t cascadeIndex);
+	void EndStaticPage(uint32_t cascadeIndex);
+
+	// sampled page: the cached static page plus the dynamic casters of this frame.
+	void BeginDynamicPage(uint32_t cascadeIndex);
+
+	// binds the cascade array and sets the cascade uniforms of a shading program.
+	void BindCascadedShadowMap(uint32_t programID, uint32_t textureUnit);
+
+	uint32_t GetCascadeCount();
+	uint32_t GetResolution();
+	glm::mat4 GetCascadeMatrix(uint32_t cascadeIndex);
+
+	static constexpr uint32_t maxCascadeCount = 4;
+private:
+	uint32_t mResolution = 0;
+	uint32_t mCascadeCount = 0;
+
+	Texture mStaticShadowMapArray;
+	Texture mShadowMapArray;
+	Framebuffer mShadowMapFramebuffer;
+
+	std::array<glm::mat4, maxCascadeCount> mCascadeMatrices;
+	std::array<float, maxCascadeCount> mCascadeSplits; // far view depth of each cascade
+
+	std::array<glm::mat4, maxCascadeCount> mStaticPageMatrices; // matrices the static pages were rendered with
+	std::array<bool, maxCascadeCount> mIsStaticPageValid;
+	std::vector<glm::mat4> mStaticCasterWorlds; // worlds of the static casters the pages were rendered with
+	glm::vec3 mStaticLightDirection = glm::vec3(0.0f);
+
+	float mSplitLambda = 0.75f; // blend between logarithmic and uniform splits
+	float mMaxShadowDistance = 50.0f;
+	float mCasterDepthMargin = 50.0f; // casters behind the cascade sphere along the light direction
+
+	// cascade centers are snapped to this many texels, a multiple of one texel keeps the edges from shimmering.
+	static constexpr uint32_t mPageTexelCount = 64;
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "ClusteredLighting.h"
+
+// SSBO binding points, must match the shaders.
+static constexpr uint32_t lightBufferBinding = 0;
+static constexpr uint32_t lightGridBufferBinding = 1;
+static constexpr uint32_t lightIndexBufferBinding = 2;
+
+// clusters per work group of lightCulling.comp, the cluster counts are whole multiples of them.
+static constexpr uint32_t tileSizeX = 4;
+static constexpr uint32_t tileSizeY = 3;
+static constexpr uint32_t tileSizeZ = 4;
+
+void ClusteredLighting::CreateClusteredLighting(uint32_t maxLightCount)
+{
+	mMaxLightCount = maxLightCount;
+	mLights.reserve(maxLightCount);
+
+	glGenBuffers(1, &mLightBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mLightBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ClusteredLight) * maxLightCount, nullptr, GL_DYNAMIC_DRAW);
+
+	// one (offset, count) pair per cluster.
+	glGenBuffers(1, &mLightGridBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mLightGridBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t) * 2 * clusterCount, nullptr, GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &mLightIndexBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mLightIndexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t) * lightIndexCapacity, nullptr, GL_DYNAMIC_COPY);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+void ClusteredLighting::DeleteClusteredLighting()
+{
+	glDeleteBuffers(1, &mLightBuffer);
+	glDeleteBuffers(1, &mLightGridBuffer);
+	glDeleteBuffers(1, &mLightIndexBuffer);
+}
+
+void ClusteredLighting::UpdateLights(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights)
+{
+	mLights.clear();
+
+	for (const auto& pointLight : pointLights)
+	{
+		if (mLights.size() == mMaxLightCount)
+			break;
+
+		ClusteredLight light{};
+		light.positionRange = glm::vec4(pointLight.position, CalculateLightRange(pointLight.diffuse));
+		light.colorType = glm::vec4(pointLight.diffuse, 0.0f);
+		mLights.push_back(light);
+	}
+
+	for (const auto& spotLight : spotLights)
+	{
+		if (mLights.size() == mMaxLightCount)
+			break;
+
+		ClusteredLight light{};
+		light.positionRange = glm::vec4(spotLight.position, CalculateLightRange(spotLight.diffuse));
+		light.colorType = glm::vec4(spotLight.diffuse, 1.0f);
+		light.directionCutOff = glm::vec4(glm::normalize(spotLight.direction), spotLight.cutOff);
+		light.outerCutOff = glm::vec4(spotLight.outerCutOff, 0.0f, 0.0f, 0.0f);
+		mLights.push_back(light);
+	}
+
+	if (mLights.empty())
+		return;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mLightBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ClusteredLight) * mLights.size(), mLights.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ClusteredLighting::CullLights(uint32_t programID, const glm::mat4& view, const glm::mat4& projection,
+	float nearZ, float farZ, uint32_t screenWidth, uint32_t screenHeight)
+{
+	mNearZ = nearZ;
+	mFarZ = farZ;
+	mScreenSize = glm::vec2(static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+
+	glUseProgram(programID);
+
+	SetMat4(programID, "view", view);
+	SetMat4(programID, "invProjection", glm::inverse(projection));
+	SetFloat(programID, "nearZ", nearZ);
+	SetFloat(programID, "farZ", farZ);
+	SetInt(programID, "lightCount", static_cast<int>(mLights.size()));
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightBufferBinding, mLightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightGridBufferBinding, mLightGridBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightIndexBufferBinding, mLightIndexBuffer);
+
+	// one work group per tile of clusters, one invocation per cluster.
+	glDispatchCompute(clusterCountX / tileSizeX, clusterCountY / tileSizeY, clusterCountZ / tileSizeZ);
+
+	// the shading pass reads the grid and index list written above.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusteredLighting::BindClusteredLighting(uint32_t programID)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightBufferBinding, mLightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightGridBufferBinding, mLightGridBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lightIndexBufferBinding, mLightIndexBuffer);
+
+	SetFloat(programID, "clusterNearZ", mNearZ);
+	SetFloat(programID, "clusterFarZ", mFarZ);
+	SetVec2(programID, "clusterScreenSize", mScreenSize);
+}
+
+uint32_t ClusteredLighting::GetLightCount()
+{
+	return static_cast<uint32_t>(mLights.size());
+}
+
+float ClusteredLighting::CalculateLightRange(const glm::vec3& diffuse)
+{
+	// inverse-square falloff reaches the cut-off intensity at sqrt(I / cutOff).
+	float intensity = std::max(diffuse.r, std::max(diffuse.g, diffuse.b));
+	return std::sqrt(intensity / mLightCutOffIntensity);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include "Stdafx.h"
+#include "Utility.h"
+
+// std430 layout shared with lightCulling.comp, pbr.frag and pbr_deferred.frag.
+struct ClusteredLight
+{
+	glm::vec4 positionRange; // xyz: world position, w: range
+	glm::vec4 colorType; // rgb: diffuse, w: 0 point light, 1 spot light
+	glm::vec4 directionCutOff; // xyz: spot direction, w: cosine of inner cut-off
+	glm::vec4 outerCutOff; // x: cosine of outer cut-off
+};
+
+class ClusteredLighting
+{
+public:
+	ClusteredLighting() = default;
+
+	void CreateClusteredLighting(uint32_t maxLightCount);
+	void DeleteClusteredLighting();
+
+	// lights are dynamic, so the whole list is re-uploaded every frame.
+	void UpdateLights(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights);
+
+	// bins the uploaded lights into view-space clusters with lightCulling.comp, one work group per tile of clusters.
+	void CullLights(uint32_t programID, const glm::mat4& view, const glm::mat4& projection,
+		float nearZ, float farZ, uint32_t screenWidth, uint32_t screenHeight);
+
+	// binds the light, grid and index buffers and sets the cluster uniforms of a shading program.
+	void BindClusteredLighting(uint32_t programID);
+
+	uint32_t GetLightCount();
+
+	static constexpr uint32_t clusterCountX = 16;
+	static constexpr uint32_t clusterCountY = 9;
+	static constexpr uint32_t clusterCountZ = 24;
+	static constexpr uint32_t clusterCount = clusterCountX * clusterCountY * clusterCountZ;
+	static constexpr uint32_t maxLightsPerCluster = 256;
+	static constexpr uint32_t lightIndexCapacity = clusterCount * maxLightsPerCluster; // fixed range per cluster
+private:
+	static float CalculateLightRange(const glm::vec3& diffuse);
+private:
+	uint32_t mLightBuffer = 0;
+	uint32_t mLightGridBuffer = 0;
+	uint32_t mLightIndexBuffer = 0;
+
+	uint32_t mMaxLightCount = 0;
+	std::vector<ClusteredLight> mLights;
+
+	float mNearZ = 0.1f;
+	float mFarZ = 100.0f;
+	glm::vec2 mScreenSize = glm::vec2(1.0f, 1.0f);
+
+	// intensity under which a light is treated as out of range.
+	static constexpr float mLightCutOffIntensity = 0.05f;
+};
\ No newline at end of file
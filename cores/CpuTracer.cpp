@@ -0,0 +1,132 @@
+#include "CpuTracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+	struct CpuTraceEvent
+	{
+		const char* name;
+		uint64_t beginTicks;
+		uint64_t endTicks;
+	};
+
+	// 1,440 sweep frames with a dozen zones each fit without wrapping.
+	constexpr uint32_t ringCapacity = 1 << 16;
+
+	struct CpuTraceRing
+	{
+		std::vector<CpuTraceEvent> events = std::vector<CpuTraceEvent>(ringCapacity);
+		std::atomic<uint64_t> writeCount = 0;
+		uint32_t threadIndex = 0;
+	};
+
+	// rings are only registered here, never removed, so zones of finished threads can still be exported.
+	std::mutex ringMutex;
+	std::vector<std::unique_ptr<CpuTraceRing>> rings;
+
+	// rdtsc is converted to microseconds against steady_clock between this anchor and the export.
+	uint64_t anchorTicks = 0;
+	std::chrono::steady_clock::time_point anchorTime;
+	std::once_flag anchorFlag;
+
+	uint64_t ReadTicks()
+	{
+		return __rdtsc();
+	}
+
+	CpuTraceRing* GetThreadRing()
+	{
+		thread_local CpuTraceRing* threadRing = nullptr;
+		if (threadRing != nullptr)
+			return threadRing;
+
+		std::call_once(anchorFlag, []()
+		{
+			anchorTime = std::chrono::steady_clock::now();
+			anchorTicks = ReadTicks();
+		});
+
+		std::lock_guard<std::mutex> lock(ringMutex);
+		rings.push_back(std::make_unique<CpuTraceRing>());
+		threadRing = rings.back().get();
+		threadRing->threadIndex = static_cast<uint32_t>(rings.size());
+		return threadRing;
+	}
+}
+
+CpuTraceScope::CpuTraceScope(const char* name)
+	: mName(name)
+{
+	// the first zone of a thread registers its ring before the clock is read.
+	GetThreadRing();
+	mBeginTicks = ReadTicks();
+}
+CpuTraceScope::~CpuTraceScope()
+{
+	uint64_t endTicks = ReadTicks();
+
+	CpuTraceRing* ring = GetThreadRing();
+	uint64_t writeCount = ring->writeCount.load(std::memory_order_relaxed);
+	ring->events[writeCount % ringCapacity] = { mName, mBeginTicks, endTicks };
+	ring->writeCount.store(writeCount + 1, std::memory_order_release);
+}
+
+bool ExportCpuTraceToJSON(const std::string& fileName)
+{
+	std::lock_guard<std::mutex> lock(ringMutex);
+	if (rings.empty())
+		return false;
+
+	std::ofstream file(fileName);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open " << fileName << std::endl;
+		return false;
+	}
+
+	auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - anchorTime).count();
+	double ticksPerMicrosecond = static_cast<double>(ReadTicks() - anchorTicks) / std::max(elapsed, 1.0);
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool isFirstEvent = true;
+	for (const auto& ring : rings)
+	{
+		uint64_t writeCount = ring->writeCount.load(std::memory_order_acquire);
+		uint64_t firstEvent = writeCount > ringCapacity ? writeCount - ringCapacity : 0;
+
+		if (!isFirstEvent)
+			file << ",\n";
+		isFirstEvent = false;
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadIndex
+			<< ",\"args\":{\"name\":\"" << (ring->threadIndex == 1 ? "main" : "worker") << "\"}}";
+
+		for (uint64_t i = firstEvent; i < writeCount; i++)
+		{
+			const auto& event = ring->events[i % ringCapacity];
+			double begin = static_cast<double>(event.beginTicks - anchorTicks) / ticksPerMicrosecond;
+			double duration = static_cast<double>(event.endTicks - event.beginTicks) / ticksPerMicrosecond;
+
+			// zone names are string literals without quotes, so no escaping is done.
+			file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadIndex
+				<< ",\"ts\":" << std::fixed << std::setprecision(3) << begin << ",\"dur\":" << duration << "}";
+		}
+	}
+	file << "\n]}\n";
+
+	return true;
+}
+void ClearCpuTrace()
+{
+	std::lock_guard<std::mutex> lock(ringMutex);
+	for (auto& ring : rings)
+		ring->writeCount.store(0, std::memory_order_release);
+}
\ No newline at end of file
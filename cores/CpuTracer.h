@@ -0,0 +1,31 @@
+#pragma once
+#include "Stdafx.h"
+
+// scoped cpu zones recorded into per-thread ring buffers with rdtsc timestamps.
+// a zone costs two counter reads and one ring write, the rings are merged only on export.
+// define DISABLE_CPU_TRACE to compile every TRACE_CPU_ZONE away.
+#define CPU_TRACE_CONCAT_INNER(a, b) a##b
+#define CPU_TRACE_CONCAT(a, b) CPU_TRACE_CONCAT_INNER(a, b)
+
+#ifndef DISABLE_CPU_TRACE
+#define TRACE_CPU_ZONE(name) CpuTraceScope CPU_TRACE_CONCAT(cpuTraceScope, __LINE__)(name)
+#else
+#define TRACE_CPU_ZONE(name)
+#endif
+
+class CpuTraceScope
+{
+public:
+	explicit CpuTraceScope(const char* name); // name must outlive the trace, use string literals
+	~CpuTraceScope();
+	CpuTraceScope(const CpuTraceScope& rhs) = delete;
+	CpuTraceScope operator=(const CpuTraceScope& rhs) = delete;
+private:
+	const char* mName;
+	uint64_t mBeginTicks;
+};
+
+// writes every recorded zone as Chrome trace JSON (chrome://tracing, Perfetto).
+// call it while no other thread is recording, older zones are overwritten once a ring is full.
+bool ExportCpuTraceToJSON(const std::string& fileName);
+void ClearCpuTrace();
\ No newline at end of file
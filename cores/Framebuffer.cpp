@@ -26,17 +26,21 @@ void Framebuffer::CreateFramebuffer(uint32_t width, uint32_t height,
 		}
 	}
 	
-	mDepthStencilBuffer.CreateRenderbuffer(width, height, isStencilAttachment);
+	// Without a depth attachment, the caller attaches its own depth texture and checks completeness.
+	if (isDepthAttachment)
+	{
+		mDepthStencilBuffer.CreateRenderbuffer(width, height, isStencilAttachment);
 
-	// Check whether stencil buffer uses.
-	if (isStencilAttachment)
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthStencilBuffer.GetRenderbuffer());
-	else
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthStencilBuffer.GetRenderbuffer());
+		// Check whether stencil buffer uses.
+		if (isStencilAttachment)
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthStencilBuffer.GetRenderbuffer());
+		else
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthStencilBuffer.GetRenderbuffer());
 
-	// Check whether framebuffer completes.
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+		// Check whether framebuffer completes.
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
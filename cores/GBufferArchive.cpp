@@ -0,0 +1,504 @@
+#include "GBufferArchive.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t archiveMagic = 0x31414247; // "GBA1"
+	constexpr uint32_t archiveVersion = 1;
+	constexpr uint32_t mapNameLength = 32;
+
+	enum TileCodec : uint32_t
+	{
+		Raw = 0,
+		PlanarRLE = 1 // channels split into planes, then PackBits run-length coding
+	};
+
+	struct ArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mapCount;
+		uint32_t viewCount;
+		uint32_t tileRowCount;
+		uint32_t reserved;
+	};
+
+	// 40 bytes, so the tile table after the map and view tables stays 8-byte aligned in the mapping.
+	struct ArchiveMapEntry
+	{
+		char name[mapNameLength];
+		uint32_t channelCount;
+		uint32_t reserved;
+	};
+
+	// PackBits: n < 128 copies n + 1 literal bytes, n > 128 repeats the next byte 257 - n times.
+	void EncodeRLE(const uint8_t* source, size_t size, std::vector<uint8_t>& destination)
+	{
+		size_t i = 0;
+		while (i < size)
+		{
+			size_t run = 1;
+			while (i + run < size && run < 128 && source[i + run] == source[i])
+				run++;
+
+			if (run >= 3)
+			{
+				destination.push_back(static_cast<uint8_t>(257 - run));
+				destination.push_back(source[i]);
+				i += run;
+				continue;
+			}
+
+			// literals until the next run of three or the 128 byte limit
+			size_t literalStart = i;
+			size_t literalCount = 0;
+			while (i < size && literalCount < 128)
+			{
+				if (i + 2 < size && source[i] == source[i + 1] && source[i] == source[i + 2])
+					break;
+				i++;
+				literalCount++;
+			}
+			destination.push_back(static_cast<uint8_t>(literalCount - 1));
+			destination.insert(destination.end(), source + literalStart, source + literalStart + literalCount);
+		}
+	}
+
+	bool DecodeRLE(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t size)
+	{
+		size_t in = 0, out = 0;
+		while (in < sourceSize && out < size)
+		{
+			uint8_t n = source[in++];
+			if (n < 128)
+			{
+				size_t count = static_cast<size_t>(n) + 1;
+				if (in + count > sourceSize || out + count > size)
+					return false;
+				std::memcpy(destination + out, source + in, count);
+				in += count;
+				out += count;
+			}
+			else if (n > 128)
+			{
+				size_t count = 257 - static_cast<size_t>(n);
+				if (in >= sourceSize || out + count > size)
+					return false;
+				std::memset(destination + out, source[in++], count);
+				out += count;
+			}
+		}
+		return out == size;
+	}
+}
+
+GBufferArchive::~GBufferArchive()
+{
+	CloseGBufferArchive();
+}
+
+bool GBufferArchive::OpenGBufferArchive(const std::string& fileName)
+{
+	CloseGBufferArchive();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	mFileHandle = file;
+	mMappingHandle = mapping;
+	mData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	mDataSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int file = open(fileName.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileStat;
+	fstat(file, &fileStat);
+	void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // the mapping keeps the file alive
+	if (data == MAP_FAILED)
+		return false;
+
+	mData = static_cast<const uint8_t*>(data);
+	mDataSize = static_cast<size_t>(fileStat.st_size);
+#endif
+	if (mData == nullptr)
+	{
+		CloseGBufferArchive();
+		return false;
+	}
+	mFileName = fileName;
+
+	// parse the index, the tile table is used in place.
+	ArchiveHeader header;
+	if (mDataSize < sizeof(header))
+	{
+		std::cout << "ERROR::GBUFFER_ARCHIVE:: File is too small: " << fileName << std::endl;
+		CloseGBufferArchive();
+		return false;
+	}
+	std::memcpy(&header, mData, sizeof(header));
+	if (header.magic != archiveMagic || header.version != archiveVersion || header.tileRowCount == 0)
+	{
+		std::cout << "ERROR::GBUFFER_ARCHIVE:: Not a G-buffer archive: " << fileName << std::endl;
+		CloseGBufferArchive();
+		return false;
+	}
+
+	mWidth = header.width;
+	mHeight = header.height;
+	mTileRowCount = header.tileRowCount;
+	mTileCountPerMap = (mHeight + mTileRowCount - 1) / mTileRowCount;
+
+	size_t offset = sizeof(header);
+	size_t tableSize = header.mapCount * sizeof(ArchiveMapEntry) + header.viewCount * sizeof(glm::vec2)
+		+ static_cast<size_t>(header.viewCount) * header.mapCount * mTileCountPerMap * sizeof(TileEntry);
+	if (offset + tableSize > mDataSize)
+	{
+		std::cout << "ERROR::GBUFFER_ARCHIVE:: Truncated index: " << fileName << std::endl;
+		CloseGBufferArchive();
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.mapCount; i++)
+	{
+		ArchiveMapEntry entry;
+		std::memcpy(&entry, mData + offset, sizeof(entry));
+		offset += sizeof(entry);
+
+		GBufferMapInfo map;
+		map.name = std::string(entry.name, strnlen(entry.name, mapNameLength));
+		map.channelCount = entry.channelCount;
+		mMaps.push_back(map);
+	}
+
+	mViews.resize(header.viewCount);
+	std::memcpy(mViews.data(), mData + offset, header.viewCount * sizeof(glm::vec2));
+	offset += header.viewCount * sizeof(glm::vec2);
+
+	mTiles = reinterpret_cast<const TileEntry*>(mData + offset);
+	return true;
+}
+void GBufferArchive::CloseGBufferArchive()
+{
+#ifdef _WIN32
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != nullptr)
+		CloseHandle(mMappingHandle);
+	if (mFileHandle != nullptr)
+		CloseHandle(mFileHandle);
+	mFileHandle = nullptr;
+	mMappingHandle = nullptr;
+#else
+	if (mData != nullptr)
+		munmap(const_cast<uint8_t*>(mData), mDataSize);
+#endif
+	mData = nullptr;
+	mDataSize = 0;
+	mTiles = nullptr;
+	mMaps.clear();
+	mViews.clear();
+	mFileName.clear();
+}
+bool GBufferArchive::IsOpen()
+{
+	return mData != nullptr;
+}
+
+uint32_t GBufferArchive::GetWidth()
+{
+	return mWidth;
+}
+uint32_t GBufferArchive::GetHeight()
+{
+	return mHeight;
+}
+uint32_t GBufferArchive::GetViewCount()
+{
+	return static_cast<uint32_t>(mViews.size());
+}
+uint32_t GBufferArchive::GetMapCount()
+{
+	return static_cast<uint32_t>(mMaps.size());
+}
+const GBufferMapInfo& GBufferArchive::GetMapInfo(uint32_t mapIndex)
+{
+	return mMaps[mapIndex];
+}
+size_t GBufferArchive::GetMapSize(uint32_t mapIndex)
+{
+	return static_cast<size_t>(mWidth) * mHeight * mMaps[mapIndex].channelCount;
+}
+
+int32_t GBufferArchive::FindView(float theta, float phi)
+{
+	for (size_t i = 0; i < mViews.size(); i++)
+	{
+		if (mViews[i].x == theta && mViews[i].y == phi)
+			return static_cast<int32_t>(i);
+	}
+	return -1;
+}
+int32_t GBufferArchive::FindMap(const std::string& name)
+{
+	for (size_t i = 0; i < mMaps.size(); i++)
+	{
+		if (mMaps[i].name == name)
+			return static_cast<int32_t>(i);
+	}
+	return -1;
+}
+
+bool GBufferArchive::DecodeView(uint32_t viewIndex, const std::vector<uint8_t*>& mapDestinations)
+{
+	if (viewIndex >= mViews.size())
+		return false;
+
+	// every strip of every requested map is one job, threads pull jobs until none are left.
+	std::vector<std::pair<uint32_t, uint32_t>> jobs; // map, tile
+	for (uint32_t map = 0; map < mMaps.size() && map < mapDestinations.size(); map++)
+	{
+		if (mapDestinations[map] == nullptr)
+			continue;
+		for (uint32_t tile = 0; tile < mTileCountPerMap; tile++)
+			jobs.push_back({ map, tile });
+	}
+
+	std::atomic<uint32_t> nextJob = 0;
+	std::atomic<bool> isFailed = false;
+	auto decodeJobs = [&]()
+	{
+		for (uint32_t job = nextJob++; job < jobs.size(); job = nextJob++)
+		{
+			uint32_t map = jobs[job].first;
+			uint32_t tile = jobs[job].second;
+			uint32_t channelCount = mMaps[map].channelCount;
+
+			size_t rowSize = static_cast<size_t>(mWidth) * channelCount;
+			uint32_t firstRow = tile * mTileRowCount;
+			uint32_t rowCount = std::min(mTileRowCount, mHeight - firstRow);
+
+			const TileEntry& entry = mTiles[(static_cast<size_t>(viewIndex) * mMaps.size() + map) * mTileCountPerMap + tile];
+			if (!DecodeTile(entry, mapDestinations[map] + firstRow * rowSize, rowCount * rowSize, channelCount))
+				isFailed = true;
+		}
+	};
+
+	uint32_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), static_cast<uint32_t>(jobs.size()));
+	std::vector<std::thread> threads;
+	for (uint32_t i = 1; i < threadCount; i++)
+		threads.emplace_back(decodeJobs);
+	decodeJobs();
+	for (auto& thread : threads)
+		thread.join();
+
+	if (isFailed)
+		std::cout << "ERROR::GBUFFER_ARCHIVE:: Corrupt tile in " << mFileName << std::endl;
+	return !isFailed;
+}
+
+bool GBufferArchive::DecodeTile(const TileEntry& tile, uint8_t* destination, size_t size, uint32_t channelCount)
+{
+	if (tile.offset + tile.size > mDataSize)
+		return false;
+	const uint8_t* source = mData + tile.offset;
+
+	if (tile.codec == TileCodec::Raw)
+	{
+		if (tile.size != size)
+			return false;
+		std::memcpy(destination, source, size);
+		return true;
+	}
+
+	if (tile.codec == TileCodec::PlanarRLE)
+	{
+		if (channelCount == 1)
+			return DecodeRLE(source, tile.size, destination, size);
+
+		// decode the planes, then interleave them back into pixels.
+		std::vector<uint8_t> planes(size);
+		if (!DecodeRLE(source, tile.size, planes.data(), size))
+			return false;
+
+		size_t pixelCount = size / channelCount;
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			const uint8_t* plane = planes.data() + c * pixelCount;
+			for (size_t p = 0; p < pixelCount; p++)
+				destination[p * channelCount + c] = plane[p];
+		}
+		return true;
+	}
+
+	return false;
+}
+
+bool GBufferArchive::ConvertFromPNG(const std::string& directoryName, const std::vector<GBufferMapInfo>& maps,
+	const std::string& archiveFileName, uint32_t tileRowCount)
+{
+	if (maps.empty() || tileRowCount == 0)
+		return false;
+
+	// views are the THETA_PHI suffixes of the first map's files.
+	std::vector<glm::vec2> views;
+	std::string firstPrefix = maps[0].filePrefix + "_";
+	for (const auto& entry : std::filesystem::directory_iterator(directoryName))
+	{
+		std::string fileName = entry.path().filename().string();
+		if (!fileName.starts_with(firstPrefix) || !fileName.ends_with(".png"))
+			continue;
+
+		uint32_t theta = 0, phi = 0;
+		if (std::sscanf(fileName.c_str() + firstPrefix.size(), "%u_%u.png", &theta, &phi) == 2)
+			views.push_back(glm::vec2(static_cast<float>(theta), static_cast<float>(phi)));
+	}
+	std::sort(views.begin(), views.end(), [](const glm::vec2& a, const glm::vec2& b)
+	{
+		return a.x < b.x || (a.x == b.x && a.y < b.y);
+	});
+	if (views.empty())
+	{
+		std::cout << "No " << firstPrefix << "THETA_PHI.png files in " << directoryName << std::endl;
+		return false;
+	}
+
+	uint32_t width = 0, height = 0;
+	uint32_t tileCountPerMap = 0;
+	std::vector<TileEntry> tiles;
+	std::vector<uint8_t> tileData;
+
+	stbi_set_flip_vertically_on_load(true);
+	for (const auto& view : views)
+	{
+		for (const auto& map : maps)
+		{
+			std::string fileName = directoryName + "\\" + map.filePrefix + "_" + std::to_string(static_cast<uint32_t>(view.x))
+				+ "_" + std::to_string(static_cast<uint32_t>(view.y)) + ".png";
+
+			int imageWidth = 0, imageHeight = 0, imageChannelCount = 0;
+			unsigned char* data = stbi_load(fileName.c_str(), &imageWidth, &imageHeight, &imageChannelCount, map.channelCount);
+			if (width == 0 && data)
+			{
+				width = static_cast<uint32_t>(imageWidth);
+				height = static_cast<uint32_t>(imageHeight);
+				tileCountPerMap = (height + tileRowCount - 1) / tileRowCount;
+			}
+			if (data && (static_cast<uint32_t>(imageWidth) != width || static_cast<uint32_t>(imageHeight) != height))
+			{
+				std::cout << "ERROR::GBUFFER_ARCHIVE:: " << fileName << " differs in size from the other maps" << std::endl;
+				stbi_image_free(data);
+				return false;
+			}
+			if (width == 0)
+			{
+				std::cout << "ERROR::GBUFFER_ARCHIVE:: Failed to load " << fileName << std::endl;
+				return false;
+			}
+
+			// a missing map is stored as zeros, which costs a few bytes per strip.
+			size_t rowSize = static_cast<size_t>(width) * map.channelCount;
+			std::vector<uint8_t> pixels(rowSize * height, 0);
+			if (data)
+			{
+				std::memcpy(pixels.data(), data, pixels.size());
+				stbi_image_free(data);
+			}
+			else
+				std::cout << "Failed to load " << fileName << ", stored as zeros" << std::endl;
+
+			std::vector<uint8_t> planes;
+			std::vector<uint8_t> encoded;
+			for (uint32_t tile = 0; tile < tileCountPerMap; tile++)
+			{
+				uint32_t firstRow = tile * tileRowCount;
+				uint32_t rowCount = std::min(tileRowCount, height - firstRow);
+				const uint8_t* strip = pixels.data() + firstRow * rowSize;
+				size_t stripSize = rowCount * rowSize;
+
+				// planes of one channel have longer runs than interleaved pixels.
+				size_t pixelCount = stripSize / map.channelCount;
+				planes.resize(stripSize);
+				for (size_t p = 0; p < pixelCount; p++)
+					for (uint32_t c = 0; c < map.channelCount; c++)
+						planes[c * pixelCount + p] = strip[p * map.channelCount + c];
+
+				encoded.clear();
+				EncodeRLE(planes.data(), stripSize, encoded);
+
+				TileEntry entry;
+				entry.offset = tileData.size(); // relative to the data section until the index size is known
+				if (encoded.size() < stripSize)
+				{
+					entry.size = static_cast<uint32_t>(encoded.size());
+					entry.codec = TileCodec::PlanarRLE;
+					tileData.insert(tileData.end(), encoded.begin(), encoded.end());
+				}
+				else
+				{
+					entry.size = static_cast<uint32_t>(stripSize);
+					entry.codec = TileCodec::Raw;
+					tileData.insert(tileData.end(), strip, strip + stripSize);
+				}
+				tiles.push_back(entry);
+			}
+		}
+	}
+
+	ArchiveHeader header{};
+	header.magic = archiveMagic;
+	header.version = archiveVersion;
+	header.width = width;
+	header.height = height;
+	header.mapCount = static_cast<uint32_t>(maps.size());
+	header.viewCount = static_cast<uint32_t>(views.size());
+	header.tileRowCount = tileRowCount;
+
+	uint64_t dataOffset = sizeof(header) + maps.size() * sizeof(ArchiveMapEntry) + views.size() * sizeof(glm::vec2)
+		+ tiles.size() * sizeof(TileEntry);
+	for (auto& tile : tiles)
+		tile.offset += dataOffset;
+
+	std::ofstream file(archiveFileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write G-buffer archive: " << archiveFileName << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const auto& map : maps)
+	{
+		ArchiveMapEntry entry{};
+		std::strncpy(entry.name, map.name.c_str(), mapNameLength - 1);
+		entry.channelCount = map.channelCount;
+		file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	}
+	file.write(reinterpret_cast<const char*>(views.data()), views.size() * sizeof(glm::vec2));
+	file.write(reinterpret_cast<const char*>(tiles.data()), tiles.size() * sizeof(TileEntry));
+	file.write(reinterpret_cast<const char*>(tileData.data()), tileData.size());
+
+	std::cout << "Packed " << views.size() << " views of " << maps.size() << " maps into " << archiveFileName << std::endl;
+	return true;
+}
\ No newline at end of file
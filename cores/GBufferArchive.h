@@ -0,0 +1,71 @@
+#pragma once
+#include "Stdafx.h"
+
+// one G-buffer channel of the dataset, e.g. albedo with 4 channels stored as Albedo_THETA_PHI.png.
+struct GBufferMapInfo
+{
+	std::string name;
+	std::string filePrefix;
+	uint32_t channelCount = 0;
+};
+
+// every map of every view of one model in a single memory-mapped file.
+// each map is split into strips of tileRowCount rows that are compressed on their own, and the header
+// indexes every strip, so a view is decoded by several threads straight into the destination (e.g. a mapped PBO).
+// file layout: header, map table, view table, tile table, tile data.
+class GBufferArchive
+{
+public:
+	GBufferArchive() = default;
+	~GBufferArchive();
+	GBufferArchive(const GBufferArchive& rhs) = delete;
+	GBufferArchive operator=(const GBufferArchive& rhs) = delete;
+
+	bool OpenGBufferArchive(const std::string& fileName);
+	void CloseGBufferArchive();
+	bool IsOpen();
+
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+	uint32_t GetViewCount();
+	uint32_t GetMapCount();
+	const GBufferMapInfo& GetMapInfo(uint32_t mapIndex);
+	size_t GetMapSize(uint32_t mapIndex); // decoded bytes, rows are tightly packed bottom to top like GL expects
+
+	int32_t FindView(float theta, float phi);
+	int32_t FindMap(const std::string& name);
+
+	// decodes one view, destinations are indexed by map and may be nullptr to skip a map.
+	bool DecodeView(uint32_t viewIndex, const std::vector<uint8_t*>& mapDestinations);
+
+	// packs DIRECTORY/PREFIX_THETA_PHI.png of the given maps into one archive, views are found from the first map's files.
+	static bool ConvertFromPNG(const std::string& directoryName, const std::vector<GBufferMapInfo>& maps,
+		const std::string& archiveFileName, uint32_t tileRowCount = 64);
+private:
+	struct TileEntry
+	{
+		uint64_t offset;
+		uint32_t size;
+		uint32_t codec;
+	};
+
+	bool DecodeTile(const TileEntry& tile, uint8_t* destination, size_t size, uint32_t channelCount);
+private:
+	std::string mFileName;
+
+	const uint8_t* mData = nullptr;
+	size_t mDataSize = 0;
+#ifdef _WIN32
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTileRowCount = 0;
+	uint32_t mTileCountPerMap = 0;
+
+	std::vector<GBufferMapInfo> mMaps;
+	std::vector<glm::vec2> mViews; // theta, phi
+	const TileEntry* mTiles = nullptr; // view * map count * tiles per map + map * tiles per map + tile
+};
\ No newline at end of file
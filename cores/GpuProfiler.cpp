@@ -0,0 +1,216 @@
+#include "GpuProfiler.h"
+
+void GpuProfiler::CreateGpuProfiler(uint32_t maxZoneCount)
+{
+	mMaxZoneCount = maxZoneCount;
+
+	for (auto& frame : mFrames)
+	{
+		frame.queries.resize(2 * maxZoneCount);
+		glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+		frame.zoneQueries.reserve(maxZoneCount);
+	}
+}
+void GpuProfiler::DeleteGpuProfiler()
+{
+	for (auto& frame : mFrames)
+	{
+		glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+		frame.queries.clear();
+	}
+}
+
+void GpuProfiler::BeginFrame()
+{
+	mFrameIndex = (mFrameIndex + 1) % frameLatency;
+
+	// this pool was issued frameLatency frames ago, read it back before reusing it.
+	auto& frame = mFrames[mFrameIndex];
+	CollectFrame(frame);
+
+	frame.usedQueryCount = 0;
+	frame.zoneQueries.clear();
+	mOpenZoneQueries.clear();
+
+	BeginZone("Frame");
+}
+void GpuProfiler::EndFrame()
+{
+	while (!mOpenZoneQueries.empty())
+		EndZone();
+
+	mFrames[mFrameIndex].isPending = true;
+}
+
+void GpuProfiler::BeginZone(const std::string& name)
+{
+	auto& frame = mFrames[mFrameIndex];
+	if (frame.usedQueryCount + 2 > frame.queries.size())
+	{
+		// out of queries, the matching EndZone is ignored as well.
+		mOpenZoneQueries.push_back(UINT32_MAX);
+		return;
+	}
+
+	ZoneQuery zoneQuery;
+	zoneQuery.zoneIndex = FindOrAddZone(name, static_cast<uint32_t>(mOpenZoneQueries.size()));
+	zoneQuery.beginQuery = frame.queries[frame.usedQueryCount++];
+	zoneQuery.endQuery = frame.queries[frame.usedQueryCount++];
+	glQueryCounter(zoneQuery.beginQuery, GL_TIMESTAMP);
+
+	mOpenZoneQueries.push_back(static_cast<uint32_t>(frame.zoneQueries.size()));
+	frame.zoneQueries.push_back(zoneQuery);
+}
+void GpuProfiler::EndZone()
+{
+	if (mOpenZoneQueries.empty())
+	{
+		std::cout << "ERROR::GPU_PROFILER:: EndZone without BeginZone" << std::endl;
+		return;
+	}
+
+	uint32_t zoneQueryIndex = mOpenZoneQueries.back();
+	mOpenZoneQueries.pop_back();
+	if (zoneQueryIndex == UINT32_MAX)
+		return;
+
+	glQueryCounter(mFrames[mFrameIndex].zoneQueries[zoneQueryIndex].endQuery, GL_TIMESTAMP);
+}
+
+void GpuProfiler::ResetStatistics()
+{
+	for (auto& zone : mZones)
+	{
+		zone.averageMilliseconds = 0.0;
+		zone.minMilliseconds = 0.0;
+		zone.maxMilliseconds = 0.0;
+		zone.sampleCount = 0;
+	}
+}
+
+const std::vector<GpuProfileZone>& GpuProfiler::GetZones()
+{
+	return mZones;
+}
+
+bool GpuProfiler::ExportToCSV(const std::string& fileName, const std::string& buildLabel)
+{
+	bool isNewFile = !std::filesystem::exists(fileName);
+
+	std::ofstream file(fileName, std::ios::app);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open " << fileName << std::endl;
+		return false;
+	}
+
+	if (isNewFile)
+		file << "build,zone,depth,last_ms,average_ms,min_ms,max_ms,samples\n";
+
+	for (const auto& zone : mZones)
+	{
+		file << buildLabel << ',' << zone.name << ',' << zone.depth << ','
+			<< zone.lastMilliseconds << ',' << zone.averageMilliseconds << ','
+			<< zone.minMilliseconds << ',' << zone.maxMilliseconds << ','
+			<< zone.sampleCount << '\n';
+	}
+
+	return true;
+}
+bool GpuProfiler::ExportToJSON(const std::string& fileName, const std::string& buildLabel)
+{
+	std::ofstream file(fileName);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open " << fileName << std::endl;
+		return false;
+	}
+
+	const char* glRenderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+	// zone names are plain identifiers, so no string escaping is done.
+	file << "{\n";
+	file << "\t\"build\": \"" << buildLabel << "\",\n";
+	file << "\t\"renderer\": \"" << (glRenderer != nullptr ? glRenderer : "") << "\",\n";
+	file << "\t\"droppedFrames\": " << mDroppedFrameCount << ",\n";
+	file << "\t\"zones\": [\n";
+	for (size_t i = 0; i < mZones.size(); i++)
+	{
+		const auto& zone = mZones[i];
+		file << "\t\t{ \"name\": \"" << zone.name << "\", \"depth\": " << zone.depth
+			<< ", \"lastMs\": " << zone.lastMilliseconds
+			<< ", \"averageMs\": " << zone.averageMilliseconds
+			<< ", \"minMs\": " << zone.minMilliseconds
+			<< ", \"maxMs\": " << zone.maxMilliseconds
+			<< ", \"samples\": " << zone.sampleCount << " }"
+			<< (i + 1 < mZones.size() ? ",\n" : "\n");
+	}
+	file << "\t]\n";
+	file << "}\n";
+
+	return true;
+}
+
+void GpuProfiler::CollectFrame(FrameQueries& frame)
+{
+	if (!frame.isPending)
+		return;
+	frame.isPending = false;
+	if (frame.zoneQueries.empty())
+		return;
+
+	// the last timestamp of the frame is written last, if it is ready every other one is too.
+	GLint isAvailable = GL_FALSE;
+	glGetQueryObjectiv(frame.zoneQueries.front().endQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+	if (isAvailable == GL_FALSE)
+	{
+		// still in flight after frameLatency frames, drop it rather than stall.
+		mDroppedFrameCount++;
+		return;
+	}
+
+	for (const auto& zoneQuery : frame.zoneQueries)
+	{
+		GLuint64 beginTime = 0, endTime = 0;
+		glGetQueryObjectui64v(zoneQuery.beginQuery, GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(zoneQuery.endQuery, GL_QUERY_RESULT, &endTime);
+		double milliseconds = static_cast<double>(endTime - beginTime) / 1000000.0;
+
+		auto& zone = mZones[zoneQuery.zoneIndex];
+		zone.lastMilliseconds = milliseconds;
+		if (zone.sampleCount == 0)
+		{
+			zone.minMilliseconds = milliseconds;
+			zone.maxMilliseconds = milliseconds;
+		}
+		zone.minMilliseconds = std::min(zone.minMilliseconds, milliseconds);
+		zone.maxMilliseconds = std::max(zone.maxMilliseconds, milliseconds);
+		zone.sampleCount++;
+		zone.averageMilliseconds += (milliseconds - zone.averageMilliseconds) / static_cast<double>(zone.sampleCount);
+	}
+}
+uint32_t GpuProfiler::FindOrAddZone(const std::string& name, uint32_t depth)
+{
+	auto iter = mZoneIndices.find(name);
+	if (iter != mZoneIndices.end())
+		return iter->second;
+
+	GpuProfileZone zone;
+	zone.name = name;
+	zone.depth = depth;
+	mZones.push_back(zone);
+
+	uint32_t zoneIndex = static_cast<uint32_t>(mZones.size() - 1);
+	mZoneIndices.insert({ name, zoneIndex });
+	return zoneIndex;
+}
+
+GpuProfileScope::GpuProfileScope(GpuProfiler& profiler, const std::string& name)
+	: mProfiler(profiler)
+{
+	mProfiler.BeginZone(name);
+}
+GpuProfileScope::~GpuProfileScope()
+{
+	mProfiler.EndZone();
+}
\ No newline at end of file
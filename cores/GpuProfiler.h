@@ -0,0 +1,83 @@
+#pragma once
+#include "Stdafx.h"
+
+// timings of one named zone, the frame itself is the zone at depth 0.
+struct GpuProfileZone
+{
+	std::string name;
+	uint32_t depth = 0;
+
+	double lastMilliseconds = 0.0;
+	double averageMilliseconds = 0.0;
+	double minMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	uint64_t sampleCount = 0;
+};
+
+// GPU profiler built on GL_TIMESTAMP queries.
+// every frame owns its own query pool and is read back frameLatency frames later, so reading never stalls.
+class GpuProfiler
+{
+public:
+	GpuProfiler() = default;
+
+	void CreateGpuProfiler(uint32_t maxZoneCount = 64);
+	void DeleteGpuProfiler();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// zones nest, each one is a pair of timestamps.
+	void BeginZone(const std::string& name);
+	void EndZone();
+
+	void ResetStatistics();
+
+	const std::vector<GpuProfileZone>& GetZones();
+
+	// csv rows are appended so several builds can be compared in one file.
+	bool ExportToCSV(const std::string& fileName, const std::string& buildLabel);
+	bool ExportToJSON(const std::string& fileName, const std::string& buildLabel);
+
+	static constexpr uint32_t frameLatency = 4;
+private:
+	struct ZoneQuery
+	{
+		uint32_t zoneIndex;
+		uint32_t beginQuery;
+		uint32_t endQuery;
+	};
+
+	struct FrameQueries
+	{
+		std::vector<uint32_t> queries;
+		std::vector<ZoneQuery> zoneQueries;
+		uint32_t usedQueryCount = 0;
+		bool isPending = false;
+	};
+
+	void CollectFrame(FrameQueries& frame);
+	uint32_t FindOrAddZone(const std::string& name, uint32_t depth);
+private:
+	std::array<FrameQueries, frameLatency> mFrames;
+	uint32_t mFrameIndex = 0;
+	uint32_t mMaxZoneCount = 0;
+
+	std::vector<uint32_t> mOpenZoneQueries; // stack of indices into the current frame's zone queries
+	std::vector<GpuProfileZone> mZones;
+	std::unordered_map<std::string, uint32_t> mZoneIndices;
+
+	uint64_t mDroppedFrameCount = 0;
+};
+
+// BeginZone in the constructor, EndZone in the destructor.
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler& profiler, const std::string& name);
+	~GpuProfileScope();
+	GpuProfileScope(const GpuProfileScope& rhs) = delete;
+	GpuProfileScope operator=(const GpuProfileScope& rhs) = delete;
+private:
+	GpuProfiler& mProfiler;
+};
\ No newline at end of file
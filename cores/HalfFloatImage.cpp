@@ -0,0 +1,456 @@
+#include "HalfFloatImage.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define USE_F16C
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#ifdef USE_F16C
+	bool IsF16CSupported()
+	{
+		static const bool isSupported = []()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			// F16C and AVX, the conversions use 256-bit registers.
+			if ((info[2] & (1 << 29)) == 0 || (info[2] & (1 << 28)) == 0)
+				return false;
+			// the os must save the ymm registers on context switches, OSXSAVE and XCR0 bits 1 and 2.
+			if ((info[2] & (1 << 27)) == 0)
+				return false;
+			return (_xgetbv(0) & 6) == 6;
+#else
+			return __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+#endif
+		}();
+		return isSupported;
+	}
+
+#ifdef __GNUC__
+	__attribute__((target("avx,f16c")))
+#endif
+	void ConvertFloatToHalfF16C(const float* source, uint16_t* destination, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), halves);
+		}
+		for (; i < count; i++)
+			destination[i] = glm::packHalf1x16(source[i]);
+	}
+#endif
+
+#ifdef USE_F16C
+	bool IsAVX2Supported()
+	{
+		static const bool isSupported = []()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}();
+		return isSupported && IsF16CSupported();
+	}
+
+#ifdef __GNUC__
+	__attribute__((target("avx2,f16c")))
+#endif
+	void ConvertRGBEToHalfAVX2(const uint8_t* rgbe, uint16_t* destination, uint32_t pixelCount)
+	{
+		// the scale 2^(e - 136) as float bits is (e - 9) << 23, exponents below 10 would be denormal floats
+		// that round to zero as halves anyway, so they are masked to zero like e = 0.
+		const __m256i exponentBias = _mm256_set1_epi32(9);
+		const __m128i packRGB = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+
+		uint32_t x = 0;
+		for (; x + 2 <= pixelCount; x += 2)
+		{
+			// two pixels, one per 128-bit lane: r, g, b, e as 32-bit integers.
+			__m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rgbe + x * 4)));
+			__m256i exponents = _mm256_shuffle_epi32(values, _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i scaleBits = _mm256_slli_epi32(_mm256_sub_epi32(exponents, exponentBias), 23);
+			__m256 scales = _mm256_and_ps(_mm256_castsi256_ps(scaleBits), _mm256_castsi256_ps(_mm256_cmpgt_epi32(exponents, exponentBias)));
+			__m256 colors = _mm256_mul_ps(_mm256_cvtepi32_ps(values), scales);
+
+			__m128i halves = _mm_shuffle_epi8(_mm256_cvtps_ph(colors, _MM_FROUND_TO_NEAREST_INT), packRGB);
+			std::memcpy(destination + x * 3, &halves, 6 * sizeof(uint16_t));
+		}
+		for (; x < pixelCount; x++)
+		{
+			const uint8_t* pixel = rgbe + x * 4;
+			float scale = pixel[3] > 9 ? std::ldexp(1.0f, pixel[3] - 136) : 0.0f;
+			__m128i halves = _mm_cvtps_ph(_mm_setr_ps(pixel[0] * scale, pixel[1] * scale, pixel[2] * scale, 0.0f), _MM_FROUND_TO_NEAREST_INT);
+			std::memcpy(destination + x * 3, &halves, 3 * sizeof(uint16_t));
+		}
+	}
+#endif
+
+	// radiance files with run-length encoded scanlines and the usual -Y H +X W orientation, 3 channels.
+	// false for anything else, which the caller leaves to stbi_loadf.
+	bool DecodeRadianceImage(const std::string& fileName, HalfFloatImage& image)
+	{
+		std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+		// header lines up to an empty line, then the resolution line.
+		size_t position = 0;
+		auto readLine = [&data, &position](std::string& line)
+		{
+			const uint8_t* end = static_cast<const uint8_t*>(std::memchr(data.data() + position, '\n', data.size() - position));
+			if (end == nullptr)
+				return false;
+			line.assign(reinterpret_cast<const char*>(data.data() + position), end - data.data() - position);
+			position = end - data.data() + 1;
+			return true;
+		};
+
+		std::string line;
+		if (!readLine(line) || line.rfind("#?", 0) != 0)
+			return false;
+		bool isRGBE = true;
+		while (readLine(line) && !line.empty())
+		{
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+				isRGBE = false;
+		}
+		int width = 0, height = 0;
+		if (!isRGBE || !readLine(line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 ||
+			width < 8 || width > 32767 || height <= 0)
+			return false;
+
+		// rows have to be decoded in order to find where the next one starts, so the first pass only walks the runs
+		// and the rows are then decoded and converted in parallel.
+		std::vector<size_t> rowOffsets(height);
+		for (int row = 0; row < height; row++)
+		{
+			rowOffsets[row] = position;
+			if (position + 4 > data.size() || data[position] != 2 || data[position + 1] != 2 ||
+				((data[position + 2] << 8) | data[position + 3]) != width)
+				return false;
+			position += 4;
+
+			for (int component = 0; component < 4; component++)
+			{
+				int x = 0;
+				while (x < width && position < data.size())
+				{
+					int count = data[position++];
+					if (count > 128)
+					{
+						count -= 128;
+						position++;
+					}
+					else
+						position += count;
+					x += count;
+				}
+				if (x != width || position > data.size())
+					return false;
+			}
+		}
+
+		image.width = static_cast<uint32_t>(width);
+		image.height = static_cast<uint32_t>(height);
+		image.channelCount = 3;
+		image.texels.resize(static_cast<size_t>(width) * height * 3);
+
+		std::array<float, 256> scales{};
+		for (int exponent = 1; exponent < 256; exponent++)
+			scales[exponent] = std::ldexp(1.0f, exponent - 136);
+
+		std::atomic<int> nextRow = 0;
+		auto decodeRows = [&]()
+		{
+			std::vector<uint8_t> rgbe(static_cast<size_t>(width) * 4);
+			std::vector<float> colors(static_cast<size_t>(width) * 3);
+			for (int row = nextRow++; row < height; row = nextRow++)
+			{
+				const uint8_t* source = data.data() + rowOffsets[row] + 4;
+				for (int component = 0; component < 4; component++)
+				{
+					int x = 0;
+					while (x < width)
+					{
+						int count = *source++;
+						if (count > 128)
+						{
+							count -= 128;
+							uint8_t value = *source++;
+							for (int i = 0; i < count; i++)
+								rgbe[(x + i) * 4 + component] = value;
+						}
+						else
+						{
+							for (int i = 0; i < count; i++)
+								rgbe[(x + i) * 4 + component] = *source++;
+						}
+						x += count;
+					}
+				}
+
+				// file rows run top-down, image rows bottom-up.
+				uint16_t* destination = image.texels.data() + static_cast<size_t>(height - 1 - row) * width * 3;
+#ifdef USE_F16C
+				if (IsAVX2Supported())
+				{
+					ConvertRGBEToHalfAVX2(rgbe.data(), destination, width);
+					continue;
+				}
+#endif
+				for (int x = 0; x < width; x++)
+				{
+					float scale = scales[rgbe[x * 4 + 3]];
+					colors[x * 3] = rgbe[x * 4] * scale;
+					colors[x * 3 + 1] = rgbe[x * 4 + 1] * scale;
+					colors[x * 3 + 2] = rgbe[x * 4 + 2] * scale;
+				}
+				ConvertFloatToHalf(colors.data(), destination, colors.size());
+			}
+		};
+
+		uint32_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), static_cast<uint32_t>(height));
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < threadCount; i++)
+			threads.emplace_back(decodeRows);
+		decodeRows();
+		for (auto& thread : threads)
+			thread.join();
+		return true;
+	}
+
+	bool LoadRadianceImage(const std::string& fileName, uint32_t channelCount, HalfFloatImage& image)
+	{
+		// the common case skips the 32-bit float image stbi_loadf builds first.
+		if (channelCount == 3 && DecodeRadianceImage(fileName, image))
+			return true;
+
+		int width = 0, height = 0, fileChannelCount = 0;
+		stbi_set_flip_vertically_on_load(true);
+		float* data = stbi_loadf(fileName.c_str(), &width, &height, &fileChannelCount, static_cast<int>(channelCount));
+		if (data == nullptr)
+		{
+			std::cout << "Failed to load " << fileName << ": " << stbi_failure_reason() << std::endl;
+			return false;
+		}
+
+		image.width = static_cast<uint32_t>(width);
+		image.height = static_cast<uint32_t>(height);
+		image.channelCount = channelCount;
+		image.texels.resize(static_cast<size_t>(width) * height * channelCount);
+		ConvertFloatToHalf(data, image.texels.data(), image.texels.size());
+		stbi_image_free(data);
+		return true;
+	}
+
+	// https://openexr.com/en/latest/OpenEXRFileLayout.html, only what uncompressed scanline files need.
+	bool LoadOpenEXRImage(const std::string& fileName, uint32_t channelCount, HalfFloatImage& image)
+	{
+		std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open " << fileName << std::endl;
+			return false;
+		}
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+		size_t position = 0;
+		auto read = [&data, &position](void* value, size_t size)
+		{
+			if (position + size > data.size())
+				return false;
+			std::memcpy(value, data.data() + position, size);
+			position += size;
+			return true;
+		};
+		auto readString = [&data, &position](std::string& value)
+		{
+			const uint8_t* end = static_cast<const uint8_t*>(std::memchr(data.data() + position, 0, data.size() - position));
+			if (end == nullptr)
+				return false;
+			value.assign(reinterpret_cast<const char*>(data.data() + position), end - data.data() - position);
+			position = end - data.data() + 1;
+			return true;
+		};
+
+		uint32_t magic = 0, version = 0;
+		if (!read(&magic, 4) || !read(&version, 4) || magic != 0x01312f76)
+		{
+			std::cout << "ERROR::OPENEXR:: Not an OpenEXR file: " << fileName << std::endl;
+			return false;
+		}
+		// bit 9 marks tiled files, bits 11 and 12 deep and multi-part ones.
+		if ((version & 0xff) != 2 || (version & 0x1a00) != 0)
+		{
+			std::cout << "ERROR::OPENEXR:: Only single-part scanline files are supported: " << fileName << std::endl;
+			return false;
+		}
+
+		struct Channel
+		{
+			std::string name;
+			int32_t pixelType = 0; // 0 uint, 1 half, 2 float
+			size_t offset = 0; // bytes from the start of a scanline block
+		};
+		std::vector<Channel> channels;
+		int32_t dataWindow[4] = {};
+		uint8_t compression = 0xff;
+
+		std::string attributeName, attributeType;
+		while (readString(attributeName) && !attributeName.empty())
+		{
+			int32_t size = 0;
+			if (!readString(attributeType) || !read(&size, 4) || size < 0 || position + size > data.size())
+				return false;
+			size_t attributeEnd = position + size;
+
+			if (attributeName == "channels")
+			{
+				std::string channelName;
+				while (readString(channelName) && !channelName.empty())
+				{
+					Channel channel;
+					channel.name = channelName;
+					int32_t reserved[3];
+					if (!read(&channel.pixelType, 4) || !read(reserved, 12))
+						return false;
+					channels.push_back(channel);
+				}
+			}
+			else if (attributeName == "compression")
+				read(&compression, 1);
+			else if (attributeName == "dataWindow")
+				read(dataWindow, 16);
+			position = attributeEnd;
+		}
+
+		if (compression != 0)
+		{
+			std::cout << "ERROR::OPENEXR:: Only uncompressed files are supported: " << fileName << std::endl;
+			return false;
+		}
+		if (channels.empty())
+			return false;
+
+		image.width = static_cast<uint32_t>(dataWindow[2] - dataWindow[0] + 1);
+		image.height = static_cast<uint32_t>(dataWindow[3] - dataWindow[1] + 1);
+		image.channelCount = channelCount;
+		image.texels.assign(static_cast<size_t>(image.width) * image.height * channelCount, 0);
+
+		// a scanline stores every channel's row in turn, in the order of the channel list.
+		size_t rowSize = 0;
+		for (auto& channel : channels)
+		{
+			channel.offset = rowSize;
+			rowSize += static_cast<size_t>(image.width) * (channel.pixelType == 1 ? 2 : 4);
+		}
+
+		// the channels the image wants, missing ones stay zero.
+		std::vector<const Channel*> sourceChannels(channelCount, nullptr);
+		auto findChannel = [&channels](const std::string& name) -> const Channel*
+		{
+			for (const auto& channel : channels)
+			{
+				if (channel.name == name)
+					return &channel;
+			}
+			return nullptr;
+		};
+		if (channelCount == 1)
+		{
+			sourceChannels[0] = findChannel("R");
+			if (sourceChannels[0] == nullptr)
+				sourceChannels[0] = findChannel("Y");
+			if (sourceChannels[0] == nullptr)
+				sourceChannels[0] = &channels[0];
+		}
+		else
+		{
+			const char* channelNames[] = { "R", "G", "B", "A" };
+			for (uint32_t channel = 0; channel < channelCount && channel < 4; channel++)
+				sourceChannels[channel] = findChannel(channelNames[channel]);
+		}
+
+		// the offset table is skipped, uncompressed blocks are one scanline each and follow it in order.
+		position += static_cast<size_t>(image.height) * sizeof(uint64_t);
+		std::vector<float> floats(image.width);
+		std::vector<uint16_t> halves(image.width);
+		for (uint32_t block = 0; block < image.height; block++)
+		{
+			int32_t y = 0, blockSize = 0;
+			if (!read(&y, 4) || !read(&blockSize, 4) || static_cast<size_t>(blockSize) != rowSize ||
+				position + rowSize > data.size() || y < dataWindow[1] || y > dataWindow[3])
+			{
+				std::cout << "ERROR::OPENEXR:: Corrupt scanline block in " << fileName << std::endl;
+				return false;
+			}
+
+			// exr rows run top-down.
+			uint16_t* row = image.texels.data() + static_cast<size_t>(image.height - 1 - (y - dataWindow[1])) * image.width * channelCount;
+			for (uint32_t channel = 0; channel < channelCount; channel++)
+			{
+				const Channel* source = sourceChannels[channel];
+				if (source == nullptr)
+					continue;
+
+				const uint8_t* values = data.data() + position + source->offset;
+				if (source->pixelType == 1)
+					std::memcpy(halves.data(), values, image.width * sizeof(uint16_t));
+				else
+				{
+					if (source->pixelType == 2)
+						std::memcpy(floats.data(), values, image.width * sizeof(float));
+					else
+					{
+						const uint32_t* integers = reinterpret_cast<const uint32_t*>(values);
+						for (uint32_t x = 0; x < image.width; x++)
+							floats[x] = static_cast<float>(integers[x]);
+					}
+					ConvertFloatToHalf(floats.data(), halves.data(), image.width);
+				}
+
+				for (uint32_t x = 0; x < image.width; x++)
+					row[x * channelCount + channel] = halves[x];
+			}
+			position += rowSize;
+		}
+		return true;
+	}
+}
+
+bool LoadHalfFloatImage(const std::string& fileName, uint32_t channelCount, HalfFloatImage& image)
+{
+	if (std::filesystem::path(fileName).extension() == ".exr")
+		return LoadOpenEXRImage(fileName, channelCount, image);
+	return LoadRadianceImage(fileName, channelCount, image);
+}
+
+void ConvertFloatToHalf(const float* source, uint16_t* destination, size_t count)
+{
+#ifdef USE_F16C
+	if (IsF16CSupported())
+	{
+		ConvertFloatToHalfF16C(source, destination, count);
+		return;
+	}
+#endif
+	for (size_t i = 0; i < count; i++)
+		destination[i] = glm::packHalf1x16(source[i]);
+}
\ No newline at end of file
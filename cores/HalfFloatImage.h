@@ -0,0 +1,18 @@
+#pragma once
+#include "Stdafx.h"
+
+// float images held as half floats, rows bottom-up like images loaded with stbi_set_flip_vertically_on_load.
+struct HalfFloatImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t channelCount = 0;
+	std::vector<uint16_t> texels; // glm::packHalf1x16 bits
+};
+
+// loads .hdr (radiance, rle scanlines decoded on every core) and .exr (uncompressed scanlines of half or float channels) files,
+// converting to channelCount channels of half floats: 1 reads R (or Y), 3 reads R, G, B.
+bool LoadHalfFloatImage(const std::string& fileName, uint32_t channelCount, HalfFloatImage& image);
+
+// 8 values per instruction with F16C when the cpu has it.
+void ConvertFloatToHalf(const float* source, uint16_t* destination, size_t count);
\ No newline at end of file
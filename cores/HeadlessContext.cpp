@@ -0,0 +1,170 @@
+#include "HeadlessContext.h"
+
+#ifdef USE_EGL_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#ifdef USE_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+HeadlessBackend ParseHeadlessBackend(const std::string& name)
+{
+	if (name == "egl")
+		return HeadlessBackend::EGL;
+	if (name == "osmesa")
+		return HeadlessBackend::OSMesa;
+	return HeadlessBackend::None;
+}
+
+bool HeadlessContext::CreateHeadlessContext(HeadlessBackend backend, uint32_t width, uint32_t height)
+{
+	bool isCreated = false;
+	if (backend == HeadlessBackend::EGL)
+		isCreated = CreateEGLContext();
+	else if (backend == HeadlessBackend::OSMesa)
+		isCreated = CreateOSMesaContext(width, height);
+
+	if (!isCreated)
+		return false;
+	mBackend = backend;
+
+	if (!gladLoadGLLoader(GetProcAddressLoader()))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		DeleteHeadlessContext();
+		return false;
+	}
+
+	return true;
+}
+void HeadlessContext::DeleteHeadlessContext()
+{
+#ifdef USE_EGL_HEADLESS
+	if (mBackend == HeadlessBackend::EGL)
+	{
+		EGLDisplay display = static_cast<EGLDisplay>(mDisplay);
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, static_cast<EGLContext>(mContext));
+		eglTerminate(display);
+	}
+#endif
+#ifdef USE_OSMESA
+	if (mBackend == HeadlessBackend::OSMesa)
+		OSMesaDestroyContext(static_cast<OSMesaContext>(mContext));
+#endif
+
+	mDisplay = nullptr;
+	mContext = nullptr;
+	mOSMesaColorBuffer.clear();
+	mBackend = HeadlessBackend::None;
+}
+
+GLADloadproc HeadlessContext::GetProcAddressLoader()
+{
+#ifdef USE_EGL_HEADLESS
+	if (mBackend == HeadlessBackend::EGL)
+		return (GLADloadproc)eglGetProcAddress;
+#endif
+#ifdef USE_OSMESA
+	if (mBackend == HeadlessBackend::OSMesa)
+		return (GLADloadproc)OSMesaGetProcAddress;
+#endif
+	return nullptr;
+}
+HeadlessBackend HeadlessContext::GetBackend()
+{
+	return mBackend;
+}
+
+bool HeadlessContext::CreateEGLContext()
+{
+#ifdef USE_EGL_HEADLESS
+	// prefer the surfaceless platform, it needs neither a display server nor a gpu device node.
+	EGLDisplay display = EGL_NO_DISPLAY;
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay != nullptr)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if (display == EGL_NO_DISPLAY || eglInitialize(display, nullptr, nullptr) == EGL_FALSE)
+	{
+		std::cout << "Failed to initialize EGL display" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE ||
+		eglChooseConfig(display, configAttributes, &config, 1, &configCount) == EGL_FALSE || configCount == 0)
+	{
+		std::cout << "Failed to choose EGL config" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT ||
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE)
+	{
+		std::cout << "Failed to create surfaceless EGL context" << std::endl;
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	mDisplay = display;
+	mContext = context;
+	return true;
+#else
+	std::cout << "ERROR::HEADLESS:: EGL backend is not compiled in, define USE_EGL_HEADLESS" << std::endl;
+	return false;
+#endif
+}
+bool HeadlessContext::CreateOSMesaContext(uint32_t width, uint32_t height)
+{
+#ifdef USE_OSMESA
+	const int contextAttributes[] = {
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 4,
+		OSMESA_CONTEXT_MINOR_VERSION, 3,
+		0
+	};
+	OSMesaContext context = OSMesaCreateContextAttribs(contextAttributes, nullptr);
+	if (context == nullptr)
+	{
+		std::cout << "Failed to create OSMesa context" << std::endl;
+		return false;
+	}
+
+	mOSMesaColorBuffer.resize(static_cast<size_t>(width) * height * 4);
+	if (!OSMesaMakeCurrent(context, mOSMesaColorBuffer.data(), GL_UNSIGNED_BYTE, width, height))
+	{
+		std::cout << "Failed to make OSMesa context current" << std::endl;
+		OSMesaDestroyContext(context);
+		return false;
+	}
+
+	mContext = context;
+	return true;
+#else
+	(void)width;
+	(void)height;
+	std::cout << "ERROR::HEADLESS:: OSMesa backend is not compiled in, define USE_OSMESA" << std::endl;
+	return false;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include "Stdafx.h"
+
+// context backends that need no window or display.
+// each one is compiled in only when its headers and libraries are available:
+// define USE_EGL_HEADLESS (libEGL, EGL_KHR_surfaceless_context) or USE_OSMESA (libOSMesa, llvmpipe).
+enum class HeadlessBackend
+{
+	None = 0, // regular glfw window
+	EGL,
+	OSMesa
+};
+
+HeadlessBackend ParseHeadlessBackend(const std::string& name); // "egl", "osmesa", anything else is None
+
+// GL 4.3 core context without a default framebuffer, render into an offscreen framebuffer instead.
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	HeadlessContext(const HeadlessContext& rhs) = delete;
+	HeadlessContext operator=(const HeadlessContext& rhs) = delete;
+
+	bool CreateHeadlessContext(HeadlessBackend backend, uint32_t width, uint32_t height);
+	void DeleteHeadlessContext();
+
+	GLADloadproc GetProcAddressLoader();
+	HeadlessBackend GetBackend();
+private:
+	bool CreateEGLContext();
+	bool CreateOSMesaContext(uint32_t width, uint32_t height);
+private:
+	HeadlessBackend mBackend = HeadlessBackend::None;
+
+	// backend handles, typed as void* so this header does not pull in EGL or OSMesa.
+	void* mDisplay = nullptr;
+	void* mContext = nullptr;
+
+	std::vector<uint8_t> mOSMesaColorBuffer; // OSMesa needs a client color buffer even though nothing is drawn to it
+};
\ No newline at end of file
@@ -4,6 +4,8 @@ const uint32_t ImageBasedLight::mCubeMapSize = 1024;
 const uint32_t ImageBasedLight::mIrradianceMapSize = 32;
 const uint32_t ImageBasedLight::mPrefilterMapSize = 128;
 const uint32_t ImageBasedLight::mBrdfLUTSize = 512;
+const uint32_t ImageBasedLight::mPrefilterMipCount = 5;
+const uint32_t ImageBasedLight::mPrefilterTileSize = 8;
 
 ImageBasedLight::ImageBasedLight(
 	const std::string& shaderDirectoryName, 
@@ -22,17 +24,29 @@ void ImageBasedLight::SetDirectoryAndFileName(
 	mHDRName = hdrName;
 }
 
+void ImageBasedLight::SetTransientResourcePool(TransientResourcePool* pool)
+{
+	mTransientResourcePool = pool;
+}
+
+void ImageBasedLight::SetBrdfLookUpTable(BrdfLookUpTable* brdfLookUpTable)
+{
+	mBrdfLookUpTable = brdfLookUpTable;
+}
+
 void ImageBasedLight::BuildResources()
 {
 	BuildMeshes();
 	BuildTextures();
-	BuildFramebuffers();
 	BuildMatrices();
 	BuildRenderItems();
 }
 void ImageBasedLight::DeleteResources()
 {
-	mCaptureFramebuffer.DeleteFramebuffer();
+	if (mEquirectangularMap != 0)
+		GetTransientResourcePool().ReleaseTexture(mEquirectangularMap);
+	mEquirectangularMap = 0;
+	mLocalTransientResourcePool.DeleteTransientResourcePool();
 
 	for (auto& texture : mBasicTextures)
 		texture.second.DeleteTexture();
@@ -46,7 +60,16 @@ void ImageBasedLight::Draw(uint32_t equiToCubeProgramID, uint32_t irradianceProg
 	DrawCubeMap(equiToCubeProgramID);
 	DrawIrradianceMap(irradianceProgramID);
 	DrawPreFilteredEnvironmentMap(prefilterProgramID);
-	DrawBRDFLookUpTable(brdfLUTProgramID);
+	// a shared table is created on its first use instead.
+	if (mBrdfLookUpTable == nullptr)
+		DrawBRDFLookUpTable(brdfLUTProgramID);
+
+	// a pool of its own has no other light to hand the equirectangular source to.
+	if (mTransientResourcePool == nullptr)
+	{
+		mLocalTransientResourcePool.BeginFrame();
+		mLocalTransientResourcePool.TrimUnused(0);
+	}
 }
 
 Texture* ImageBasedLight::GetCubeMap()
@@ -63,6 +86,8 @@ Texture* ImageBasedLight::GetPreFilteredEnvironmentMap()
 }
 Texture* ImageBasedLight::GetBRDFLookUpTable()
 {
+	if (mBrdfLookUpTable != nullptr)
+		return mBrdfLookUpTable->GetTexture();
 	return &mBasicTextures["brdfLUT"];
 }
 
@@ -78,13 +103,25 @@ void ImageBasedLight::BuildMeshes()
 
 void ImageBasedLight::BuildTextures()
 {
-	Texture equirectengularMap(mEquirectangularMapFileName);
-	std::string texName = "equirectangularMap";
-	equirectengularMap.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false);
-	mBasicTextures.insert({ texName, std::move(equirectengularMap) });
+	// decoded straight to half floats, the float image stbi_loadf would build is never allocated.
+	HalfFloatImage equirectangularImage;
+	if (!LoadHalfFloatImage(mEquirectangularMapFileName, 3, equirectangularImage))
+		std::cout << "Failed to load " << mEquirectangularMapFileName << std::endl;
+
+	// only the cube map capture reads it, so it is a transient texture that goes back to the pool right after.
+	if (!equirectangularImage.texels.empty())
+	{
+		mEquirectangularMap = GetTransientResourcePool().AcquireTexture(equirectangularImage.width, equirectangularImage.height, GL_RGB16F);
+		glBindTexture(GL_TEXTURE_2D, mEquirectangularMap);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, equirectangularImage.width, equirectangularImage.height,
+			GL_RGB, GL_HALF_FLOAT, equirectangularImage.texels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
 
 	Texture cubeMap;
-	texName = "cubeMap";
+	std::string texName = "cubeMap";
 	cubeMap.CreateHDRTextureCube(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, false, true, mCubeMapSize, mCubeMapSize);
 	mBasicTextures.insert({ texName, std::move(cubeMap) });
 
@@ -95,18 +132,16 @@ void ImageBasedLight::BuildTextures()
 
 	Texture prefilterMap;
 	texName = "prefilterMap";
-	prefilterMap.CreateHDRTextureCube(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true, true, mPrefilterMapSize, mPrefilterMapSize);
+	prefilterMap.CreateHDRTextureCube(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true, true, mPrefilterMapSize, mPrefilterMapSize, GL_RGBA16F, GL_RGBA); // rgba for image stores
 	mBasicTextures.insert({ texName, std::move(prefilterMap) });
 
-	Texture brdfLUT;
-	texName = "brdfLUT";
-	brdfLUT.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false, true, mBrdfLUTSize, mBrdfLUTSize, GL_RG16F, GL_RG);
-	mBasicTextures.insert({ texName, std::move(brdfLUT) });
-}
-
-void ImageBasedLight::BuildFramebuffers()
-{
-	mCaptureFramebuffer.CreateFramebuffer(512, 512, 1, false);
+	if (mBrdfLookUpTable == nullptr)
+	{
+		Texture brdfLUT;
+		texName = "brdfLUT";
+		brdfLUT.CreateHDRTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false, true, mBrdfLUTSize, mBrdfLUTSize, GL_RG16F, GL_RG);
+		mBasicTextures.insert({ texName, std::move(brdfLUT) });
+	}
 }
 
 void ImageBasedLight::BuildMatrices()
@@ -127,11 +162,11 @@ void ImageBasedLight::BuildRenderItems()
 {
 	mImageBasedLightRenderItem.mesh = &mCubeMapBox;
 	mImageBasedLightRenderItem.world = glm::mat4(1.0f);
-	mImageBasedLightRenderItem.equirectangularMap = &mBasicTextures["equirectangularMap"];
 	mImageBasedLightRenderItem.environmentMap = &mBasicTextures["cubeMap"];
 	mImageBasedLightRenderItem.irradianceMap = &mBasicTextures["irradianceMap"];
 	mImageBasedLightRenderItem.prefilterMap = &mBasicTextures["prefilterMap"];
-	mImageBasedLightRenderItem.brdfLUT = &mBasicTextures["brdfLUT"];
+	if (mBrdfLookUpTable == nullptr)
+		mImageBasedLightRenderItem.brdfLUT = &mBasicTextures["brdfLUT"];
 }
 
 void ImageBasedLight::DrawCubeMap(uint32_t programID)
@@ -141,35 +176,17 @@ void ImageBasedLight::DrawCubeMap(uint32_t programID)
 	SetMat4(programID, "sceneConstant.projection", mCaptureProjection);
 
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mImageBasedLightRenderItem.equirectangularMap->GetTexture());
+	glBindTexture(GL_TEXTURE_2D, mEquirectangularMap);
 	SetInt(programID, "equirectangularMap", 0);
 
-	glViewport(0, 0, mCubeMapSize, mCubeMapSize); // don't forget to configure the viewport to the capture dimensions.
-	glBindFramebuffer(GL_FRAMEBUFFER, mCaptureFramebuffer.GetFramebuffer());
-	mCaptureFramebuffer.ResizeDepthStencilBuffer(mCubeMapSize, mCubeMapSize);
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		SetMat4(programID, "sceneConstant.view", mCaptureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mImageBasedLightRenderItem.environmentMap->GetTexture(), 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		auto primitiveType = mImageBasedLightRenderItem.mesh->GetPrimitiveType();
-		auto indexCount = mImageBasedLightRenderItem.mesh->GetIndexCount();
-		auto indexFormat = mImageBasedLightRenderItem.mesh->GetIndexFormat();
-		auto vertexAttribArray = mImageBasedLightRenderItem.mesh->GetVertexAttribArray();
-
-		glBindVertexArray(vertexAttribArray);
-		glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
-		glBindVertexArray(0);
-
-		std::string fileName = mTextureDirectoryName + "\\" + mHDRName + "\\cubemap\\" + mTextureNames[i] + ".png";
-		SaveScreenshotToPNG(fileName, mCubeMapSize, mCubeMapSize);
-	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	DrawCaptureCube(programID, mImageBasedLightRenderItem.environmentMap->GetTexture(), 0, mCubeMapSize, "cubemap", "");
 
 	glBindTexture(GL_TEXTURE_CUBE_MAP, mImageBasedLightRenderItem.environmentMap->GetTexture());
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	if (mEquirectangularMap != 0)
+		GetTransientResourcePool().ReleaseTexture(mEquirectangularMap);
+	mEquirectangularMap = 0;
 }
 
 void ImageBasedLight::DrawIrradianceMap(uint32_t programID)
@@ -182,29 +199,7 @@ void ImageBasedLight::DrawIrradianceMap(uint32_t programID)
 	glBindTexture(GL_TEXTURE_CUBE_MAP, mImageBasedLightRenderItem.environmentMap->GetTexture());
 	SetInt(programID, "environmentMap", 0);
 
-	glViewport(0, 0, mIrradianceMapSize, mIrradianceMapSize); // don't forget to configure the viewport to the capture dimensions.
-	glBindFramebuffer(GL_FRAMEBUFFER, mCaptureFramebuffer.GetFramebuffer());
-	mCaptureFramebuffer.ResizeDepthStencilBuffer(mIrradianceMapSize, mIrradianceMapSize);
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		SetMat4(programID, "sceneConstant.view", mCaptureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mImageBasedLightRenderItem.irradianceMap->GetTexture(), 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		auto primitiveType = mImageBasedLightRenderItem.mesh->GetPrimitiveType();
-		auto indexCount = mImageBasedLightRenderItem.mesh->GetIndexCount();
-		auto indexFormat = mImageBasedLightRenderItem.mesh->GetIndexFormat();
-		auto vertexAttribArray = mImageBasedLightRenderItem.mesh->GetVertexAttribArray();
-
-		glBindVertexArray(vertexAttribArray);
-		glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
-		glBindVertexArray(0);
-
-		std::string fileName = mTextureDirectoryName + "\\" + mHDRName + "\\irradiancemap\\" + mTextureNames[i] + ".png";
-		SaveScreenshotToPNG(fileName, mIrradianceMapSize, mIrradianceMapSize);
-	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	DrawCaptureCube(programID, mImageBasedLightRenderItem.irradianceMap->GetTexture(), 0, mIrradianceMapSize, "irradiancemap", "");
 }
 
 void ImageBasedLight::DrawPreFilteredEnvironmentMap(uint32_t programID)
@@ -213,45 +208,58 @@ void ImageBasedLight::DrawPreFilteredEnvironmentMap(uint32_t programID)
 	
 	glUseProgram(programID);
 
-	SetMat4(programID, "sceneConstant.projection", mCaptureProjection);
-
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, mImageBasedLightRenderItem.environmentMap->GetTexture());
 	SetInt(programID, "environmentMap", 0);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mCaptureFramebuffer.GetFramebuffer());
-	uint32_t maxMipLevels = 5;
-	for (unsigned int mip = 0; mip < maxMipLevels; mip++)
+	// programs linked from prefilterMap.comp write every mip and face in one dispatch.
+	if (glGetUniformLocation(programID, "prefilterSize") != -1)
+	{
+		DispatchPreFilteredEnvironmentMap(programID);
+		return;
+	}
+
+	SetMat4(programID, "sceneConstant.projection", mCaptureProjection);
+
+	for (unsigned int mip = 0; mip < mPrefilterMipCount; mip++)
 	{
-		// resize framebuffer according to mip-level size.
-		uint32_t mipWidth = static_cast<uint32_t>(mPrefilterMapSize * std::pow(0.5, mip));
-		uint32_t mipHeight = static_cast<uint32_t>(mPrefilterMapSize * std::pow(0.5, mip));
-		mCaptureFramebuffer.ResizeDepthStencilBuffer(mipWidth, mipHeight);
-		glViewport(0, 0, mipWidth, mipHeight);
+		uint32_t mipSize = static_cast<uint32_t>(mPrefilterMapSize * std::pow(0.5, mip));
 
-		float roughness = static_cast<float>(mip) / static_cast<float>(maxMipLevels - 1);
+		float roughness = static_cast<float>(mip) / static_cast<float>(mPrefilterMipCount - 1);
 		SetFloat(programID, "roughness", roughness);
-		for (unsigned int i = 0; i < 6; i++)
-		{
-			SetMat4(programID, "sceneConstant.view", mCaptureViews[i]);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mImageBasedLightRenderItem.prefilterMap->GetTexture(), mip);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			auto primitiveType = mImageBasedLightRenderItem.mesh->GetPrimitiveType();
-			auto indexCount = mImageBasedLightRenderItem.mesh->GetIndexCount();
-			auto indexFormat = mImageBasedLightRenderItem.mesh->GetIndexFormat();
-			auto vertexAttribArray = mImageBasedLightRenderItem.mesh->GetVertexAttribArray();
+		DrawCaptureCube(programID, mImageBasedLightRenderItem.prefilterMap->GetTexture(), mip, mipSize,
+			"prefiltermap", "(" + std::to_string(mip) + ")");
+	}
+}
+
+void ImageBasedLight::DispatchPreFilteredEnvironmentMap(uint32_t programID)
+{
+	SetInt(programID, "prefilterSize", mPrefilterMapSize);
+	SetFloat(programID, "environmentSize", static_cast<float>(mCubeMapSize));
 
-			glBindVertexArray(vertexAttribArray);
-			glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
-			glBindVertexArray(0);
+	// one image unit per mip, the shader picks the unit of its work group's mip.
+	uint32_t prefilterMap = mImageBasedLightRenderItem.prefilterMap->GetTexture();
+	uint32_t tileCount = 0;
+	for (uint32_t mip = 0; mip < mPrefilterMipCount; mip++)
+	{
+		glBindImageTexture(mip, prefilterMap, mip, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
 
-			std::string fileName = mTextureDirectoryName + "\\" + mHDRName + "\\prefiltermap\\" + mTextureNames[i] + "(" + std::to_string(mip) + ").png";
-			SaveScreenshotToPNG(fileName, mipWidth, mipHeight);
-		}
+		uint32_t mipSize = std::max(mPrefilterMapSize >> mip, 1u);
+		uint32_t mipTileCount = (mipSize + mPrefilterTileSize - 1) / mPrefilterTileSize;
+		tileCount += mipTileCount * mipTileCount;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDispatchCompute(tileCount, 1, 6);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	for (uint32_t mip = 0; mip < mPrefilterMipCount; mip++)
+	{
+		glBindImageTexture(mip, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+		uint32_t mipSize = std::max(mPrefilterMapSize >> mip, 1u);
+		SaveCubeMapFaces(prefilterMap, mip, mipSize, "prefiltermap", "(" + std::to_string(mip) + ")");
+	}
 }
 
 void ImageBasedLight::DrawBRDFLookUpTable(uint32_t programID)
@@ -262,11 +270,11 @@ void ImageBasedLight::DrawBRDFLookUpTable(uint32_t programID)
 
 	glUseProgram(programID);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mCaptureFramebuffer.GetFramebuffer());
-	mCaptureFramebuffer.ResizeDepthStencilBuffer(mBrdfLUTSize, mBrdfLUTSize);
+	uint32_t captureFramebuffer = GetTransientResourcePool().AcquireFramebuffer();
+	glBindFramebuffer(GL_FRAMEBUFFER, captureFramebuffer);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mImageBasedLightRenderItem.brdfLUT->GetTexture(), 0);
 	glViewport(0, 0, mBrdfLUTSize, mBrdfLUTSize);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClear(GL_COLOR_BUFFER_BIT);
 
 	Mesh* quad = &mBrdfLUTQuad;
 	auto primitiveType = quad->GetPrimitiveType();
@@ -282,4 +290,77 @@ void ImageBasedLight::DrawBRDFLookUpTable(uint32_t programID)
 	SaveScreenshotToPNG(fileName, mBrdfLUTSize, mBrdfLUTSize);
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GetTransientResourcePool().ReleaseFramebuffer(captureFramebuffer);
+}
+
+void ImageBasedLight::DrawCaptureCube(uint32_t programID, uint32_t cubeMapTexture, uint32_t mipLevel, uint32_t size,
+	const std::string& directoryName, const std::string& fileNameSuffix)
+{
+	auto primitiveType = mImageBasedLightRenderItem.mesh->GetPrimitiveType();
+	auto indexCount = mImageBasedLightRenderItem.mesh->GetIndexCount();
+	auto indexFormat = mImageBasedLightRenderItem.mesh->GetIndexFormat();
+	auto vertexAttribArray = mImageBasedLightRenderItem.mesh->GetVertexAttribArray();
+
+	glViewport(0, 0, size, size); // don't forget to configure the viewport to the capture dimensions.
+	uint32_t captureFramebuffer = GetTransientResourcePool().AcquireFramebuffer();
+	glBindFramebuffer(GL_FRAMEBUFFER, captureFramebuffer);
+
+	// programs linked with equirectangularToCubeLayered.vert draw all six faces in one instanced draw.
+	bool isLayered = glGetUniformLocation(programID, "captureViews[0]") != -1;
+	if (isLayered)
+	{
+		for (unsigned int i = 0; i < 6; i++)
+			SetMat4(programID, "captureViews[" + std::to_string(i) + "]", mCaptureViews[i]);
+
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cubeMapTexture, mipLevel);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glBindVertexArray(vertexAttribArray);
+		glDrawElementsInstanced(primitiveType, indexCount, indexFormat, nullptr, 6);
+		glBindVertexArray(0);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			SetMat4(programID, "sceneConstant.view", mCaptureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubeMapTexture, mipLevel);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			glBindVertexArray(vertexAttribArray);
+			glDrawElements(primitiveType, indexCount, indexFormat, nullptr);
+			glBindVertexArray(0);
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GetTransientResourcePool().ReleaseFramebuffer(captureFramebuffer);
+
+	SaveCubeMapFaces(cubeMapTexture, mipLevel, size, directoryName, fileNameSuffix);
+}
+
+void ImageBasedLight::SaveCubeMapFaces(uint32_t cubeMapTexture, uint32_t mipLevel, uint32_t size,
+	const std::string& directoryName, const std::string& fileNameSuffix)
+{
+	// faces are attached one by one to read them back.
+	uint32_t readFramebuffer = GetTransientResourcePool().AcquireFramebuffer();
+	glBindFramebuffer(GL_FRAMEBUFFER, readFramebuffer);
+
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubeMapTexture, mipLevel);
+
+		std::string fileName = mTextureDirectoryName + "\\" + mHDRName + "\\" + directoryName + "\\" + mTextureNames[i] + fileNameSuffix + ".png";
+		SaveScreenshotToPNG(fileName, size, size);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GetTransientResourcePool().ReleaseFramebuffer(readFramebuffer);
+}
+
+TransientResourcePool& ImageBasedLight::GetTransientResourcePool()
+{
+	if (mTransientResourcePool != nullptr)
+		return *mTransientResourcePool;
+	return mLocalTransientResourcePool;
 }
@@ -1,12 +1,15 @@
 #pragma once
 #include "BasicGeometryGenerator.h"
+#include "BrdfLookUpTable.h"
 #include "Camera.h"
 #include "Framebuffer.h"
+#include "HalfFloatImage.h"
 #include "Mesh.h"
 #include "Model.h"
 #include "Shader.h"
 #include "Stdafx.h"
 #include "Texture.h"
+#include "TransientResourcePool.h"
 #include "Utility.h"
 
 class ImageBasedLight
@@ -25,6 +28,13 @@ public:
 		const std::string& hdrName
 	);
 
+	// capture framebuffers and the equirectangular source come from this pool, several lights can share one.
+	// without it a pool of its own is used.
+	void SetTransientResourcePool(TransientResourcePool* pool);
+
+	// the environment independent BRDF table is taken from here instead of being rendered per light. call before BuildResources.
+	void SetBrdfLookUpTable(BrdfLookUpTable* brdfLookUpTable);
+
 	void BuildResources();
 	void DeleteResources();
 
@@ -37,15 +47,23 @@ public:
 private:
 	void BuildMeshes();
 	void BuildTextures();
-	void BuildFramebuffers();
 	void BuildMatrices();
 	void BuildRenderItems();
 
 	void DrawCubeMap(uint32_t programID);
 	void DrawIrradianceMap(uint32_t programID);
 	void DrawPreFilteredEnvironmentMap(uint32_t programID);
+	void DispatchPreFilteredEnvironmentMap(uint32_t programID);
 	void DrawBRDFLookUpTable(uint32_t programID);
 
+	// renders the six faces of one cube map level and saves them as png.
+	void DrawCaptureCube(uint32_t programID, uint32_t cubeMapTexture, uint32_t mipLevel, uint32_t size,
+		const std::string& directoryName, const std::string& fileNameSuffix);
+	void SaveCubeMapFaces(uint32_t cubeMapTexture, uint32_t mipLevel, uint32_t size,
+		const std::string& directoryName, const std::string& fileNameSuffix);
+
+	TransientResourcePool& GetTransientResourcePool();
+
 	Mesh mCubeMapBox;
 	Mesh mBrdfLUTQuad;
 
@@ -62,7 +80,12 @@ private:
 	uint32_t cubeMapVertexShaderID;
 	std::unordered_map<std::string, Texture> mBasicTextures;
 
-	Framebuffer mCaptureFramebuffer;
+	// the capture passes only write color, so they need no depth buffer and nothing to resize per pass.
+	TransientResourcePool* mTransientResourcePool = nullptr;
+	TransientResourcePool mLocalTransientResourcePool;
+	uint32_t mEquirectangularMap = 0; // from the pool between BuildResources and the cube map capture
+
+	BrdfLookUpTable* mBrdfLookUpTable = nullptr;
 
 	glm::mat4 mCaptureProjection;
 	std::array<glm::mat4, 6> mCaptureViews;
@@ -71,4 +94,6 @@ private:
 	static const uint32_t mIrradianceMapSize;
 	static const uint32_t mPrefilterMapSize;
 	static const uint32_t mBrdfLUTSize;
+	static const uint32_t mPrefilterMipCount; // must match PREFILTER_MIP_COUNT of prefilterMap.comp
+	static const uint32_t mPrefilterTileSize;
 };
\ No newline at end of file
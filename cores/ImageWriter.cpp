@@ -0,0 +1,414 @@
+#include "ImageWriter.h"
+#include "CpuTracer.h"
+
+bool ParseImageFileFormat(const std::string& name, ImageFileFormat& format)
+{
+	if (name == "png")
+		format = ImageFileFormat::PNG;
+	else if (name == "qoi")
+		format = ImageFileFormat::QOI;
+	else if (name == "raw")
+		format = ImageFileFormat::Raw;
+	else if (name == "exr")
+		format = ImageFileFormat::EXR;
+	else if (name == "pfm")
+		format = ImageFileFormat::PFM;
+	else
+		return false;
+	return true;
+}
+std::string GetImageFileExtension(ImageFileFormat format)
+{
+	switch (format)
+	{
+	case ImageFileFormat::QOI:
+		return ".qoi";
+	case ImageFileFormat::Raw:
+		return ".raw";
+	case ImageFileFormat::EXR:
+		return ".exr";
+	case ImageFileFormat::PFM:
+		return ".pfm";
+	default:
+		return ".png";
+	}
+}
+bool IsHDRImageFileFormat(ImageFileFormat format)
+{
+	return format == ImageFileFormat::EXR || format == ImageFileFormat::PFM;
+}
+
+ImageWriter::~ImageWriter()
+{
+	DeleteImageWriter();
+}
+
+void ImageWriter::Initialize(ImageFileFormat format, uint32_t threadCount, uint32_t maxPendingImageCount)
+{
+	DeleteImageWriter();
+
+	// the calling thread keeps rendering, so it is not counted as a worker.
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	if (maxPendingImageCount == 0)
+		maxPendingImageCount = threadCount * 2;
+
+	mFormat = format;
+	mMaxPendingImageCount = maxPendingImageCount;
+	mIsStopping = false;
+	mFailedImageCount = 0;
+	for (uint32_t i = 0; i < threadCount; i++)
+		mThreads.emplace_back(&ImageWriter::WorkerLoop, this);
+}
+void ImageWriter::DeleteImageWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+	}
+	mQueueCondition.notify_all();
+
+	for (auto& thread : mThreads)
+		thread.join();
+	mThreads.clear();
+}
+
+void ImageWriter::SaveFramebuffer(const std::string& fileName, uint32_t width, uint32_t height)
+{
+	TRACE_CPU_ZONE("SaveFramebuffer");
+
+	GLenum format = GL_NONE, type = GL_NONE;
+	uint32_t pixelSize = 0;
+	GetReadBackFormat(format, type, pixelSize);
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * pixelSize);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_PACK_SKIP_ROWS, 0);
+	glPixelStorei(GL_PACK_SKIP_PIXELS, 0);
+	glReadPixels(0, 0, width, height, format, type, pixels.data());
+
+	SaveImage(fileName, width, height, std::move(pixels));
+}
+void ImageWriter::SaveImage(const std::string& fileName, uint32_t width, uint32_t height, std::vector<uint8_t> pixels)
+{
+	PendingImage image;
+	image.fileName = fileName;
+	image.width = width;
+	image.height = height;
+	image.pixels = std::move(pixels);
+
+	// without workers the image is written right away.
+	if (mThreads.empty())
+	{
+		if (!WriteImage(image))
+			mFailedImageCount++;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDoneCondition.wait(lock, [this] { return mPendingImages.size() < mMaxPendingImageCount; });
+	mPendingImages.push_back(std::move(image));
+	lock.unlock();
+	mQueueCondition.notify_one();
+}
+void ImageWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDoneCondition.wait(lock, [this] { return mPendingImages.empty() && mWritingImageCount == 0; });
+}
+
+ImageFileFormat ImageWriter::GetFormat()
+{
+	return mFormat;
+}
+void ImageWriter::GetReadBackFormat(GLenum& format, GLenum& type, uint32_t& pixelSize)
+{
+	// png goes through opencv, which expects bgr.
+	format = mFormat == ImageFileFormat::PNG ? GL_BGR : GL_RGB;
+	type = GL_UNSIGNED_BYTE;
+	pixelSize = 3;
+	if (mFormat == ImageFileFormat::EXR)
+	{
+		type = GL_HALF_FLOAT;
+		pixelSize = 6;
+	}
+	else if (mFormat == ImageFileFormat::PFM)
+	{
+		type = GL_FLOAT;
+		pixelSize = 12;
+	}
+}
+uint32_t ImageWriter::GetFailedImageCount()
+{
+	return mFailedImageCount;
+}
+
+void ImageWriter::WorkerLoop()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQueueCondition.wait(lock, [this] { return mIsStopping || !mPendingImages.empty(); });
+		// pending images are still written when the writer stops.
+		if (mPendingImages.empty())
+			return;
+
+		PendingImage image = std::move(mPendingImages.front());
+		mPendingImages.pop_front();
+		mWritingImageCount++;
+		lock.unlock();
+		mDoneCondition.notify_all();
+
+		if (!WriteImage(image))
+			mFailedImageCount++;
+
+		lock.lock();
+		mWritingImageCount--;
+		lock.unlock();
+		mDoneCondition.notify_all();
+	}
+}
+bool ImageWriter::WriteImage(const PendingImage& image)
+{
+	TRACE_CPU_ZONE("WriteImage");
+
+	// written under a temporary name and renamed, so an existing output is always a complete one.
+	// the temporary name keeps the extension, opencv picks the encoder from it.
+	std::string temporaryFileName = image.fileName + ".partial" + GetImageFileExtension(mFormat);
+
+	bool isWritten = false;
+	switch (mFormat)
+	{
+	case ImageFileFormat::PNG:
+		isWritten = WritePNG(temporaryFileName, image);
+		break;
+	case ImageFileFormat::QOI:
+		isWritten = WriteQOI(temporaryFileName, image);
+		break;
+	case ImageFileFormat::Raw:
+		isWritten = WriteRaw(temporaryFileName, image);
+		break;
+	case ImageFileFormat::EXR:
+		isWritten = WriteEXR(temporaryFileName, image);
+		break;
+	case ImageFileFormat::PFM:
+		isWritten = WritePFM(temporaryFileName, image);
+		break;
+	}
+	if (!isWritten)
+	{
+		std::cout << "Failed to write " << temporaryFileName << std::endl;
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFileName, image.fileName, error);
+	if (error)
+	{
+		std::cout << "Failed to rename " << temporaryFileName << ": " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ImageWriter::WritePNG(const std::string& fileName, const PendingImage& image)
+{
+	cv::Mat readBack(image.height, image.width, CV_8UC3, const_cast<uint8_t*>(image.pixels.data()));
+	cv::Mat flipped;
+	cv::flip(readBack, flipped, 0);
+
+	// the lowest zlib level, most of the default level's time buys little on rendered images.
+	std::vector<int> parameters = { cv::IMWRITE_PNG_COMPRESSION, 1 };
+	return cv::imwrite(fileName, flipped, parameters);
+}
+bool ImageWriter::WriteQOI(const std::string& fileName, const PendingImage& image)
+{
+	// https://qoiformat.org/qoi-specification.pdf, 3 channels, srgb.
+	struct Pixel
+	{
+		uint8_t r = 0, g = 0, b = 0, a = 0;
+		bool operator==(const Pixel& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b && a == rhs.a; }
+	};
+
+	std::vector<uint8_t> data;
+	data.reserve(14 + static_cast<size_t>(image.width) * image.height * 4 + 8);
+	auto writeBigEndian = [&data](uint32_t value)
+	{
+		data.push_back(static_cast<uint8_t>(value >> 24));
+		data.push_back(static_cast<uint8_t>(value >> 16));
+		data.push_back(static_cast<uint8_t>(value >> 8));
+		data.push_back(static_cast<uint8_t>(value));
+	};
+	data.insert(data.end(), { 'q', 'o', 'i', 'f' });
+	writeBigEndian(image.width);
+	writeBigEndian(image.height);
+	data.push_back(3);
+	data.push_back(0);
+
+	std::array<Pixel, 64> seenPixels{};
+	Pixel previous{ 0, 0, 0, 255 };
+	uint32_t run = 0;
+	size_t rowSize = static_cast<size_t>(image.width) * 3;
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint8_t* row = image.pixels.data() + (image.height - 1 - y) * rowSize;
+		for (uint32_t x = 0; x < image.width; x++)
+		{
+			Pixel pixel{ row[x * 3], row[x * 3 + 1], row[x * 3 + 2], 255 };
+			bool isLastPixel = y == image.height - 1 && x == image.width - 1;
+			if (pixel == previous)
+			{
+				run++;
+				if (run == 62 || isLastPixel)
+				{
+					data.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				data.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+				run = 0;
+			}
+
+			uint32_t hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64;
+			if (seenPixels[hash] == pixel)
+				data.push_back(static_cast<uint8_t>(hash));
+			else
+			{
+				seenPixels[hash] = pixel;
+
+				// alpha is always opaque, so the differences to the previous pixel are enough.
+				int dr = static_cast<int8_t>(pixel.r - previous.r);
+				int dg = static_cast<int8_t>(pixel.g - previous.g);
+				int db = static_cast<int8_t>(pixel.b - previous.b);
+				int drg = dr - dg;
+				int dbg = db - dg;
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					data.push_back(static_cast<uint8_t>(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+				else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7)
+				{
+					data.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+					data.push_back(static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8)));
+				}
+				else
+					data.insert(data.end(), { 0xfe, pixel.r, pixel.g, pixel.b });
+			}
+			previous = pixel;
+		}
+	}
+	data.insert(data.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+
+	std::ofstream file(fileName, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(file);
+}
+bool ImageWriter::WriteRaw(const std::string& fileName, const PendingImage& image)
+{
+	RawImageHeader header;
+	header.width = image.width;
+	header.height = image.height;
+	header.channelCount = 3;
+	header.bytesPerChannel = 1;
+
+	std::ofstream file(fileName, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	size_t rowSize = static_cast<size_t>(image.width) * 3;
+	for (uint32_t y = 0; y < image.height; y++)
+		file.write(reinterpret_cast<const char*>(image.pixels.data() + (image.height - 1 - y) * rowSize), rowSize);
+	return static_cast<bool>(file);
+}
+bool ImageWriter::WriteEXR(const std::string& fileName, const PendingImage& image)
+{
+	// minimal scanline openexr: half b, g, r channels, no compression, one scanline per block.
+	std::vector<uint8_t> data;
+	auto writeBytes = [&data](const void* bytes, size_t size)
+	{
+		data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+	};
+	auto writeInt = [&writeBytes](int32_t value) { writeBytes(&value, sizeof(value)); };
+	auto writeFloat = [&writeBytes](float value) { writeBytes(&value, sizeof(value)); };
+	auto writeAttribute = [&writeBytes, &writeInt](const char* name, const char* type, int32_t size)
+	{
+		writeBytes(name, std::strlen(name) + 1);
+		writeBytes(type, std::strlen(type) + 1);
+		writeInt(size);
+	};
+
+	const uint8_t magic[] = { 0x76, 0x2f, 0x31, 0x01, 0x02, 0x00, 0x00, 0x00 };
+	writeBytes(magic, sizeof(magic));
+
+	// channels are stored in alphabetical order.
+	const char* channelNames[] = { "B", "G", "R" };
+	const uint32_t channelOffsets[] = { 2, 1, 0 };
+	writeAttribute("channels", "chlist", 3 * 18 + 1);
+	for (const char* channelName : channelNames)
+	{
+		writeBytes(channelName, 2);
+		writeInt(1); // half
+		writeInt(0); // pLinear and reserved
+		writeInt(1); // x sampling
+		writeInt(1); // y sampling
+	}
+	data.push_back(0);
+
+	writeAttribute("compression", "compression", 1);
+	data.push_back(0);
+	int32_t maxX = static_cast<int32_t>(image.width) - 1;
+	int32_t maxY = static_cast<int32_t>(image.height) - 1;
+	for (const char* windowName : { "dataWindow", "displayWindow" })
+	{
+		writeAttribute(windowName, "box2i", 16);
+		writeInt(0);
+		writeInt(0);
+		writeInt(maxX);
+		writeInt(maxY);
+	}
+	writeAttribute("lineOrder", "lineOrder", 1);
+	data.push_back(0);
+	writeAttribute("pixelAspectRatio", "float", 4);
+	writeFloat(1.0f);
+	writeAttribute("screenWindowCenter", "v2f", 8);
+	writeFloat(0.0f);
+	writeFloat(0.0f);
+	writeAttribute("screenWindowWidth", "float", 4);
+	writeFloat(1.0f);
+	data.push_back(0);
+
+	int32_t blockDataSize = static_cast<int32_t>(image.width) * 3 * sizeof(uint16_t);
+	uint64_t blockOffset = data.size() + static_cast<uint64_t>(image.height) * sizeof(uint64_t);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		writeBytes(&blockOffset, sizeof(blockOffset));
+		blockOffset += 2 * sizeof(int32_t) + blockDataSize;
+	}
+
+	const uint16_t* pixels = reinterpret_cast<const uint16_t*>(image.pixels.data());
+	std::vector<uint16_t> block(static_cast<size_t>(image.width) * 3);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint16_t* row = pixels + static_cast<size_t>(image.height - 1 - y) * image.width * 3;
+		for (uint32_t channel = 0; channel < 3; channel++)
+			for (uint32_t x = 0; x < image.width; x++)
+				block[channel * image.width + x] = row[x * 3 + channelOffsets[channel]];
+
+		writeInt(static_cast<int32_t>(y));
+		writeInt(blockDataSize);
+		writeBytes(block.data(), blockDataSize);
+	}
+
+	std::ofstream file(fileName, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(file);
+}
+bool ImageWriter::WritePFM(const std::string& fileName, const PendingImage& image)
+{
+	// pfm rows run bottom-up like the read back, a negative scale means little endian.
+	std::ofstream file(fileName, std::ios::binary);
+	file << "PF\n" << image.width << " " << image.height << "\n-1.0\n";
+	file.write(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+	return static_cast<bool>(file);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include "Stdafx.h"
+
+// file formats of saved renders.
+// png and qoi are 8-bit, raw dumps the 8-bit pixels behind a small header so the file can be mapped as is,
+// exr (half, uncompressed) and pfm (float) keep the linear hdr values the render target holds.
+enum class ImageFileFormat
+{
+	PNG,
+	QOI,
+	Raw,
+	EXR,
+	PFM
+};
+
+bool ParseImageFileFormat(const std::string& name, ImageFileFormat& format); // "png", "qoi", "raw", "exr", "pfm"
+std::string GetImageFileExtension(ImageFileFormat format); // with the dot
+bool IsHDRImageFileFormat(ImageFileFormat format);
+
+// header of raw files, followed by top-down rows of width * channelCount * bytesPerChannel bytes.
+struct RawImageHeader
+{
+	uint32_t magic = 0x31574152; // "RAW1"
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint16_t channelCount = 0;
+	uint16_t bytesPerChannel = 0;
+};
+
+// saves the bound read framebuffer.
+// the pixels are read back on the calling thread, encoding and writing run on worker threads,
+// so the next frame renders while the previous ones are encoded.
+class ImageWriter
+{
+public:
+	ImageWriter() = default;
+	~ImageWriter();
+	ImageWriter(const ImageWriter& rhs) = delete;
+	ImageWriter& operator=(const ImageWriter& rhs) = delete;
+
+	// threadCount 0 uses every hardware thread but one, the caller blocks while maxPendingImageCount images wait.
+	void Initialize(ImageFileFormat format, uint32_t threadCount = 0, uint32_t maxPendingImageCount = 0);
+	// writes what is still pending and stops the workers.
+	void DeleteImageWriter();
+
+	// the file is written under a temporary name and renamed once complete.
+	void SaveFramebuffer(const std::string& fileName, uint32_t width, uint32_t height);
+	// pixels read back elsewhere, e.g. a texture array layer, in GetReadBackFormat with bottom-up rows.
+	void SaveImage(const std::string& fileName, uint32_t width, uint32_t height, std::vector<uint8_t> pixels);
+	// blocks until every saved image is on disk.
+	void Flush();
+
+	ImageFileFormat GetFormat();
+	// format and type to read pixels back in for this writer, and the bytes per pixel.
+	void GetReadBackFormat(GLenum& format, GLenum& type, uint32_t& pixelSize);
+	uint32_t GetFailedImageCount();
+private:
+	struct PendingImage
+	{
+		std::string fileName;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels; // bottom-up rows as read back
+	};
+
+	void WorkerLoop();
+	bool WriteImage(const PendingImage& image);
+
+	bool WritePNG(const std::string& fileName, const PendingImage& image);
+	bool WriteQOI(const std::string& fileName, const PendingImage& image);
+	bool WriteRaw(const std::string& fileName, const PendingImage& image);
+	bool WriteEXR(const std::string& fileName, const PendingImage& image);
+	bool WritePFM(const std::string& fileName, const PendingImage& image);
+private:
+	ImageFileFormat mFormat = ImageFileFormat::PNG;
+	uint32_t mMaxPendingImageCount = 0;
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mQueueCondition; // an image was queued or the writer stops
+	std::condition_variable mDoneCondition; // an image was taken or written
+	std::deque<PendingImage> mPendingImages;
+	uint32_t mWritingImageCount = 0;
+	bool mIsStopping = false;
+
+	std::atomic<uint32_t> mFailedImageCount = 0;
+};
\ No newline at end of file
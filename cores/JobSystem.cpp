@@ -0,0 +1,282 @@
+#include "CpuTracer.h"
+#include "JobSystem.h"
+
+namespace
+{
+	// set on the worker threads, jobs they submit go to their own deque.
+	thread_local JobSystem* workerJobSystem = nullptr;
+	thread_local uint32_t workerIndex = 0;
+
+	constexpr uint32_t noWorkerIndex = std::numeric_limits<uint32_t>::max();
+}
+
+JobSystem::~JobSystem()
+{
+	DeleteJobSystem();
+}
+
+void JobSystem::Initialize(uint32_t threadCount)
+{
+	DeleteJobSystem();
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	mMainThreadID = std::this_thread::get_id();
+	mIsStopping = false;
+	for (uint32_t i = 0; i < threadCount; i++)
+		mWorkerQueues.push_back(std::make_unique<WorkerQueue>());
+	for (uint32_t i = 0; i < threadCount; i++)
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+void JobSystem::DeleteJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mIsStopping = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (auto& thread : mThreads)
+		thread.join();
+	mThreads.clear();
+	mWorkerQueues.clear();
+
+	// main thread jobs still queued run here, worker jobs they release run inline now.
+	if (IsMainThread())
+		ProcessMainThreadJobs();
+}
+
+JobHandle JobSystem::CreateJob(std::function<void()> function, JobAffinity affinity)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->function = std::move(function);
+	job->affinity = affinity;
+	return job;
+}
+void JobSystem::AddDependency(const JobHandle& job, const JobHandle& dependency)
+{
+	std::lock_guard<std::mutex> lock(dependency->mutex);
+	if (dependency->isFinished)
+	{
+		if (dependency->exception)
+			job->exception = dependency->exception;
+		return;
+	}
+	dependency->continuations.push_back(job);
+	job->unfinishedDependencyCount++;
+}
+void JobSystem::Submit(const JobHandle& job)
+{
+	if (--job->unfinishedDependencyCount == 0)
+		Enqueue(job);
+}
+JobHandle JobSystem::Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies, JobAffinity affinity)
+{
+	JobHandle job = CreateJob(std::move(function), affinity);
+	for (const auto& dependency : dependencies)
+		AddDependency(job, dependency);
+	Submit(job);
+	return job;
+}
+JobHandle JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> function,
+	const std::vector<JobHandle>& dependencies)
+{
+	batchSize = std::max(batchSize, 1u);
+
+	// the batches share the function, the last one to finish releases the join job.
+	auto sharedFunction = std::make_shared<std::function<void(uint32_t, uint32_t)>>(std::move(function));
+	JobHandle joinJob = CreateJob([] {});
+	for (uint32_t begin = 0; begin < count; begin += batchSize)
+	{
+		uint32_t end = std::min(begin + batchSize, count);
+		JobHandle batchJob = CreateJob([sharedFunction, begin, end] { (*sharedFunction)(begin, end); });
+		for (const auto& dependency : dependencies)
+			AddDependency(batchJob, dependency);
+		AddDependency(joinJob, batchJob);
+		Submit(batchJob);
+	}
+	for (const auto& dependency : dependencies)
+		AddDependency(joinJob, dependency);
+	Submit(joinJob);
+	return joinJob;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	TRACE_CPU_ZONE("JobSystem::Wait");
+
+	// the waiting thread helps instead of blocking, the main thread also runs the gl jobs the graph may wait for.
+	bool isMainThread = IsMainThread();
+	uint32_t ownIndex = workerJobSystem == this ? workerIndex : noWorkerIndex;
+	while (!job->isFinished)
+	{
+		JobHandle otherJob = isMainThread ? PopMainThreadJob() : nullptr;
+		if (!otherJob)
+			otherJob = PopWorkerJob(ownIndex);
+
+		if (otherJob)
+			Execute(otherJob);
+		else
+			std::this_thread::yield();
+	}
+
+	if (job->exception)
+		std::rethrow_exception(job->exception);
+}
+void JobSystem::ProcessMainThreadJobs(uint32_t maxJobCount)
+{
+	TRACE_CPU_ZONE("JobSystem::ProcessMainThreadJobs");
+
+	for (uint32_t i = 0; maxJobCount == 0 || i < maxJobCount; i++)
+	{
+		JobHandle job = PopMainThreadJob();
+		if (!job)
+			break;
+		Execute(job);
+	}
+}
+
+uint32_t JobSystem::GetWorkerCount()
+{
+	return static_cast<uint32_t>(mThreads.size());
+}
+bool JobSystem::IsMainThread()
+{
+	return std::this_thread::get_id() == mMainThreadID;
+}
+
+// private methods
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	workerJobSystem = this;
+	workerIndex = index;
+
+	while (true)
+	{
+		JobHandle job = PopWorkerJob(index);
+		if (job)
+		{
+			Execute(job);
+			continue;
+		}
+
+		// queued jobs are still run when the system stops.
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWakeCondition.wait(lock, [this] { return mIsStopping || mQueuedJobCount > 0; });
+		if (mIsStopping && mQueuedJobCount == 0)
+			return;
+	}
+}
+void JobSystem::Enqueue(const JobHandle& job)
+{
+	if (job->affinity == JobAffinity::MainThread)
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		mMainThreadJobs.push_back(job);
+		return;
+	}
+
+	// no workers, before Initialize or after DeleteJobSystem.
+	if (mWorkerQueues.empty())
+	{
+		Execute(job);
+		return;
+	}
+
+	// counted before it is pushed, so a worker never sees the count drop below the jobs it can find.
+	mQueuedJobCount++;
+	uint32_t queueIndex = workerJobSystem == this ? workerIndex : mNextQueue++ % mWorkerQueues.size();
+	{
+		std::lock_guard<std::mutex> lock(mWorkerQueues[queueIndex]->mutex);
+		mWorkerQueues[queueIndex]->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+	}
+	mWakeCondition.notify_one();
+}
+JobHandle JobSystem::PopWorkerJob(uint32_t index)
+{
+	uint32_t queueCount = static_cast<uint32_t>(mWorkerQueues.size());
+	if (queueCount == 0)
+		return nullptr;
+
+	// newest of the own deque, its data is likely still in cache.
+	JobHandle job;
+	if (index != noWorkerIndex)
+	{
+		WorkerQueue& queue = *mWorkerQueues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+	}
+
+	// oldest of another deque, usually the root of a larger piece of work.
+	uint32_t firstVictim = index != noWorkerIndex ? index + 1 : 0;
+	for (uint32_t i = 0; !job && i < queueCount; i++)
+	{
+		uint32_t victimIndex = (firstVictim + i) % queueCount;
+		if (victimIndex == index)
+			continue;
+
+		WorkerQueue& queue = *mWorkerQueues[victimIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+	}
+
+	if (job)
+		mQueuedJobCount--;
+	return job;
+}
+JobHandle JobSystem::PopMainThreadJob()
+{
+	std::lock_guard<std::mutex> lock(mMainThreadMutex);
+	if (mMainThreadJobs.empty())
+		return nullptr;
+
+	JobHandle job = std::move(mMainThreadJobs.front());
+	mMainThreadJobs.pop_front();
+	return job;
+}
+void JobSystem::Execute(const JobHandle& job)
+{
+	// a job whose dependency threw is skipped and passes the exception on.
+	if (!job->exception)
+	{
+		try
+		{
+			job->function();
+		}
+		catch (...)
+		{
+			job->exception = std::current_exception();
+		}
+	}
+	job->function = nullptr;
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->isFinished = true;
+		continuations.swap(job->continuations);
+	}
+
+	for (const auto& continuation : continuations)
+	{
+		if (job->exception)
+		{
+			std::lock_guard<std::mutex> lock(continuation->mutex);
+			continuation->exception = job->exception;
+		}
+		if (--continuation->unfinishedDependencyCount == 0)
+			Enqueue(continuation);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include "Stdafx.h"
+
+// where a job may run, gl calls need the thread that owns the context.
+enum class JobAffinity
+{
+	Worker,
+	MainThread
+};
+
+struct Job;
+using JobHandle = std::shared_ptr<Job>;
+
+struct Job
+{
+	std::function<void()> function;
+	JobAffinity affinity = JobAffinity::Worker;
+
+	std::atomic<uint32_t> unfinishedDependencyCount = 1; // the extra one is released by Submit
+	std::atomic<bool> isFinished = false;
+	std::exception_ptr exception; // rethrown by Wait
+
+	std::mutex mutex; // guards continuations against a dependency finishing while they are added
+	std::vector<JobHandle> continuations;
+};
+
+// worker threads with a deque each, a worker pops its own newest job and steals the oldest one of another
+// worker when it runs dry. jobs wait for their dependencies, jobs with MainThread affinity are queued
+// until the thread that called Initialize runs them in ProcessMainThreadJobs or Wait.
+class JobSystem
+{
+public:
+	JobSystem() = default;
+	~JobSystem();
+	JobSystem(const JobSystem& rhs) = delete;
+	JobSystem& operator=(const JobSystem& rhs) = delete;
+
+	// threadCount 0 uses every hardware thread but the calling one, which becomes the main thread.
+	void Initialize(uint32_t threadCount = 0);
+	// waits for the queued jobs and stops the workers.
+	void DeleteJobSystem();
+
+	// a graph is built from created jobs, then each one is submitted once.
+	JobHandle CreateJob(std::function<void()> function, JobAffinity affinity = JobAffinity::Worker);
+	void AddDependency(const JobHandle& job, const JobHandle& dependency); // call before Submit
+	void Submit(const JobHandle& job);
+	JobHandle Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies = {},
+		JobAffinity affinity = JobAffinity::Worker);
+	// function(begin, end) over batches of [0, count), the returned job finishes after the last batch.
+	JobHandle ParallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> function,
+		const std::vector<JobHandle>& dependencies = {});
+
+	// runs other jobs until the job is finished, rethrows what the job threw.
+	void Wait(const JobHandle& job);
+	// on the main thread, once per frame. maxJobCount 0 runs every queued one.
+	void ProcessMainThreadJobs(uint32_t maxJobCount = 0);
+
+	uint32_t GetWorkerCount();
+	bool IsMainThread();
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	void WorkerLoop(uint32_t workerIndex);
+	void Enqueue(const JobHandle& job);
+	JobHandle PopWorkerJob(uint32_t workerIndex);
+	JobHandle PopMainThreadJob();
+	void Execute(const JobHandle& job);
+private:
+	std::vector<std::unique_ptr<WorkerQueue>> mWorkerQueues;
+	std::vector<std::thread> mThreads;
+	std::thread::id mMainThreadID;
+
+	std::mutex mMainThreadMutex;
+	std::deque<JobHandle> mMainThreadJobs;
+
+	// workers sleep while nothing is queued
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<uint32_t> mQueuedJobCount = 0;
+	std::atomic<uint32_t> mNextQueue = 0; // round robin for jobs submitted outside the workers
+	bool mIsStopping = false;
+};
\ No newline at end of file
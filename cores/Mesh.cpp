@@ -27,21 +27,7 @@ void Mesh::ConfigureMesh(GLenum usage, bool isBoundingBox)
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexByteSize, mIndices.data(), usage);
 	
-	// positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-	
-	// normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-	
-	// texCoords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-
-	// tangents
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+	SetVertexAttributes(mVertexBuffer, 0);
 	
 	glBindVertexArray(0);
 
@@ -50,6 +36,32 @@ void Mesh::ConfigureMesh(GLenum usage, bool isBoundingBox)
 
 	}
 }
+bool Mesh::UpdateVertices(const std::vector<Vertex>& vertices, UploadRing& uploadRing)
+{
+	// a full ring falls back to the vertices the mesh was configured with, an older region may be rewritten already.
+	UploadAllocation allocation;
+	if (!uploadRing.Upload(vertices.data(), vertices.size() * sizeof(Vertex), allocation, sizeof(glm::vec4)))
+	{
+		RestoreVertices();
+		return false;
+	}
+
+	glBindVertexArray(mVertexAttribArray);
+	SetVertexAttributes(allocation.buffer, allocation.offset);
+	glBindVertexArray(0);
+	mIsUsingUploadedVertices = true;
+	return true;
+}
+void Mesh::RestoreVertices()
+{
+	if (!mIsUsingUploadedVertices)
+		return;
+
+	glBindVertexArray(mVertexAttribArray);
+	SetVertexAttributes(mVertexBuffer, 0);
+	glBindVertexArray(0);
+	mIsUsingUploadedVertices = false;
+}
 void Mesh::DeleteMesh()
 {
 	glDeleteVertexArrays(1, &mVertexAttribArray);
@@ -61,6 +73,10 @@ uint32_t Mesh::GetVertexAttribArray()
 {
 	return mVertexAttribArray;
 }
+const std::vector<Vertex>& Mesh::GetVertices()
+{
+	return mVertices;
+}
 
 uint32_t Mesh::GetVertexBuffer()
 {
@@ -156,4 +172,25 @@ void Mesh::CalculateBoundingBoxCenter()
 
 	// diagonal length
 	mDiagnalLength = std::sqrt(std::pow(maxCoordX - mBoundingBoxCenter.x, 2) + pow(maxCoordY - mBoundingBoxCenter.y, 2) + pow(maxCoordZ - mBoundingBoxCenter.z, 2));
+}
+
+void Mesh::SetVertexAttributes(uint32_t vertexBuffer, size_t offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+	// positions
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offset + offsetof(Vertex, position)));
+	
+	// normals
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offset + offsetof(Vertex, normal)));
+	
+	// texCoords
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offset + offsetof(Vertex, texCoord)));
+
+	// tangents
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offset + offsetof(Vertex, tangent)));
 }
\ No newline at end of file
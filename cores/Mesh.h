@@ -1,5 +1,6 @@
 #pragma once
 #include "Stdafx.h"
+#include "UploadRing.h"
 #include "Utility.h"
 
 class Mesh
@@ -10,9 +11,15 @@ public:
 		GLenum primitiveType = GL_TRIANGLES);
 
 	void ConfigureMesh(GLenum usage = GL_STATIC_DRAW, bool isBoundingBox = false);
+	// dynamic vertices of this frame, written into the ring and read from there instead of the vertex buffer.
+	// the count must match the index buffer. the ring rewrites the region after frameCount frames, so call it every
+	// frame the mesh is drawn with dynamic vertices and RestoreVertices before it is drawn with its own again.
+	bool UpdateVertices(const std::vector<Vertex>& vertices, UploadRing& uploadRing);
+	void RestoreVertices();
 	void DeleteMesh();
 
 	uint32_t GetVertexAttribArray();
+	const std::vector<Vertex>& GetVertices();
 
 	uint32_t GetVertexBuffer();
 	uint32_t GetIndexBuffer();
@@ -25,6 +32,7 @@ public:
 	double GetDiagnalLength();
 private:
 	void CalculateBoundingBoxCenter();
+	void SetVertexAttributes(uint32_t vertexBuffer, size_t offset); // with the vertex array bound
 private:
 	std::vector<Vertex> mVertices;
 	UINT vertexByteSize = 0;
@@ -39,6 +47,7 @@ private:
 
 	uint32_t mVertexBuffer = 0;
 	uint32_t mIndexBuffer = 0;
+	bool mIsUsingUploadedVertices = false; // the vertex array reads from a ring allocation
 
 	std::vector<glm::vec3> mBoundingBoxVertices;
 	std::array<uint32_t, 36> mBoundingBoxIndices;
@@ -1,3 +1,4 @@
+#include "CpuTracer.h"
 #include "Model.h"
 
 Model::Model(const std::string& path)
@@ -5,8 +6,21 @@ Model::Model(const std::string& path)
 	LoadModel(path);
 }
 
+void Model::SetTextureStreamer(TextureStreamer* textureStreamer)
+{
+	mTextureStreamer = textureStreamer;
+}
+
 void Model::LoadModel(const std::string& path)
 {
+	ImportModel(path);
+	ConfigureModel();
+}
+
+void Model::ImportModel(const std::string& path)
+{
+	TRACE_CPU_ZONE("Model::ImportModel");
+
 	std::filesystem::path modelPath(path);
 	mDirectoryName = modelPath.parent_path().string();
 	ParseDirectoryName(path);
@@ -19,24 +33,60 @@ void Model::LoadModel(const std::string& path)
 	ProcessNode(scene->mRootNode, scene);
 }
 
+void Model::ConfigureModel()
+{
+	TRACE_CPU_ZONE("Model::ConfigureModel");
+
+	for (auto& modelComponent : mModelComponents)
+		modelComponent.mesh.ConfigureMesh(); // dynamic , LoadModel, ProcessNode, ProcessMesh Լ GLenum usage Ķ ߰
+
+	for (const auto& pendingTexture : mPendingTextures)
+		LoadTexture(pendingTexture);
+	mPendingTextures.clear();
+}
+
 void Model::DeleteModel()
 {
 	for (auto& modelComponent : mModelComponents)
 	{
-		for (auto& roughnessMap : modelComponent.roughnessMaps)
-			roughnessMap.DeleteTexture();
-		for (auto& metallicMap : modelComponent.metallicMaps)
-			metallicMap.DeleteTexture();
-		for (auto& normalMap : modelComponent.normalMaps)
-			normalMap.DeleteTexture();
-		for (auto& specularMap : modelComponent.specularMaps)
-			specularMap.DeleteTexture();
-		for (auto& albedoMap : modelComponent.albedoMaps)
-			albedoMap.DeleteTexture();
+		for (auto* textures : { &modelComponent.roughnessMaps, &modelComponent.metallicMaps,
+			&modelComponent.normalMaps, &modelComponent.specularMaps, &modelComponent.albedoMaps })
+		{
+			for (auto& texture : *textures)
+			{
+				if (mTextureStreamer != nullptr)
+					mTextureStreamer->ReleaseTexture(texture);
+				texture.DeleteTexture();
+			}
+		}
 		modelComponent.mesh.DeleteMesh();
 	}
 }
 
+void Model::RequestTextureSizes(const glm::mat4& world, const glm::vec3& cameraPosition, float fovAngleY, float viewportHeight)
+{
+	if (mTextureStreamer == nullptr)
+		return;
+
+	float worldScale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+	float projectionScale = viewportHeight / std::tan(0.5f * fovAngleY);
+	for (auto& modelComponent : mModelComponents)
+	{
+		// projected diameter of the bounding sphere, the textures are assumed to cover the component once.
+		glm::vec3 center = glm::vec3(world * glm::vec4(modelComponent.boundingCenter, 1.0f));
+		float radius = modelComponent.boundingRadius * worldScale;
+		float distance = std::max(glm::length(center - cameraPosition), radius);
+		float screenSize = distance > 0.0f ? radius / distance * projectionScale : 0.0f;
+
+		for (auto* textures : { &modelComponent.roughnessMaps, &modelComponent.metallicMaps,
+			&modelComponent.normalMaps, &modelComponent.specularMaps, &modelComponent.albedoMaps })
+		{
+			for (auto& texture : *textures)
+				mTextureStreamer->RequestSize(texture, screenSize);
+		}
+	}
+}
+
 std::vector<ModelComponent> Model::GetModelComponents()
 {
 	return mModelComponents;
@@ -124,8 +174,20 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 			indices.push_back(face.mIndices[j]);
 	}
 
+	glm::vec3 minPosition(std::numeric_limits<float>::max());
+	glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+	for (const auto& vertex : vertices)
+	{
+		minPosition = glm::min(minPosition, vertex.position);
+		maxPosition = glm::max(maxPosition, vertex.position);
+	}
+	if (!vertices.empty())
+	{
+		modelComponent.boundingCenter = 0.5f * (minPosition + maxPosition);
+		modelComponent.boundingRadius = 0.5f * glm::length(maxPosition - minPosition);
+	}
+
 	modelComponent.mesh = Mesh(vertices, indices);
-	modelComponent.mesh.ConfigureMesh(); // dynamic , LoadModel, ProcessNode, ProcessMesh Լ GLenum usage Ķ ߰
 
 	if (scene->HasMaterials())
 	{
@@ -153,25 +215,20 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 			
 			modelComponent.material = materialData;
 
-			LoadTexture(material, aiTextureType_DIFFUSE, "albedoMap", modelComponent.albedoMaps);
-			LoadTexture(material, aiTextureType_SPECULAR, "specularMap", modelComponent.specularMaps);
-			LoadTexture(material, aiTextureType_NORMALS, "normalMap", modelComponent.normalMaps);
-			LoadTexture(material, aiTextureType_METALNESS, "metallicMap", modelComponent.metallicMaps);
-			LoadTexture(material, aiTextureType_DIFFUSE_ROUGHNESS, "roughnessMap", modelComponent.roughnessMaps);
+			CollectTextures(material, aiTextureType_DIFFUSE);
+			CollectTextures(material, aiTextureType_SPECULAR);
+			CollectTextures(material, aiTextureType_NORMALS);
+			CollectTextures(material, aiTextureType_METALNESS);
+			CollectTextures(material, aiTextureType_DIFFUSE_ROUGHNESS);
 		}
 	}
 
 	mModelComponents.push_back(modelComponent);
 }
 
-void Model::LoadTexture(aiMaterial* mat, aiTextureType textureType, 
-	const std::string& textureName,  std::vector<Texture>& textureContainer)
+void Model::CollectTextures(aiMaterial* mat, aiTextureType textureType)
 {
 	uint32_t textureCount = mat->GetTextureCount(textureType);
-	if (textureCount == 0)
-		return;
-
-	Texture texture;
 	for (uint32_t i = 0; i < textureCount; i++)
 	{
 		aiString path;
@@ -183,26 +240,50 @@ void Model::LoadTexture(aiMaterial* mat, aiTextureType textureType,
 
 		pathName = mDirectoryName + pathName;
 
-		bool skip = false;
-		for (auto& texture : mTextureLoaded)
+		// the component is pushed after its textures are collected.
+		mPendingTextures.push_back({ mModelComponents.size(), textureType, pathName });
+	}
+}
+
+void Model::LoadTexture(const PendingTexture& pendingTexture)
+{
+	auto& modelComponent = mModelComponents[pendingTexture.componentIndex];
+	std::vector<Texture>* textureContainer = nullptr;
+	switch (pendingTexture.textureType)
+	{
+	case aiTextureType_DIFFUSE: textureContainer = &modelComponent.albedoMaps; break;
+	case aiTextureType_SPECULAR: textureContainer = &modelComponent.specularMaps; break;
+	case aiTextureType_NORMALS: textureContainer = &modelComponent.normalMaps; break;
+	case aiTextureType_METALNESS: textureContainer = &modelComponent.metallicMaps; break;
+	case aiTextureType_DIFFUSE_ROUGHNESS: textureContainer = &modelComponent.roughnessMaps; break;
+	default: return;
+	}
+
+	const std::string& pathName = pendingTexture.fileName;
+	for (auto& texture : mTextureLoaded)
+	{
+		const auto& textureFileName = texture.GetTextureFileName();
+		if (!textureFileName.empty() && textureFileName == pathName)
 		{
-			const auto& textureFileName = texture.GetTextureFileName();
-			if (!textureFileName.empty() && textureFileName == pathName)
-			{
-				textureContainer.push_back(texture);
-				skip = true;
-				break;
-			}
+			textureContainer->push_back(texture);
+			return;
 		}
+	}
 
-		if (!skip)
-		{
-			texture.SetTextureFileName(pathName);
-			texture.CreateTexture2D(GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true);
+	Texture texture;
+	if (mTextureStreamer != nullptr)
+	{
+		// flat normals until the real mips arrive.
+		glm::u8vec4 placeholder = pendingTexture.textureType == aiTextureType_NORMALS ? glm::u8vec4(128, 128, 255, 255) : glm::u8vec4(255);
+		texture = mTextureStreamer->CreateStreamedTexture(pathName, GL_REPEAT, GL_REPEAT, placeholder);
+	}
+	else
+	{
+		texture.SetTextureFileName(pathName);
+		texture.CreateTexture2D(GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true);
+	}
 
-			textureContainer.push_back(texture);
+	textureContainer->push_back(texture);
 
-			mTextureLoaded.push_back(texture);
-		}
-	}
+	mTextureLoaded.push_back(texture);
 }
\ No newline at end of file
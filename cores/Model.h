@@ -5,6 +5,7 @@
 #include "Mesh.h"
 #include "Stdafx.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
 #include "Utility.h"
 
 struct ModelComponent
@@ -18,6 +19,10 @@ struct ModelComponent
 	std::vector<Texture> normalMaps;
 	std::vector<Texture> metallicMaps;
 	std::vector<Texture> roughnessMaps;
+
+	// bounding sphere in model space, sizes the streamed textures on screen
+	glm::vec3 boundingCenter = glm::vec3(0.0f);
+	float boundingRadius = 0.0f;
 };
 
 class Model
@@ -28,7 +33,15 @@ public:
 	Model(const Model& model) = delete;
 	Model operator=(const Model& model) = delete;
 
-	void LoadModel(const std::string& path);
+	void SetTextureStreamer(TextureStreamer* textureStreamer); // call before LoadModel
+	void LoadModel(const std::string& path); // ImportModel then ConfigureModel
+	// reads the file and builds the vertices, no gl calls, so it can run on a worker thread.
+	void ImportModel(const std::string& path);
+	// creates the meshes and textures of the imported model, on the context thread.
+	void ConfigureModel();
+
+	// screen size of every streamed texture from the bounding spheres, once per frame before TextureStreamer::Update.
+	void RequestTextureSizes(const glm::mat4& world, const glm::vec3& cameraPosition, float fovAngleY, float viewportHeight);
 
 	void DeleteModel();
 
@@ -40,12 +53,22 @@ private:
 	void ProcessNode(aiNode* node, const aiScene* scene);
 	void ProcessMesh(aiMesh* mesh, const aiScene* scene);
 
-	void LoadTexture(aiMaterial* mat, aiTextureType textureType, 
-		const std::string& textureName, std::vector<Texture>& textureContainer);
+	struct PendingTexture
+	{
+		size_t componentIndex = 0;
+		aiTextureType textureType = aiTextureType_NONE;
+		std::string fileName;
+	};
+
+	void CollectTextures(aiMaterial* mat, aiTextureType textureType);
+	void LoadTexture(const PendingTexture& pendingTexture);
 private:
 	std::vector<ModelComponent> mModelComponents;
 
 	std::vector<Texture> mTextureLoaded; // using texture loading optimization.
+	std::vector<PendingTexture> mPendingTextures; // found by ImportModel, created by ConfigureModel
 
 	std::string mDirectoryName;
+
+	TextureStreamer* mTextureStreamer = nullptr; // textures are streamed when set, loaded whole otherwise
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "MultiViewTarget.h"
+
+void MultiViewTarget::CreateMultiViewTarget(const MultiViewTargetInfo& info)
+{
+	DeleteMultiViewTarget();
+
+	mInfo = info;
+	mInfo.viewCount = std::clamp(info.viewCount, 1u, maxViewCount);
+
+	glGenTextures(1, &mColorTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mColorTexture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, mInfo.colorInternalFormat, mInfo.width, mInfo.height, mInfo.viewCount);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &mDepthTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mDepthTexture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, mInfo.width, mInfo.height, mInfo.viewCount);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// whole arrays attached make the framebuffer layered, gl_Layer then selects the view.
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mColorTexture, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mDepthTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Multi-view framebuffer is not complete!" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// std140 MultiViewConstant: mat4 views[maxViewCount], then vec4 cameraPositions[maxViewCount].
+	glGenBuffers(1, &mViewBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mViewBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, maxViewCount * (sizeof(glm::mat4) + sizeof(glm::vec4)), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+void MultiViewTarget::DeleteMultiViewTarget()
+{
+	glDeleteFramebuffers(1, &mFramebuffer);
+	glDeleteTextures(1, &mColorTexture);
+	glDeleteTextures(1, &mDepthTexture);
+	glDeleteBuffers(1, &mViewBuffer);
+	mFramebuffer = mColorTexture = mDepthTexture = mViewBuffer = 0;
+}
+
+void MultiViewTarget::SetViews(const std::vector<glm::mat4>& views, const std::vector<glm::vec3>& cameraPositions)
+{
+	std::array<glm::mat4, maxViewCount> viewData{};
+	std::array<glm::vec4, maxViewCount> cameraPositionData{};
+	for (uint32_t view = 0; view < mInfo.viewCount && view < views.size() && view < cameraPositions.size(); view++)
+	{
+		viewData[view] = views[view];
+		cameraPositionData[view] = glm::vec4(cameraPositions[view], 1.0f);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, mViewBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(viewData), viewData.data());
+	glBufferSubData(GL_UNIFORM_BUFFER, sizeof(viewData), sizeof(cameraPositionData), cameraPositionData.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MultiViewTarget::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mColorTexture, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mDepthTexture, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, viewBufferBinding, mViewBuffer);
+	glViewport(0, 0, mInfo.width, mInfo.height);
+}
+void MultiViewTarget::BindLayer(uint32_t layer)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mColorTexture, 0, layer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mDepthTexture, 0, layer);
+	glViewport(0, 0, mInfo.width, mInfo.height);
+}
+
+void MultiViewTarget::ReadBack(GLenum format, GLenum type, uint32_t pixelSize, std::vector<uint8_t>& pixels)
+{
+	pixels.resize(static_cast<size_t>(mInfo.width) * mInfo.height * mInfo.viewCount * pixelSize);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mColorTexture);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, format, type, pixels.data());
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
+uint32_t MultiViewTarget::GetWidth()
+{
+	return mInfo.width;
+}
+uint32_t MultiViewTarget::GetHeight()
+{
+	return mInfo.height;
+}
+uint32_t MultiViewTarget::GetViewCount()
+{
+	return mInfo.viewCount;
+}
+uint32_t MultiViewTarget::GetColorTexture()
+{
+	return mColorTexture;
+}
\ No newline at end of file
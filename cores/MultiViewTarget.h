@@ -0,0 +1,48 @@
+#pragma once
+#include "Stdafx.h"
+
+struct MultiViewTargetInfo
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t viewCount = 1; // layers, at most MultiViewTarget::maxViewCount
+	GLenum colorInternalFormat = GL_RGBA8;
+};
+
+// renders several viewpoints of one scene into the layers of a 2D texture array.
+// MULTI_VIEW shaders draw every item once per view with instancing, pick the view from the MultiViewConstant
+// block by gl_InstanceID and write gl_Layer, so all views share one submission.
+// without a vertex shader that can write gl_Layer, the renderer draws one view per pass into BindLayer.
+class MultiViewTarget
+{
+public:
+	static constexpr uint32_t maxViewCount = 16; // MAX_MULTI_VIEW_COUNT of the shaders
+	static constexpr uint32_t viewBufferBinding = 1; // uniform block binding of MultiViewConstant
+
+	MultiViewTarget() = default;
+
+	void CreateMultiViewTarget(const MultiViewTargetInfo& info);
+	void DeleteMultiViewTarget();
+
+	void SetViews(const std::vector<glm::mat4>& views, const std::vector<glm::vec3>& cameraPositions);
+
+	// binds the framebuffer with every layer attached, the view buffer and sets the viewport.
+	void Bind();
+	// attaches a single layer, for drawing the views one pass at a time.
+	void BindLayer(uint32_t layer);
+
+	// every layer in one transfer, layer after layer with bottom-up rows.
+	void ReadBack(GLenum format, GLenum type, uint32_t pixelSize, std::vector<uint8_t>& pixels);
+
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+	uint32_t GetViewCount();
+	uint32_t GetColorTexture();
+private:
+	MultiViewTargetInfo mInfo;
+
+	uint32_t mFramebuffer = 0;
+	uint32_t mColorTexture = 0;
+	uint32_t mDepthTexture = 0;
+	uint32_t mViewBuffer = 0;
+};
\ No newline at end of file
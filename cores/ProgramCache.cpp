@@ -0,0 +1,266 @@
+#include "ProgramCache.h"
+
+// KHR_parallel_shader_compile is not part of the generated glad loader.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+const uint32_t ProgramCache::mCacheFileMagic = 0x4E494250; // "PBIN"
+
+static uint64_t HashFNV1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void ProgramCache::Initialize(const std::string& cacheDirectoryName, GLADloadproc loadProc)
+{
+	mCacheDirectoryName = cacheDirectoryName;
+
+	// the driver string is part of every key, so a driver update invalidates the whole cache.
+	const char* vendor = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
+	const char* rendererName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	mDriverString = std::string(vendor ? vendor : "") + "|" +
+		std::string(rendererName ? rendererName : "") + "|" + std::string(version ? version : "");
+
+	int binaryFormatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+	mIsBinaryCacheSupported = binaryFormatCount > 0;
+
+	if (mIsBinaryCacheSupported)
+	{
+		std::error_code errorCode;
+		std::filesystem::create_directories(mCacheDirectoryName, errorCode);
+		if (errorCode)
+		{
+			std::cout << "Failed to create program cache directory: " << mCacheDirectoryName << std::endl;
+			mIsBinaryCacheSupported = false;
+		}
+	}
+
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = nullptr;
+	if (IsExtensionSupported("GL_KHR_parallel_shader_compile"))
+		maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loadProc("glMaxShaderCompilerThreadsKHR"));
+	else if (IsExtensionSupported("GL_ARB_parallel_shader_compile"))
+		maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loadProc("glMaxShaderCompilerThreadsARB"));
+
+	if (maxShaderCompilerThreads != nullptr)
+	{
+		// 0xFFFFFFFF lets the driver pick the number of threads.
+		maxShaderCompilerThreads(0xFFFFFFFF);
+		mIsParallelCompileSupported = true;
+	}
+}
+
+void ProgramCache::RequestProgram(const std::string& programName, const std::vector<Shader*>& shaders)
+{
+	ProgramRequest request;
+	request.programName = programName;
+	request.shaders = shaders;
+	request.key = ComputeProgramKey(shaders);
+	mProgramRequests.push_back(std::move(request));
+}
+
+void ProgramCache::BuildPrograms(std::unordered_map<std::string, uint32_t>& programIDs)
+{
+	std::vector<ProgramRequest*> pendingRequests;
+
+	// cache hits skip the compiler entirely.
+	for (auto& request : mProgramRequests)
+	{
+		if (!LoadProgramBinary(request))
+			pendingRequests.push_back(&request);
+	}
+
+	// submit every compile and link before asking for any status,
+	// so a parallel compiler can work on all of them at once.
+	for (auto request : pendingRequests)
+	{
+		for (auto shader : request->shaders)
+			shader->CompileShader(true);
+	}
+	for (auto request : pendingRequests)
+		SubmitProgramLink(*request);
+
+	while (!pendingRequests.empty())
+	{
+		for (auto iter = pendingRequests.begin(); iter != pendingRequests.end(); )
+		{
+			if (IsProgramLinkCompleted(**iter))
+			{
+				FinishProgramLink(**iter);
+				iter = pendingRequests.erase(iter);
+			}
+			else
+				iter++;
+		}
+
+		if (!pendingRequests.empty())
+			std::this_thread::yield();
+	}
+
+	for (const auto& request : mProgramRequests)
+		programIDs.insert({ request.programName, request.programID });
+
+	mProgramRequests.clear();
+}
+
+uint32_t ProgramCache::BuildProgram(const std::string& programName, const std::vector<Shader*>& shaders)
+{
+	ProgramRequest request;
+	request.programName = programName;
+	request.shaders = shaders;
+	request.key = ComputeProgramKey(shaders);
+
+	if (!LoadProgramBinary(request))
+	{
+		for (auto shader : request.shaders)
+			shader->CompileShader(true);
+		SubmitProgramLink(request);
+		FinishProgramLink(request);
+	}
+
+	return request.programID;
+}
+
+uint64_t ProgramCache::ComputeProgramKey(const std::vector<Shader*>& shaders)
+{
+	// defines are injected into the source, so hashing the source covers them too.
+	uint64_t key = HashFNV1a(mDriverString.data(), mDriverString.size());
+	for (auto shader : shaders)
+	{
+		GLenum shaderType = shader->GetShaderType();
+		const std::string& shaderCode = shader->GetShaderCode();
+		key = HashFNV1a(&shaderType, sizeof(shaderType), key);
+		key = HashFNV1a(shaderCode.data(), shaderCode.size(), key);
+	}
+	return key;
+}
+
+std::string ProgramCache::GetCacheFileName(const ProgramRequest& request)
+{
+	// the renderers share one cache directory, the key keeps their programs and permutations apart.
+	std::stringstream fileName;
+	fileName << mCacheDirectoryName << request.programName << "_" << std::hex << request.key << ".bin";
+	return fileName.str();
+}
+
+bool ProgramCache::LoadProgramBinary(ProgramRequest& request)
+{
+	if (!mIsBinaryCacheSupported)
+		return false;
+
+	std::ifstream cacheFile(GetCacheFileName(request), std::ios::binary);
+	if (!cacheFile.is_open())
+		return false;
+
+	uint32_t magic = 0;
+	uint64_t key = 0;
+	GLenum binaryFormat = 0;
+	int32_t binaryLength = 0;
+	cacheFile.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	cacheFile.read(reinterpret_cast<char*>(&key), sizeof(key));
+	cacheFile.read(reinterpret_cast<char*>(&binaryFormat), sizeof(binaryFormat));
+	cacheFile.read(reinterpret_cast<char*>(&binaryLength), sizeof(binaryLength));
+	if (!cacheFile || magic != mCacheFileMagic || key != request.key || binaryLength <= 0)
+		return false;
+
+	std::vector<char> binary(binaryLength);
+	cacheFile.read(binary.data(), binaryLength);
+	if (!cacheFile)
+		return false;
+
+	uint32_t programID = glCreateProgram();
+	glProgramBinary(programID, binaryFormat, binary.data(), binaryLength);
+
+	// the driver may still reject a binary with a matching key, then recompile from source.
+	int success = 0;
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		std::cout << "Program binary rejected by the driver, recompiling: " << request.programName << std::endl;
+		glDeleteProgram(programID);
+		return false;
+	}
+
+	request.programID = programID;
+	request.isBinaryLoaded = true;
+	return true;
+}
+
+void ProgramCache::SaveProgramBinary(const ProgramRequest& request)
+{
+	if (!mIsBinaryCacheSupported)
+		return;
+
+	int binaryLength = 0;
+	glGetProgramiv(request.programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+		return;
+
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(request.programID, binaryLength, nullptr, &binaryFormat, binary.data());
+
+	std::ofstream cacheFile(GetCacheFileName(request), std::ios::binary | std::ios::trunc);
+	if (!cacheFile.is_open())
+	{
+		std::cout << "Failed to write program binary: " << request.programName << std::endl;
+		return;
+	}
+
+	int32_t length = binaryLength;
+	cacheFile.write(reinterpret_cast<const char*>(&mCacheFileMagic), sizeof(mCacheFileMagic));
+	cacheFile.write(reinterpret_cast<const char*>(&request.key), sizeof(request.key));
+	cacheFile.write(reinterpret_cast<const char*>(&binaryFormat), sizeof(binaryFormat));
+	cacheFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	cacheFile.write(binary.data(), binaryLength);
+}
+
+void ProgramCache::SubmitProgramLink(ProgramRequest& request)
+{
+	request.programID = glCreateProgram();
+	if (mIsBinaryCacheSupported)
+		glProgramParameteri(request.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	for (auto shader : request.shaders)
+		glAttachShader(request.programID, shader->GetShaderID());
+	glLinkProgram(request.programID);
+}
+
+bool ProgramCache::IsProgramLinkCompleted(const ProgramRequest& request)
+{
+	if (!mIsParallelCompileSupported)
+		return true;
+
+	int isCompleted = 0;
+	glGetProgramiv(request.programID, GL_COMPLETION_STATUS_KHR, &isCompleted);
+	return isCompleted != 0;
+}
+
+void ProgramCache::FinishProgramLink(ProgramRequest& request)
+{
+	int success = 0;
+	glGetProgramiv(request.programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		for (auto shader : request.shaders)
+			shader->CheckShaderCompileErrors();
+	}
+	CheckCompileErrors(request.programID, "PROGRAM");
+
+	for (auto shader : request.shaders)
+		glDetachShader(request.programID, shader->GetShaderID());
+
+	if (success)
+		SaveProgramBinary(request);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "Shader.h"
+#include "Stdafx.h"
+#include "Utility.h"
+
+struct ProgramRequest
+{
+	std::string programName;
+	std::vector<Shader*> shaders;
+	uint64_t key = 0;
+	uint32_t programID = 0;
+	bool isBinaryLoaded = false;
+};
+
+class ProgramCache
+{
+public:
+	ProgramCache() = default;
+
+	// must be called after the GL context is current.
+	void Initialize(const std::string& cacheDirectoryName, GLADloadproc loadProc);
+
+	// programs are only queued here, BuildPrograms compiles them all at once.
+	void RequestProgram(const std::string& programName, const std::vector<Shader*>& shaders);
+	void BuildPrograms(std::unordered_map<std::string, uint32_t>& programIDs);
+
+	uint32_t BuildProgram(const std::string& programName, const std::vector<Shader*>& shaders);
+private:
+	uint64_t ComputeProgramKey(const std::vector<Shader*>& shaders);
+	std::string GetCacheFileName(const ProgramRequest& request);
+
+	bool LoadProgramBinary(ProgramRequest& request);
+	void SaveProgramBinary(const ProgramRequest& request);
+
+	void SubmitProgramLink(ProgramRequest& request);
+	bool IsProgramLinkCompleted(const ProgramRequest& request);
+	void FinishProgramLink(ProgramRequest& request);
+private:
+	std::string mCacheDirectoryName;
+	std::string mDriverString;
+
+	bool mIsBinaryCacheSupported = false;
+	bool mIsParallelCompileSupported = false;
+
+	std::vector<ProgramRequest> mProgramRequests;
+
+	static const uint32_t mCacheFileMagic;
+};
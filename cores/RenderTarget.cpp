@@ -0,0 +1,116 @@
+#include "RenderTarget.h"
+
+void RenderTarget::CreateRenderTarget(const RenderTargetInfo& info)
+{
+	mInfo = info;
+	mInfo.sampleCount = std::max(info.sampleCount, 1u);
+
+	TextureInfo resolveTextureInfo;
+	resolveTextureInfo.wrapSType = GL_CLAMP_TO_EDGE;
+	resolveTextureInfo.wrapTType = GL_CLAMP_TO_EDGE;
+	resolveTextureInfo.minFilterType = GL_LINEAR;
+	resolveTextureInfo.magFilterType = GL_LINEAR;
+	resolveTextureInfo.isMipmap = false;
+	resolveTextureInfo.nullData = true;
+	resolveTextureInfo.width = mInfo.width;
+	resolveTextureInfo.height = mInfo.height;
+	resolveTextureInfo.textureInternalFormat = mInfo.colorInternalFormat;
+	resolveTextureInfo.textureFormat = GL_RGBA;
+	mResolveTexture.CreateHDRTexture2D(resolveTextureInfo);
+
+	mResolveFramebuffer.CreateFramebuffer(mInfo.width, mInfo.height, 0, false, false);
+	glBindFramebuffer(GL_FRAMEBUFFER, mResolveFramebuffer.GetFramebuffer());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mResolveTexture.GetTexture(), 0);
+	if (mInfo.sampleCount == 1 && mInfo.isDepthAttachment)
+	{
+		mResolveDepthBuffer.CreateRenderbuffer(mInfo.width, mInfo.height, mInfo.isStencilAttachment);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, mInfo.isStencilAttachment ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, mResolveDepthBuffer.GetRenderbuffer());
+	}
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::RENDER_TARGET:: Resolve framebuffer is not complete!" << std::endl;
+
+	if (mInfo.sampleCount > 1)
+	{
+		mMultisampleFramebuffer.CreateFramebuffer(mInfo.width, mInfo.height, 0, false, false);
+		glBindFramebuffer(GL_FRAMEBUFFER, mMultisampleFramebuffer.GetFramebuffer());
+
+		mMultisampleColorBuffer.CreateMultisampleRenderbuffer(mInfo.width, mInfo.height, mInfo.sampleCount, mInfo.colorInternalFormat);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mMultisampleColorBuffer.GetRenderbuffer());
+		if (mInfo.isDepthAttachment)
+		{
+			mMultisampleDepthBuffer.CreateMultisampleRenderbuffer(mInfo.width, mInfo.height, mInfo.sampleCount,
+				mInfo.isStencilAttachment ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, mInfo.isStencilAttachment ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+				GL_RENDERBUFFER, mMultisampleDepthBuffer.GetRenderbuffer());
+		}
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::RENDER_TARGET:: Multisample framebuffer is not complete!" << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+void RenderTarget::DeleteRenderTarget()
+{
+	if (mInfo.sampleCount > 1)
+	{
+		mMultisampleColorBuffer.DeleteRenderbuffer();
+		if (mInfo.isDepthAttachment)
+			mMultisampleDepthBuffer.DeleteRenderbuffer();
+		mMultisampleFramebuffer.DeleteFramebuffer();
+	}
+	else if (mInfo.isDepthAttachment)
+		mResolveDepthBuffer.DeleteRenderbuffer();
+
+	mResolveTexture.DeleteTexture();
+	mResolveFramebuffer.DeleteFramebuffer();
+}
+
+void RenderTarget::Bind()
+{
+	if (mInfo.sampleCount > 1)
+		glBindFramebuffer(GL_FRAMEBUFFER, mMultisampleFramebuffer.GetFramebuffer());
+	else
+		glBindFramebuffer(GL_FRAMEBUFFER, mResolveFramebuffer.GetFramebuffer());
+	glViewport(0, 0, mInfo.width, mInfo.height);
+}
+void RenderTarget::Resolve()
+{
+	if (mInfo.sampleCount > 1)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, mMultisampleFramebuffer.GetFramebuffer());
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mResolveFramebuffer.GetFramebuffer());
+		glBlitFramebuffer(0, 0, mInfo.width, mInfo.height, 0, 0, mInfo.width, mInfo.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mResolveFramebuffer.GetFramebuffer());
+}
+void RenderTarget::BlitToFramebuffer(uint32_t framebuffer, uint32_t width, uint32_t height)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mResolveFramebuffer.GetFramebuffer());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	GLenum filter = (width == mInfo.width && height == mInfo.height) ? GL_NEAREST : GL_LINEAR;
+	glBlitFramebuffer(0, 0, mInfo.width, mInfo.height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, filter);
+}
+
+uint32_t RenderTarget::GetWidth()
+{
+	return mInfo.width;
+}
+uint32_t RenderTarget::GetHeight()
+{
+	return mInfo.height;
+}
+uint32_t RenderTarget::GetSampleCount()
+{
+	return mInfo.sampleCount;
+}
+uint32_t RenderTarget::GetResolveFramebuffer()
+{
+	return mResolveFramebuffer.GetFramebuffer();
+}
+Texture& RenderTarget::GetResolveTexture()
+{
+	return mResolveTexture;
+}
\ No newline at end of file
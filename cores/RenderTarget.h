@@ -0,0 +1,49 @@
+#pragma once
+#include "Framebuffer.h"
+#include "Renderbuffer.h"
+#include "Stdafx.h"
+#include "Texture.h"
+
+struct RenderTargetInfo
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t sampleCount = 1; // 1 renders straight into the resolve texture
+	GLenum colorInternalFormat = GL_RGBA8;
+	bool isDepthAttachment = true;
+	bool isStencilAttachment = false; // 8 stencil bits with the depth, needs isDepthAttachment
+};
+
+// offscreen color target whose resolution and sample count are independent of the window.
+// multisampled targets draw into renderbuffers and are resolved into a single-sampled texture by Resolve.
+class RenderTarget
+{
+public:
+	RenderTarget() = default;
+
+	void CreateRenderTarget(const RenderTargetInfo& info);
+	void DeleteRenderTarget();
+
+	// binds the draw framebuffer and sets the viewport to the target size.
+	void Bind();
+	// resolves the samples and leaves the resolved framebuffer bound for reading, e.g. for SaveScreenshotToPNG.
+	void Resolve();
+	// copies the resolved image into another framebuffer, scaled to its size.
+	void BlitToFramebuffer(uint32_t framebuffer, uint32_t width, uint32_t height);
+
+	uint32_t GetWidth();
+	uint32_t GetHeight();
+	uint32_t GetSampleCount();
+	uint32_t GetResolveFramebuffer();
+	Texture& GetResolveTexture();
+private:
+	RenderTargetInfo mInfo;
+
+	Framebuffer mMultisampleFramebuffer;
+	Renderbuffer mMultisampleColorBuffer;
+	Renderbuffer mMultisampleDepthBuffer;
+
+	Framebuffer mResolveFramebuffer;
+	Texture mResolveTexture;
+	Renderbuffer mResolveDepthBuffer; // only when the target is not multisampled
+};
\ No newline at end of file
@@ -23,6 +23,16 @@ void Renderbuffer::CreateRenderbuffer(uint32_t width, uint32_t height, bool isSt
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
 }
 
+void Renderbuffer::CreateMultisampleRenderbuffer(uint32_t width, uint32_t height, uint32_t sampleCount, GLenum internalFormat)
+{
+	glGenRenderbuffers(1, &mRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mRenderbuffer);
+
+	// color or depth, the format decides which attachment it can be.
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, sampleCount, internalFormat, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
 void Renderbuffer::ResizeRenderbuffer(uint32_t width, uint32_t height)
 {
 	glBindRenderbuffer(GL_RENDERBUFFER, mRenderbuffer);
@@ -11,6 +11,7 @@ public:
 	void DeleteRenderbuffer();
 
 	void CreateRenderbuffer(uint32_t width, uint32_t height, bool isStencilAttachment = false);
+	void CreateMultisampleRenderbuffer(uint32_t width, uint32_t height, uint32_t sampleCount, GLenum internalFormat);
 
 	void ResizeRenderbuffer(uint32_t width, uint32_t height);
 private:
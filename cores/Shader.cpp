@@ -9,8 +9,16 @@ uint32_t Shader::GetShaderID()
 {
 	return mShaderID;
 }
+GLenum Shader::GetShaderType()
+{
+	return mShaderType;
+}
+const std::string& Shader::GetShaderCode()
+{
+	return mShaderCode;
+}
 
-void Shader::CompileShader(const std::string& fileName, GLenum shaderType)
+void Shader::LoadShaderCode(const std::string& fileName, GLenum shaderType, const std::vector<std::string>& defines)
 {
 	std::string shaderCode;
 
@@ -35,12 +43,58 @@ void Shader::CompileShader(const std::string& fileName, GLenum shaderType)
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
 	}
 
-	const char* rawShaderCode = shaderCode.c_str();
-	
-	mShaderID = glCreateShader(shaderType);
+	SetShaderCode(shaderCode, shaderType, defines);
+}
+
+void Shader::SetShaderCode(const std::string& shaderCode, GLenum shaderType, const std::vector<std::string>& defines)
+{
+	mShaderCode = shaderCode;
+	mShaderType = shaderType;
+
+	if (defines.empty())
+		return;
+
+	// #version must stay the first statement, so defines go right after it.
+	std::string defineCode;
+	for (const auto& define : defines)
+		defineCode += "#define " + define + "\n";
+
+	size_t insertPosition = 0;
+	size_t versionPosition = mShaderCode.find("#version");
+	if (versionPosition != std::string::npos)
+	{
+		size_t lineEnd = mShaderCode.find('\n', versionPosition);
+		insertPosition = (lineEnd == std::string::npos) ? mShaderCode.size() : lineEnd + 1;
+	}
+	mShaderCode.insert(insertPosition, defineCode);
+}
+
+void Shader::CompileShader(bool isCheckDeferred)
+{
+	// shaders shared by several programs are compiled only once.
+	if (mShaderID != 0)
+		return;
+
+	const char* rawShaderCode = mShaderCode.c_str();
+
+	mShaderID = glCreateShader(mShaderType);
 	glShaderSource(mShaderID, 1, &rawShaderCode, nullptr);
 	glCompileShader(mShaderID);
-	switch (shaderType)
+
+	// querying the status here would block parallel compilation.
+	if (!isCheckDeferred)
+		CheckShaderCompileErrors();
+}
+
+void Shader::CompileShader(const std::string& fileName, GLenum shaderType)
+{
+	LoadShaderCode(fileName, shaderType);
+	CompileShader();
+}
+
+void Shader::CheckShaderCompileErrors()
+{
+	switch (mShaderType)
 	{
 	case GL_VERTEX_SHADER:
 		CheckCompileErrors(mShaderID, "VERTEX");
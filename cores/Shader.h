@@ -9,8 +9,17 @@ public:
 	~Shader();
 
 	uint32_t GetShaderID();
+	GLenum GetShaderType();
+	const std::string& GetShaderCode();
 
+	// read the source and inject defines after the #version line, compile later.
+	void LoadShaderCode(const std::string& fileName, GLenum shaderType, const std::vector<std::string>& defines = {});
+	void SetShaderCode(const std::string& shaderCode, GLenum shaderType, const std::vector<std::string>& defines = {});
+	void CompileShader(bool isCheckDeferred = false);
 	void CompileShader(const std::string& fileName, GLenum shaderType);
+	void CheckShaderCompileErrors();
 private:
 	uint32_t mShaderID = 0;
+	GLenum mShaderType = 0;
+	std::string mShaderCode;
 };
\ No newline at end of file
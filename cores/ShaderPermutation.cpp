@@ -0,0 +1,104 @@
+#include "ShaderPermutation.h"
+
+static const std::array<std::string, static_cast<size_t>(ShaderFeature::Count)> featureDefineNames =
+{
+	"USE_TEXTURE",
+	"USE_NORMAL_MAP",
+	"USE_IMAGE_BASED_LIGHTING",
+	"USE_SHADOW",
+	"USE_CLUSTERED_LIGHTING"
+};
+
+uint32_t GetShaderFeatureBit(ShaderFeature feature)
+{
+	return 1u << static_cast<uint32_t>(feature);
+}
+
+uint32_t GetShaderFeatureMask(const Menu& menu)
+{
+	uint32_t featureMask = 0;
+	if (menu.isUsingTexture)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::Texture);
+	if (menu.isUsingNormalMap)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::NormalMap);
+	if (menu.enableImageBasedLighting)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::ImageBasedLighting);
+	if (menu.enableShadow)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::Shadow);
+	if (menu.enableClusteredLighting)
+		featureMask |= GetShaderFeatureBit(ShaderFeature::ClusteredLighting);
+	return featureMask;
+}
+
+void ShaderPermutation::Initialize(ProgramCache* programCache, const std::string& programName,
+	const std::string& vertexShaderFileName, const std::string& fragmentShaderFileName,
+	const std::vector<std::string>& defines)
+{
+	mProgramCache = programCache;
+	mProgramName = programName;
+	mDefines = defines;
+
+	// keep the raw sources so each variant only costs a compile, not a file read.
+	Shader vertexShader;
+	Shader fragmentShader;
+	vertexShader.LoadShaderCode(vertexShaderFileName, GL_VERTEX_SHADER);
+	fragmentShader.LoadShaderCode(fragmentShaderFileName, GL_FRAGMENT_SHADER);
+	mVertexShaderCode = vertexShader.GetShaderCode();
+	mFragmentShaderCode = fragmentShader.GetShaderCode();
+
+	mSupportedFeatureMask = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(ShaderFeature::Count); i++)
+	{
+		if (IsFeatureTested(featureDefineNames[i]))
+			mSupportedFeatureMask |= GetShaderFeatureBit(static_cast<ShaderFeature>(i));
+	}
+}
+
+uint32_t ShaderPermutation::GetProgram(uint32_t featureMask)
+{
+	featureMask &= mSupportedFeatureMask;
+
+	auto iter = mProgramIDs.find(featureMask);
+	if (iter != mProgramIDs.end())
+		return iter->second;
+
+	std::vector<std::string> defines = GetFeatureDefines(featureMask);
+
+	Shader vertexShader;
+	Shader fragmentShader;
+	vertexShader.SetShaderCode(mVertexShaderCode, GL_VERTEX_SHADER, defines);
+	fragmentShader.SetShaderCode(mFragmentShaderCode, GL_FRAGMENT_SHADER, defines);
+
+	std::vector<Shader*> shaders = { &vertexShader, &fragmentShader };
+	uint32_t programID = mProgramCache->BuildProgram(mProgramName + "_" + std::to_string(featureMask), shaders);
+
+	mProgramIDs.insert({ featureMask, programID });
+	return programID;
+}
+
+std::vector<std::string> ShaderPermutation::GetFeatureDefines(uint32_t featureMask)
+{
+	std::vector<std::string> defines = mDefines;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(ShaderFeature::Count); i++)
+	{
+		if (featureMask & GetShaderFeatureBit(static_cast<ShaderFeature>(i)))
+			defines.push_back(featureDefineNames[i]);
+	}
+	return defines;
+}
+bool ShaderPermutation::IsFeatureTested(const std::string& defineName)
+{
+	// whole identifiers only, USE_SHADOW must not match USE_SHADOW_ARRAY.
+	auto isIdentifierCharacter = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	for (const std::string* code : { &mVertexShaderCode, &mFragmentShaderCode })
+	{
+		for (size_t position = code->find(defineName); position != std::string::npos; position = code->find(defineName, position + 1))
+		{
+			size_t end = position + defineName.size();
+			if ((position == 0 || !isIdentifierCharacter((*code)[position - 1])) &&
+				(end == code->size() || !isIdentifierCharacter((*code)[end])))
+				return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
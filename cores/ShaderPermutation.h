@@ -0,0 +1,45 @@
+#pragma once
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "Stdafx.h"
+#include "Utility.h"
+
+enum class ShaderFeature : uint32_t
+{
+	Texture = 0,
+	NormalMap,
+	ImageBasedLighting,
+	Shadow,
+	ClusteredLighting,
+	Count
+};
+
+uint32_t GetShaderFeatureBit(ShaderFeature feature);
+uint32_t GetShaderFeatureMask(const Menu& menu);
+
+class ShaderPermutation
+{
+public:
+	ShaderPermutation() = default;
+
+	void Initialize(ProgramCache* programCache, const std::string& programName,
+		const std::string& vertexShaderFileName, const std::string& fragmentShaderFileName,
+		const std::vector<std::string>& defines = {});
+
+	// variants are compiled the first time their feature mask is requested.
+	// features the sources never test are dropped from the mask, so they share one variant.
+	uint32_t GetProgram(uint32_t featureMask);
+private:
+	std::vector<std::string> GetFeatureDefines(uint32_t featureMask);
+	bool IsFeatureTested(const std::string& defineName);
+private:
+	ProgramCache* mProgramCache = nullptr;
+
+	std::string mProgramName;
+	std::string mVertexShaderCode;
+	std::string mFragmentShaderCode;
+	std::vector<std::string> mDefines;
+	uint32_t mSupportedFeatureMask = 0;
+
+	std::unordered_map<uint32_t, uint32_t> mProgramIDs; // feature mask -> program
+};
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "SweepScheduler.h"
+
+bool SweepScheduler::LoadManifest(const std::string& fileName, SweepManifest& manifest)
+{
+	std::ifstream file(fileName);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open sweep manifest: " << fileName << std::endl;
+		return false;
+	}
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		size_t separator = line.find('=');
+		if (separator == std::string::npos)
+		{
+			std::cout << "ERROR::SWEEP_MANIFEST:: Line " << lineNumber << " is not key=value: " << line << std::endl;
+			return false;
+		}
+
+		std::string key = line.substr(0, separator);
+		std::string value = line.substr(separator + 1);
+
+		// std::stof throws on text that is not a number or does not fit a float.
+		auto parseFloat = [&](float& number)
+		{
+			try
+			{
+				number = std::stof(value);
+				return true;
+			}
+			catch (const std::logic_error&)
+			{
+				std::cout << "ERROR::SWEEP_MANIFEST:: Line " << lineNumber << " has no valid number: " << line << std::endl;
+				return false;
+			}
+		};
+
+		if (key == "dataset")
+			manifest.datasetDirectoryName = value;
+		else if (key == "model")
+			manifest.modelNames.push_back(value);
+		else if (key == "hdr")
+			manifest.hdrNames.push_back(value);
+		else if (key == "degreeDelta")
+		{
+			if (!parseFloat(manifest.degreeDelta))
+				return false;
+		}
+		else if (key == "thetaEnd")
+		{
+			if (!parseFloat(manifest.thetaEnd))
+				return false;
+		}
+		else if (key == "phiEnd")
+		{
+			if (!parseFloat(manifest.phiEnd))
+				return false;
+		}
+		else if (key == "format")
+			manifest.outputFormat = value;
+		else
+			std::cout << "Unknown sweep manifest key ignored: " << key << std::endl;
+	}
+
+	return IsManifestAngleValid(manifest);
+}
+
+bool SweepScheduler::BuildWorkUnits(const SweepManifest& manifest, uint32_t shardIndex, uint32_t shardCount, bool isSkippingCompleted)
+{
+	mWorkUnits.clear();
+	mNextWorkUnit = 0;
+	mSkippedWorkUnitCount = 0;
+	mHasPreviousView = false;
+
+	if (!IsManifestAngleValid(manifest))
+		return false;
+	if (shardIndex >= shardCount)
+	{
+		std::cout << "ERROR::SWEEP_SCHEDULER:: Shard " << shardIndex << "/" << shardCount << " does not exist!" << std::endl;
+		return false;
+	}
+
+	// views are dealt round robin so every shard gets a similar share of every model.
+	uint32_t viewIndex = 0;
+	for (uint32_t modelIndex = 0; modelIndex < manifest.modelNames.size(); modelIndex++)
+	{
+		for (float theta = 0.0f; theta < manifest.thetaEnd; theta += manifest.degreeDelta)
+		{
+			for (float phi = 0.0f; phi < manifest.phiEnd; phi += manifest.degreeDelta)
+			{
+				if (viewIndex++ % shardCount != shardIndex)
+					continue;
+
+				for (uint32_t hdrIndex = 0; hdrIndex < manifest.hdrNames.size(); hdrIndex++)
+				{
+					SweepWorkUnit workUnit;
+					workUnit.modelIndex = modelIndex;
+					workUnit.theta = theta;
+					workUnit.phi = phi;
+					workUnit.hdrIndex = hdrIndex;
+					workUnit.outputFileName = GetOutputFileName(manifest, modelIndex, theta, phi, hdrIndex);
+
+					// outputs are renamed into place once written, so any non-empty file is a finished unit.
+					std::error_code error;
+					if (isSkippingCompleted && std::filesystem::file_size(workUnit.outputFileName, error) > 0 && !error)
+					{
+						mSkippedWorkUnitCount++;
+						continue;
+					}
+
+					mWorkUnits.push_back(std::move(workUnit));
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool SweepScheduler::GetNextWorkUnit(SweepWorkUnit& workUnit)
+{
+	if (mNextWorkUnit >= mWorkUnits.size())
+		return false;
+
+	workUnit = mWorkUnits[mNextWorkUnit++];
+	return true;
+}
+bool SweepScheduler::IsNewView(const SweepWorkUnit& workUnit)
+{
+	bool isNewView = !mHasPreviousView || workUnit.modelIndex != mPreviousModelIndex ||
+		workUnit.theta != mPreviousTheta || workUnit.phi != mPreviousPhi;
+
+	mHasPreviousView = true;
+	mPreviousModelIndex = workUnit.modelIndex;
+	mPreviousTheta = workUnit.theta;
+	mPreviousPhi = workUnit.phi;
+	return isNewView;
+}
+
+uint32_t SweepScheduler::GetWorkUnitCount()
+{
+	return static_cast<uint32_t>(mWorkUnits.size());
+}
+uint32_t SweepScheduler::GetCompletedWorkUnitCount()
+{
+	return mNextWorkUnit;
+}
+uint32_t SweepScheduler::GetSkippedWorkUnitCount()
+{
+	return mSkippedWorkUnitCount;
+}
+
+std::string SweepScheduler::GetOutputFileName(const SweepManifest& manifest, uint32_t modelIndex, float theta, float phi, uint32_t hdrIndex)
+{
+	return manifest.datasetDirectoryName + "\\" + manifest.modelNames[modelIndex] + "\\HDR" + std::to_string(hdrIndex + 1) + "_IBL_IBR_"
+		+ std::to_string(static_cast<uint32_t>(theta)) + "_" + std::to_string(static_cast<uint32_t>(phi)) + "." + manifest.outputFormat;
+}
+bool SweepScheduler::IsManifestAngleValid(const SweepManifest& manifest)
+{
+	// the G-buffer inputs and the outputs are named by whole degrees, a fractional delta would give several views one name.
+	// a whole delta of at least 1 also keeps the angle loops advancing.
+	if (!(manifest.degreeDelta >= 1.0f) || manifest.degreeDelta != std::floor(manifest.degreeDelta))
+	{
+		std::cout << "ERROR::SWEEP_MANIFEST:: degreeDelta must be a whole number of degrees!" << std::endl;
+		return false;
+	}
+	if (!(manifest.thetaEnd >= 0.0f && manifest.thetaEnd <= 360.0f) || !(manifest.phiEnd >= 0.0f && manifest.phiEnd <= 360.0f))
+	{
+		std::cout << "ERROR::SWEEP_MANIFEST:: thetaEnd and phiEnd must be within [0, 360]!" << std::endl;
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
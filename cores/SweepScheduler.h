@@ -0,0 +1,66 @@
+#pragma once
+#include "Stdafx.h"
+
+// what the dataset sweep renders, read from a manifest of key=value lines:
+//   dataset=DIRECTORY   model=NAME (repeatable)   hdr=NAME (repeatable)
+//   degreeDelta=45   thetaEnd=225   phiEnd=360   format=png
+// lines starting with # are comments.
+struct SweepManifest
+{
+	std::string datasetDirectoryName;
+	std::vector<std::string> modelNames;
+	std::vector<std::string> hdrNames;
+
+	float degreeDelta = 45.0f;
+	float thetaEnd = 225.0f; // exclusive
+	float phiEnd = 360.0f; // exclusive
+
+	std::string outputFormat = "png"; // extension of the output images
+};
+
+// one output image.
+struct SweepWorkUnit
+{
+	uint32_t modelIndex = 0;
+	float theta = 0.0f;
+	float phi = 0.0f;
+	uint32_t hdrIndex = 0;
+
+	std::string outputFileName;
+};
+
+// enumerates (model, theta, phi, hdr) work units and hands out the ones of one shard.
+// a shard owns whole views, so all hdrs of a view share one G-buffer load, and units are ordered
+// model, theta, phi, hdr so consecutive units reuse the loaded G-buffer and the precomputed lights.
+// units whose output already exists are skipped, so a crashed sweep resumes where it stopped.
+class SweepScheduler
+{
+public:
+	SweepScheduler() = default;
+
+	bool LoadManifest(const std::string& fileName, SweepManifest& manifest);
+
+	// false when the manifest angles or the shard are invalid, shardIndex must be below shardCount.
+	bool BuildWorkUnits(const SweepManifest& manifest, uint32_t shardIndex, uint32_t shardCount, bool isSkippingCompleted = true);
+
+	bool GetNextWorkUnit(SweepWorkUnit& workUnit);
+	// true when the unit needs other G-buffers than the unit before it.
+	bool IsNewView(const SweepWorkUnit& workUnit);
+
+	uint32_t GetWorkUnitCount();
+	uint32_t GetCompletedWorkUnitCount(); // handed out so far
+	uint32_t GetSkippedWorkUnitCount(); // outputs that existed when the units were built
+
+	static std::string GetOutputFileName(const SweepManifest& manifest, uint32_t modelIndex, float theta, float phi, uint32_t hdrIndex);
+private:
+	static bool IsManifestAngleValid(const SweepManifest& manifest);
+private:
+	std::vector<SweepWorkUnit> mWorkUnits;
+	uint32_t mNextWorkUnit = 0;
+	uint32_t mSkippedWorkUnitCount = 0;
+
+	bool mHasPreviousView = false;
+	uint32_t mPreviousModelIndex = 0;
+	float mPreviousTheta = 0.0f;
+	float mPreviousPhi = 0.0f;
+};
\ No newline at end of file
@@ -28,6 +28,10 @@ uint32_t Texture::GetTexture()
 {
 	return mTexture;
 }
+void Texture::SetTexture(uint32_t texture)
+{
+	mTexture = texture;
+}
 
 void Texture::CreateTexture2D(GLenum wrapSType, GLenum wrapTType, 
 	GLenum minFilterType, GLenum magFilterType, bool isMipmap,
@@ -459,6 +463,54 @@ void Texture::CreateHDRTextureCube(const TextureInfo& textureSetup)
 	}
 }
 
+void Texture::CreateHDRTextureCubeArray(const TextureInfo& textureSetup, uint32_t cubeCount)
+{
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, mTexture);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, textureSetup.minFilterType);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, textureSetup.magFilterType);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, textureSetup.wrapSType);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, textureSetup.wrapTType);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, textureSetup.wrapRType);
+
+	// Set border color if enabled.
+	if (textureSetup.isBorderColor)
+		glTexParameterfv(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_BORDER_COLOR, textureSetup.borderColor.data());
+
+	// all faces of all cubes live in one allocation, so a layered framebuffer can address them with gl_Layer.
+	glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, textureSetup.textureInternalFormat,
+		textureSetup.width, textureSetup.height, 6 * cubeCount,
+		0, textureSetup.textureFormat, GL_FLOAT, nullptr);
+	if (textureSetup.isMipmap)
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP_ARRAY);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+}
+
+void Texture::CreateHDRTexture2DArray(const TextureInfo& textureSetup, uint32_t layerCount)
+{
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, textureSetup.minFilterType);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, textureSetup.magFilterType);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, textureSetup.wrapSType);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, textureSetup.wrapTType);
+
+	// Set border color if enabled.
+	if (textureSetup.isBorderColor)
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, textureSetup.borderColor.data());
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, textureSetup.textureInternalFormat,
+		textureSetup.width, textureSetup.height, layerCount,
+		0, textureSetup.textureFormat, GL_FLOAT, nullptr);
+	if (textureSetup.isMipmap)
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
 void Texture::DeleteTexture()
 {
 	glDeleteTextures(1, &mTexture);
@@ -44,6 +44,7 @@ public:
 	void SetCubeMapFileName(const std::vector<std::string>& cubeMapFileNames);
 	std::string GetTextureFileName();
 	uint32_t GetTexture();
+	void SetTexture(uint32_t texture); // adopts a texture created elsewhere, e.g. by the TextureStreamer
 
 	void CreateTexture2D(GLenum wrapSType, GLenum wrapTType, 
 		GLenum minFilterType, GLenum magFilterType, bool isMipmap = false,
@@ -62,6 +63,8 @@ public:
 	void CreateHDRTexture2D(const TextureInfo& textureSetup);
 	void CreateTextureCube(const TextureInfo& textureSetup);
 	void CreateHDRTextureCube(const TextureInfo& textureSetup);
+	void CreateHDRTextureCubeArray(const TextureInfo& textureSetup, uint32_t cubeCount); // layer = cube index * 6 + face
+	void CreateHDRTexture2DArray(const TextureInfo& textureSetup, uint32_t layerCount);
 
 	void DeleteTexture();
 private:
@@ -0,0 +1,545 @@
+#include "CpuTracer.h"
+#include "TextureStreamer.h"
+
+namespace
+{
+	GLenum GetInternalFormat(uint32_t channelCount)
+	{
+		switch (channelCount)
+		{
+		case 1: return GL_R8;
+		case 2: return GL_RG8;
+		case 3: return GL_RGB8;
+		default: return GL_RGBA8;
+		}
+	}
+	GLenum GetFormat(uint32_t channelCount)
+	{
+		switch (channelCount)
+		{
+		case 1: return GL_RED;
+		case 2: return GL_RG;
+		case 3: return GL_RGB;
+		default: return GL_RGBA;
+		}
+	}
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	DeleteTextureStreamer();
+}
+
+void TextureStreamer::Initialize(const TextureStreamerInfo& info)
+{
+	DeleteTextureStreamer();
+
+	mInfo = info;
+	mInfo.uploadBufferCount = std::max(mInfo.uploadBufferCount, 1u);
+	if (mInfo.decodeThreadCount == 0)
+		mInfo.decodeThreadCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+
+	mUploadBuffers.resize(mInfo.uploadBufferCount);
+	for (auto& uploadBuffer : mUploadBuffers)
+	{
+		glGenBuffers(1, &uploadBuffer.buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, mInfo.uploadBufferSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	mNextUploadBuffer = 0;
+
+	mIsStopping = false;
+	for (uint32_t i = 0; i < mInfo.decodeThreadCount; i++)
+		mThreads.emplace_back(&TextureStreamer::WorkerLoop, this);
+	mIsInitialized = true;
+}
+void TextureStreamer::DeleteTextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+		mDecodeJobs.clear();
+	}
+	mQueueCondition.notify_all();
+
+	for (auto& thread : mThreads)
+		thread.join();
+	mThreads.clear();
+	mDecodedMips.clear();
+	mUploads.clear();
+
+	if (mIsInitialized)
+	{
+		for (auto& uploadBuffer : mUploadBuffers)
+		{
+			if (uploadBuffer.fence != nullptr)
+				glDeleteSync(uploadBuffer.fence);
+			glDeleteBuffers(1, &uploadBuffer.buffer);
+		}
+	}
+	mUploadBuffers.clear();
+
+	mTextures.clear();
+	mResidentBytes = 0;
+	mPendingBytes = 0;
+	mInFlightJobCount = 0;
+	mIsInitialized = false;
+}
+
+Texture TextureStreamer::CreateStreamedTexture(const std::string& fileName, GLenum wrapSType, GLenum wrapTType,
+	const glm::u8vec4& placeholder)
+{
+	StreamedTexture streamedTexture;
+	streamedTexture.fileName = fileName;
+	streamedTexture.serial = mNextSerial++;
+
+	// only the header is read here, the pixels are decoded once a mip is requested.
+	int width = 0, height = 0, channelCount = 0;
+	if (stbi_info(fileName.c_str(), &width, &height, &channelCount))
+	{
+		streamedTexture.width = static_cast<uint32_t>(width);
+		streamedTexture.height = static_cast<uint32_t>(height);
+		streamedTexture.channelCount = static_cast<uint32_t>(channelCount);
+		streamedTexture.mipCount = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+		streamedTexture.tailLevel = 0;
+		while (std::max(width >> streamedTexture.tailLevel, height >> streamedTexture.tailLevel) > static_cast<int>(mInfo.minResidentSize))
+			streamedTexture.tailLevel++;
+	}
+	else
+	{
+		// the placeholder stays as the only level.
+		std::cout << "Failed to load texture " << fileName << std::endl;
+		streamedTexture.width = streamedTexture.height = 1;
+		streamedTexture.channelCount = 4;
+		streamedTexture.mipCount = 1;
+		streamedTexture.isFailed = true;
+	}
+	streamedTexture.residentLevel = streamedTexture.mipCount;
+	streamedTexture.pendingLevel = streamedTexture.residentLevel;
+	streamedTexture.desiredLevel = streamedTexture.tailLevel;
+	streamedTexture.lastRequestFrame = mFrameIndex;
+
+	uint32_t textureName = 0;
+	uint32_t placeholderLevel = streamedTexture.mipCount - 1;
+	glGenTextures(1, &textureName);
+	glBindTexture(GL_TEXTURE_2D, textureName);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapSType);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapTType);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// levels below the base level are left undefined or empty, they do not count for completeness.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, placeholderLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, placeholderLevel);
+	glTexImage2D(GL_TEXTURE_2D, placeholderLevel, GetInternalFormat(streamedTexture.channelCount), 1, 1, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	mTextures.insert({ textureName, std::move(streamedTexture) });
+
+	Texture texture(fileName);
+	texture.SetTexture(textureName);
+	return texture;
+}
+void TextureStreamer::ReleaseTexture(Texture& texture)
+{
+	auto iter = mTextures.find(texture.GetTexture());
+	if (iter == mTextures.end())
+		return;
+
+	// a job still in flight is dropped by its serial once it comes back.
+	StreamedTexture& streamedTexture = iter->second;
+	if (streamedTexture.pendingLevel < streamedTexture.residentLevel)
+		mPendingBytes -= GetLevelBytes(streamedTexture, streamedTexture.pendingLevel, streamedTexture.residentLevel - 1);
+	if (streamedTexture.residentLevel < streamedTexture.mipCount)
+		mResidentBytes -= GetLevelBytes(streamedTexture, streamedTexture.residentLevel, streamedTexture.mipCount - 1);
+	mTextures.erase(iter);
+}
+
+void TextureStreamer::RequestSize(Texture& texture, float screenSize)
+{
+	auto iter = mTextures.find(texture.GetTexture());
+	if (iter == mTextures.end())
+		return;
+
+	StreamedTexture& streamedTexture = iter->second;
+	if (streamedTexture.lastRequestFrame != mFrameIndex)
+	{
+		streamedTexture.lastRequestFrame = mFrameIndex;
+		streamedTexture.requestedSize = screenSize;
+	}
+	else
+		streamedTexture.requestedSize = std::max(streamedTexture.requestedSize, screenSize);
+}
+void TextureStreamer::Update()
+{
+	TRACE_CPU_ZONE("TextureStreamer::Update");
+
+	if (!mIsInitialized)
+		return;
+
+	// the finest level whose size does not exceed the requested one, never coarser than the tail.
+	for (auto& [textureName, streamedTexture] : mTextures)
+	{
+		if (streamedTexture.lastRequestFrame != mFrameIndex || streamedTexture.requestedSize <= 0.0f)
+			continue;
+
+		float size = static_cast<float>(std::max(streamedTexture.width, streamedTexture.height));
+		int level = static_cast<int>(std::floor(std::log2(size / streamedTexture.requestedSize)));
+		streamedTexture.desiredLevel = static_cast<uint32_t>(std::clamp(level, 0, static_cast<int>(streamedTexture.tailLevel)));
+	}
+
+	UploadDecodedMips();
+	// the budget may have shrunk.
+	MakeRoom(0, 0);
+	RequestLevels();
+
+	mFrameIndex++;
+}
+
+size_t TextureStreamer::GetResidentBytes()
+{
+	return mResidentBytes;
+}
+size_t TextureStreamer::GetResidencyBudget()
+{
+	return mInfo.residencyBudget;
+}
+void TextureStreamer::SetResidencyBudget(size_t budget)
+{
+	mInfo.residencyBudget = budget;
+}
+
+// private methods
+void TextureStreamer::WorkerLoop()
+{
+	// Texture flips every image it loads, the flag of the worker threads is their own.
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQueueCondition.wait(lock, [this] { return mIsStopping || !mDecodeJobs.empty(); });
+		if (mIsStopping)
+			return;
+
+		DecodeJob job = std::move(mDecodeJobs.front());
+		mDecodeJobs.pop_front();
+		lock.unlock();
+
+		DecodedMips mips;
+		DecodeMips(job, mips);
+
+		lock.lock();
+		mDecodedMips.push_back(std::move(mips));
+	}
+}
+void TextureStreamer::DecodeMips(const DecodeJob& job, DecodedMips& mips)
+{
+	TRACE_CPU_ZONE("TextureStreamer::DecodeMips");
+
+	mips.texture = job.texture;
+	mips.serial = job.serial;
+	mips.channelCount = job.channelCount;
+
+	int width = 0, height = 0, fileChannelCount = 0;
+	uint8_t* data = stbi_load(job.fileName.c_str(), &width, &height, &fileChannelCount, job.channelCount);
+	if (!data)
+	{
+		mips.isFailed = true;
+		return;
+	}
+
+	uint32_t channelCount = job.channelCount;
+	uint32_t levelWidth = static_cast<uint32_t>(width);
+	uint32_t levelHeight = static_cast<uint32_t>(height);
+	std::vector<uint8_t> pixels(data, data + static_cast<size_t>(levelWidth) * levelHeight * channelCount);
+	stbi_image_free(data);
+
+	// 2x2 box filter down the chain, odd sizes clamp the last row and column like the gl mip sizes do.
+	for (uint32_t level = 0; level <= job.lastLevel; level++)
+	{
+		if (level >= job.firstLevel)
+			mips.levels.push_back({ level, levelWidth, levelHeight, pixels });
+		if (level == job.lastLevel)
+			break;
+
+		uint32_t nextWidth = std::max(levelWidth / 2, 1u);
+		uint32_t nextHeight = std::max(levelHeight / 2, 1u);
+		std::vector<uint8_t> nextPixels(static_cast<size_t>(nextWidth) * nextHeight * channelCount);
+		for (uint32_t y = 0; y < nextHeight; y++)
+		{
+			const uint8_t* row0 = pixels.data() + static_cast<size_t>(std::min(y * 2, levelHeight - 1)) * levelWidth * channelCount;
+			const uint8_t* row1 = pixels.data() + static_cast<size_t>(std::min(y * 2 + 1, levelHeight - 1)) * levelWidth * channelCount;
+			uint8_t* destination = nextPixels.data() + static_cast<size_t>(y) * nextWidth * channelCount;
+			for (uint32_t x = 0; x < nextWidth; x++)
+			{
+				uint32_t x0 = std::min(x * 2, levelWidth - 1) * channelCount;
+				uint32_t x1 = std::min(x * 2 + 1, levelWidth - 1) * channelCount;
+				for (uint32_t c = 0; c < channelCount; c++)
+					destination[x * channelCount + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+		pixels = std::move(nextPixels);
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+}
+
+size_t TextureStreamer::GetLevelBytes(const StreamedTexture& texture, uint32_t firstLevel, uint32_t lastLevel)
+{
+	// rgb is padded to 4 bytes per texel by most drivers.
+	size_t texelSize = texture.channelCount == 3 ? 4 : texture.channelCount;
+	size_t bytes = 0;
+	for (uint32_t level = firstLevel; level <= lastLevel; level++)
+		bytes += static_cast<size_t>(std::max(texture.width >> level, 1u)) * std::max(texture.height >> level, 1u) * texelSize;
+	return bytes;
+}
+bool TextureStreamer::EvictLevel(uint32_t textureName, StreamedTexture& texture)
+{
+	if (texture.residentLevel >= texture.tailLevel || texture.pendingLevel != texture.residentLevel)
+		return false;
+
+	// the base level moves first, then the level is redefined empty to give its memory back.
+	uint32_t level = texture.residentLevel;
+	glBindTexture(GL_TEXTURE_2D, textureName);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	glTexImage2D(GL_TEXTURE_2D, level, GetInternalFormat(texture.channelCount), 0, 0, 0,
+		GetFormat(texture.channelCount), GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	mResidentBytes -= GetLevelBytes(texture, level, level);
+	texture.residentLevel++;
+	texture.pendingLevel++;
+	return true;
+}
+bool TextureStreamer::MakeRoom(size_t bytes, uint32_t keepTexture)
+{
+	// least recently requested first, then the largest level. textures requested this frame only give up
+	// levels finer than they asked for.
+	while (mResidentBytes + mPendingBytes + bytes > mInfo.residencyBudget)
+	{
+		uint32_t victimName = 0;
+		StreamedTexture* victim = nullptr;
+		for (auto& [textureName, streamedTexture] : mTextures)
+		{
+			if (textureName == keepTexture || streamedTexture.residentLevel >= streamedTexture.tailLevel ||
+				streamedTexture.pendingLevel != streamedTexture.residentLevel)
+				continue;
+			if (streamedTexture.lastRequestFrame == mFrameIndex && streamedTexture.residentLevel >= streamedTexture.desiredLevel)
+				continue;
+
+			if (victim == nullptr || streamedTexture.lastRequestFrame < victim->lastRequestFrame ||
+				(streamedTexture.lastRequestFrame == victim->lastRequestFrame &&
+					GetLevelBytes(streamedTexture, streamedTexture.residentLevel, streamedTexture.residentLevel) >
+					GetLevelBytes(*victim, victim->residentLevel, victim->residentLevel)))
+			{
+				victimName = textureName;
+				victim = &streamedTexture;
+			}
+		}
+		if (victim == nullptr || !EvictLevel(victimName, *victim))
+			return false;
+	}
+	return true;
+}
+void TextureStreamer::RequestLevels()
+{
+	// textures with only the placeholder first, then the ones requested most recently and missing the most levels.
+	std::vector<std::pair<uint32_t, StreamedTexture*>> candidates;
+	for (auto& [textureName, streamedTexture] : mTextures)
+	{
+		bool isPlaceholder = streamedTexture.residentLevel == streamedTexture.mipCount;
+		if (streamedTexture.isFailed || streamedTexture.pendingLevel != streamedTexture.residentLevel ||
+			streamedTexture.desiredLevel >= streamedTexture.residentLevel)
+			continue;
+		if (!isPlaceholder && streamedTexture.lastRequestFrame != mFrameIndex)
+			continue;
+		candidates.push_back({ textureName, &streamedTexture });
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+		{
+			bool isPlaceholderA = a.second->residentLevel == a.second->mipCount;
+			bool isPlaceholderB = b.second->residentLevel == b.second->mipCount;
+			if (isPlaceholderA != isPlaceholderB)
+				return isPlaceholderA;
+			if (a.second->lastRequestFrame != b.second->lastRequestFrame)
+				return a.second->lastRequestFrame > b.second->lastRequestFrame;
+			return a.second->residentLevel - a.second->desiredLevel > b.second->residentLevel - b.second->desiredLevel;
+		});
+
+	// every queued job holds a decoded image until it is uploaded.
+	uint32_t maxInFlightJobCount = mInfo.decodeThreadCount * 2;
+	bool isQueued = false;
+	for (auto& [textureName, streamedTexture] : candidates)
+	{
+		if (mInFlightJobCount >= maxInFlightJobCount)
+			break;
+
+		uint32_t firstLevel = streamedTexture->desiredLevel;
+		uint32_t lastLevel = streamedTexture->residentLevel - 1;
+		bool isPlaceholder = streamedTexture->residentLevel == streamedTexture->mipCount;
+
+		// the tail always fits, finer levels are given up until the rest does.
+		size_t bytes = GetLevelBytes(*streamedTexture, firstLevel, lastLevel);
+		if (!MakeRoom(bytes, textureName))
+		{
+			while (firstLevel < lastLevel && firstLevel < streamedTexture->tailLevel &&
+				mResidentBytes + mPendingBytes + GetLevelBytes(*streamedTexture, firstLevel, lastLevel) > mInfo.residencyBudget)
+				firstLevel++;
+			bytes = GetLevelBytes(*streamedTexture, firstLevel, lastLevel);
+			if (!isPlaceholder && mResidentBytes + mPendingBytes + bytes > mInfo.residencyBudget)
+				continue;
+		}
+
+		DecodeJob job;
+		job.texture = textureName;
+		job.serial = streamedTexture->serial;
+		job.fileName = streamedTexture->fileName;
+		job.channelCount = streamedTexture->channelCount;
+		job.firstLevel = firstLevel;
+		job.lastLevel = lastLevel;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mDecodeJobs.push_back(std::move(job));
+		}
+		streamedTexture->pendingLevel = firstLevel;
+		mPendingBytes += bytes;
+		mInFlightJobCount++;
+		isQueued = true;
+	}
+	if (isQueued)
+		mQueueCondition.notify_all();
+}
+void TextureStreamer::UploadDecodedMips()
+{
+	TRACE_CPU_ZONE("TextureStreamer::UploadDecodedMips");
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& mips : mDecodedMips)
+			mUploads.push_back(std::move(mips));
+		mDecodedMips.clear();
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (!mUploads.empty())
+	{
+		DecodedMips& mips = mUploads.front();
+		auto iter = mTextures.find(mips.texture);
+		if (iter == mTextures.end() || iter->second.serial != mips.serial)
+		{
+			// released while it was decoded.
+			mUploads.pop_front();
+			mInFlightJobCount--;
+			continue;
+		}
+
+		StreamedTexture& streamedTexture = iter->second;
+		if (mips.isFailed)
+		{
+			std::cout << "Failed to load texture " << streamedTexture.fileName << std::endl;
+			mPendingBytes -= GetLevelBytes(streamedTexture, streamedTexture.pendingLevel, streamedTexture.residentLevel - 1);
+			streamedTexture.pendingLevel = streamedTexture.residentLevel;
+			streamedTexture.isFailed = true;
+			mUploads.pop_front();
+			mInFlightJobCount--;
+			continue;
+		}
+
+		// a few bands per frame, the rest waits for a pixel buffer the gpu is done with.
+		GLenum internalFormat = GetInternalFormat(mips.channelCount);
+		GLenum format = GetFormat(mips.channelCount);
+		bool isBufferAvailable = true;
+		glBindTexture(GL_TEXTURE_2D, mips.texture);
+		while (mips.uploadedLevelCount < mips.levels.size())
+		{
+			MipLevel& mipLevel = mips.levels[mips.uploadedLevelCount];
+			size_t rowSize = static_cast<size_t>(mipLevel.width) * mips.channelCount;
+			if (mips.uploadedRowCount == 0)
+			{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glTexImage2D(GL_TEXTURE_2D, mipLevel.level, internalFormat, mipLevel.width, mipLevel.height, 0,
+					format, GL_UNSIGNED_BYTE, nullptr);
+			}
+
+			UploadBuffer* uploadBuffer = AcquireUploadBuffer();
+			if (uploadBuffer == nullptr)
+			{
+				isBufferAvailable = false;
+				break;
+			}
+
+			uint32_t rowCount = std::min(mipLevel.height - mips.uploadedRowCount,
+				static_cast<uint32_t>(std::max(mInfo.uploadBufferSize / rowSize, size_t(1))));
+			size_t bandSize = rowCount * rowSize;
+			const uint8_t* band = mipLevel.pixels.data() + mips.uploadedRowCount * rowSize;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer->buffer);
+			void* mappedBuffer = bandSize <= mInfo.uploadBufferSize ?
+				glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bandSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT) : nullptr;
+			if (mappedBuffer != nullptr)
+			{
+				std::memcpy(mappedBuffer, band, bandSize);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				glTexSubImage2D(GL_TEXTURE_2D, mipLevel.level, 0, mips.uploadedRowCount, mipLevel.width, rowCount,
+					format, GL_UNSIGNED_BYTE, nullptr);
+				uploadBuffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+			else
+			{
+				// a row larger than the buffer, or the map failed.
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glTexSubImage2D(GL_TEXTURE_2D, mipLevel.level, 0, mips.uploadedRowCount, mipLevel.width, rowCount,
+					format, GL_UNSIGNED_BYTE, band);
+			}
+
+			mips.uploadedRowCount += rowCount;
+			if (mips.uploadedRowCount == mipLevel.height)
+			{
+				std::vector<uint8_t>().swap(mipLevel.pixels);
+				mips.uploadedRowCount = 0;
+				mips.uploadedLevelCount++;
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!isBufferAvailable)
+		{
+			glBindTexture(GL_TEXTURE_2D, 0);
+			break;
+		}
+
+		// every level is defined now, the commands that filled them run before any draw that samples them.
+		uint32_t firstLevel = mips.levels.front().level;
+		uint32_t lastLevel = mips.levels.back().level;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		size_t bytes = GetLevelBytes(streamedTexture, firstLevel, lastLevel);
+		mPendingBytes -= bytes;
+		mResidentBytes += bytes;
+		streamedTexture.residentLevel = firstLevel;
+		streamedTexture.pendingLevel = firstLevel;
+
+		mUploads.pop_front();
+		mInFlightJobCount--;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+TextureStreamer::UploadBuffer* TextureStreamer::AcquireUploadBuffer()
+{
+	// round robin, a buffer whose last upload the gpu has not consumed yet ends the uploads of this frame.
+	UploadBuffer& uploadBuffer = mUploadBuffers[mNextUploadBuffer];
+	if (uploadBuffer.fence != nullptr)
+	{
+		GLenum status = glClientWaitSync(uploadBuffer.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+			return nullptr;
+		glDeleteSync(uploadBuffer.fence);
+		uploadBuffer.fence = nullptr;
+	}
+	mNextUploadBuffer = (mNextUploadBuffer + 1) % mUploadBuffers.size();
+	return &uploadBuffer;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+#include "Stdafx.h"
+#include "Texture.h"
+
+struct TextureStreamerInfo
+{
+	size_t residencyBudget = 512ull << 20; // bytes of mip levels kept in vram
+	uint32_t minResidentSize = 64; // mips this size and smaller are never evicted
+	uint32_t decodeThreadCount = 0; // 0 uses half the hardware threads
+	uint32_t uploadBufferCount = 4; // pixel buffers, each can be in flight for a frame
+	uint32_t uploadBufferSize = 4u << 20; // bytes, larger levels are uploaded in bands of rows
+};
+
+// 2d textures that start as a 1x1 placeholder and stream their mips in on demand.
+// RequestSize says how large a texture covers the screen, Update turns that into mip levels,
+// decodes them on worker threads, uploads them through pixel buffers and evicts the least recently
+// requested levels to stay within the budget.
+// the texture name never changes, mips above the resident one are redefined empty, so copies of the Texture stay valid.
+class TextureStreamer
+{
+public:
+	TextureStreamer() = default;
+	~TextureStreamer();
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	void Initialize(const TextureStreamerInfo& info);
+	// stops the decoders and deletes the pixel buffers, the textures belong to their owners.
+	void DeleteTextureStreamer();
+
+	// placeholder is shown until the first mips arrive, e.g. white for albedo, (128, 128, 255) for normals.
+	Texture CreateStreamedTexture(const std::string& fileName, GLenum wrapSType, GLenum wrapTType,
+		const glm::u8vec4& placeholder = glm::u8vec4(255));
+	// call before deleting the texture.
+	void ReleaseTexture(Texture& texture);
+
+	// texture covers about screenSize pixels this frame, the larger of several requests wins.
+	void RequestSize(Texture& texture, float screenSize);
+	// once per frame on the context thread, before drawing.
+	void Update();
+
+	size_t GetResidentBytes();
+	size_t GetResidencyBudget();
+	void SetResidencyBudget(size_t budget);
+private:
+	struct StreamedTexture
+	{
+		std::string fileName;
+		uint64_t serial = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t channelCount = 0;
+		uint32_t mipCount = 0;
+		uint32_t tailLevel = 0; // first level of the never evicted tail
+
+		uint32_t residentLevel = 0; // finest uploaded level, mipCount while only the placeholder is there
+		uint32_t pendingLevel = 0; // finest level requested from the decoders, residentLevel when none is
+		uint32_t desiredLevel = 0;
+		float requestedSize = 0.0f;
+		uint64_t lastRequestFrame = 0;
+		bool isFailed = false; // a decode failed, the texture stays as it is
+	};
+
+	struct DecodeJob
+	{
+		uint32_t texture = 0;
+		uint64_t serial = 0;
+		std::string fileName;
+		uint32_t channelCount = 0;
+		uint32_t firstLevel = 0;
+		uint32_t lastLevel = 0; // inclusive
+	};
+
+	struct MipLevel
+	{
+		uint32_t level = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct DecodedMips
+	{
+		uint32_t texture = 0;
+		uint64_t serial = 0;
+		uint32_t channelCount = 0;
+		std::vector<MipLevel> levels; // finest first
+		uint32_t uploadedLevelCount = 0;
+		uint32_t uploadedRowCount = 0; // of the level being uploaded
+		bool isFailed = false;
+	};
+
+	struct UploadBuffer
+	{
+		uint32_t buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	void WorkerLoop();
+	static void DecodeMips(const DecodeJob& job, DecodedMips& mips);
+
+	size_t GetLevelBytes(const StreamedTexture& texture, uint32_t firstLevel, uint32_t lastLevel);
+	bool EvictLevel(uint32_t textureName, StreamedTexture& texture);
+	bool MakeRoom(size_t bytes, uint32_t keepTexture);
+	void RequestLevels();
+	void UploadDecodedMips();
+	UploadBuffer* AcquireUploadBuffer();
+private:
+	TextureStreamerInfo mInfo{};
+	bool mIsInitialized = false;
+
+	std::unordered_map<uint32_t, StreamedTexture> mTextures; // by texture name
+	uint64_t mNextSerial = 1;
+	uint64_t mFrameIndex = 0;
+	size_t mResidentBytes = 0;
+	size_t mPendingBytes = 0; // requested and not yet uploaded, already counted against the budget
+	uint32_t mInFlightJobCount = 0; // queued, decoding or uploading, bounds the decoded images held in memory
+
+	std::vector<UploadBuffer> mUploadBuffers;
+	uint32_t mNextUploadBuffer = 0;
+	std::deque<DecodedMips> mUploads; // decoded, uploaded in order a few bands per frame
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mQueueCondition;
+	std::deque<DecodeJob> mDecodeJobs;
+	std::deque<DecodedMips> mDecodedMips;
+	bool mIsStopping = false;
+};
\ No newline at end of file
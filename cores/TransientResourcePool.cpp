@@ -0,0 +1,121 @@
+#include "TransientResourcePool.h"
+
+void TransientResourcePool::DeleteTransientResourcePool()
+{
+	for (auto& texture : mTextures)
+		glDeleteTextures(1, &texture.name);
+	mTextures.clear();
+
+	if (!mFramebuffers.empty())
+		glDeleteFramebuffers(static_cast<GLsizei>(mFramebuffers.size()), mFramebuffers.data());
+	mFramebuffers.clear();
+	mFreeFramebuffers.clear();
+}
+
+void TransientResourcePool::BeginFrame()
+{
+	mFrameIndex++;
+}
+void TransientResourcePool::TrimUnused(uint32_t maxIdleFrameCount)
+{
+	auto isIdle = [&](TransientTexture& texture)
+	{
+		if (texture.isAcquired || mFrameIndex - texture.lastUsedFrame <= maxIdleFrameCount)
+			return false;
+
+		glDeleteTextures(1, &texture.name);
+		return true;
+	};
+	mTextures.erase(std::remove_if(mTextures.begin(), mTextures.end(), isIdle), mTextures.end());
+}
+
+uint32_t TransientResourcePool::AcquireFramebuffer()
+{
+	if (!mFreeFramebuffers.empty())
+	{
+		uint32_t framebuffer = mFreeFramebuffers.back();
+		mFreeFramebuffers.pop_back();
+		return framebuffer;
+	}
+
+	uint32_t framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	mFramebuffers.push_back(framebuffer);
+	return framebuffer;
+}
+void TransientResourcePool::ReleaseFramebuffer(uint32_t framebuffer)
+{
+	// detach everything so the next pass does not inherit attachments of another size.
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+	GLint maxColorAttachments = 0;
+	glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &maxColorAttachments);
+	for (GLint i = 0; i < maxColorAttachments; i++)
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, 0, 0);
+	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, 0, 0);
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+
+	mFreeFramebuffers.push_back(framebuffer);
+}
+
+uint32_t TransientResourcePool::AcquireTexture(uint32_t width, uint32_t height, GLenum internalFormat)
+{
+	// alias a released texture of the same key before allocating new storage.
+	for (auto& texture : mTextures)
+	{
+		if (texture.isAcquired || texture.width != width || texture.height != height || texture.internalFormat != internalFormat)
+			continue;
+
+		texture.isAcquired = true;
+		texture.lastUsedFrame = mFrameIndex;
+		return texture.name;
+	}
+
+	TransientTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.internalFormat = internalFormat;
+	texture.isAcquired = true;
+	texture.lastUsedFrame = mFrameIndex;
+
+	glGenTextures(1, &texture.name);
+	glBindTexture(GL_TEXTURE_2D, texture.name);
+	glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	mAllocationCount++;
+
+	mTextures.push_back(texture);
+	return texture.name;
+}
+void TransientResourcePool::ReleaseTexture(uint32_t name)
+{
+	for (auto& texture : mTextures)
+	{
+		if (texture.name == name)
+		{
+			texture.isAcquired = false;
+			texture.lastUsedFrame = mFrameIndex;
+			return;
+		}
+	}
+
+	std::cout << "ERROR::TRANSIENT_RESOURCE_POOL:: Released texture is not in the pool!" << std::endl;
+}
+
+uint32_t TransientResourcePool::GetAllocationCount()
+{
+	return mAllocationCount;
+}
+uint32_t TransientResourcePool::GetTextureCount()
+{
+	return static_cast<uint32_t>(mTextures.size());
+}
\ No newline at end of file
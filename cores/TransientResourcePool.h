@@ -0,0 +1,46 @@
+#pragma once
+#include "Stdafx.h"
+
+// transient textures and framebuffers shared by passes that do not overlap.
+// a texture released by one pass is handed to the next pass asking for the same size and format,
+// so a chain of passes allocates storage once instead of reallocating it every pass.
+class TransientResourcePool
+{
+public:
+	TransientResourcePool() = default;
+
+	void DeleteTransientResourcePool();
+
+	// call once per frame, textures idle for more than maxIdleFrameCount frames are deleted by TrimUnused.
+	void BeginFrame();
+	void TrimUnused(uint32_t maxIdleFrameCount);
+
+	// framebuffers without owned attachments, the pass attaches what it renders into.
+	uint32_t AcquireFramebuffer();
+	void ReleaseFramebuffer(uint32_t framebuffer);
+
+	// immutable single-level 2D textures keyed by size and internal format.
+	uint32_t AcquireTexture(uint32_t width, uint32_t height, GLenum internalFormat);
+	void ReleaseTexture(uint32_t texture);
+
+	uint32_t GetAllocationCount(); // storage allocations made since the pool was created
+	uint32_t GetTextureCount();
+private:
+	struct TransientTexture
+	{
+		uint32_t name = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		GLenum internalFormat = GL_NONE;
+		bool isAcquired = false;
+		uint64_t lastUsedFrame = 0;
+	};
+private:
+	std::vector<TransientTexture> mTextures;
+
+	std::vector<uint32_t> mFramebuffers;
+	std::vector<uint32_t> mFreeFramebuffers;
+
+	uint64_t mFrameIndex = 0;
+	uint32_t mAllocationCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "CpuTracer.h"
+#include "UploadRing.h"
+
+void UploadRing::CreateUploadRing(size_t frameSize, uint32_t frameCount)
+{
+	DeleteUploadRing();
+
+	GLint uniformBufferAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
+	mUniformBufferAlignment = std::max<size_t>(uniformBufferAlignment, 1);
+
+	// regions start aligned, so an allocation at the start of one needs no padding.
+	mFrameSize = (frameSize + mUniformBufferAlignment - 1) / mUniformBufferAlignment * mUniformBufferAlignment;
+	mFrameFences.assign(std::max(frameCount, 1u), nullptr);
+	size_t bufferSize = mFrameSize * mFrameFences.size();
+
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+	if (GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, flags);
+		mMappedData = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bufferSize, flags));
+		if (mMappedData == nullptr)
+			std::cout << "ERROR::UPLOAD_RING:: Failed to map the buffer persistently" << std::endl;
+	}
+	else
+		glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mFrameIndex = 0;
+	mFrameOffset = 0;
+}
+void UploadRing::DeleteUploadRing()
+{
+	for (auto& fence : mFrameFences)
+	{
+		if (fence != nullptr)
+			glDeleteSync(fence);
+	}
+	mFrameFences.clear();
+
+	if (mBuffer != 0)
+	{
+		if (mMappedData != nullptr)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &mBuffer);
+	}
+	mBuffer = 0;
+	mMappedData = nullptr;
+}
+
+void UploadRing::BeginFrame()
+{
+	TRACE_CPU_ZONE("UploadRing::BeginFrame");
+
+	if (mFrameFences.empty())
+		return;
+
+	mFrameIndex = (mFrameIndex + 1) % mFrameFences.size();
+	mFrameOffset = 0;
+	mIsFrameFull = false;
+
+	GLsync& fence = mFrameFences[mFrameIndex];
+	if (fence == nullptr)
+		return;
+
+	// only stalls when the cpu is frameCount frames ahead of the gpu.
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	while (status == GL_TIMEOUT_EXPIRED)
+		status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+void UploadRing::EndFrame()
+{
+	if (mFrameFences.empty())
+		return;
+
+	GLsync& fence = mFrameFences[mFrameIndex];
+	if (fence != nullptr)
+		glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool UploadRing::Upload(const void* data, size_t size, UploadAllocation& allocation, size_t alignment)
+{
+	if (mBuffer == 0)
+		return false;
+	if (alignment == 0)
+		alignment = mUniformBufferAlignment;
+
+	size_t offset = (mFrameOffset + alignment - 1) / alignment * alignment;
+	if (offset + size > mFrameSize)
+	{
+		if (!mIsFrameFull)
+			std::cout << "ERROR::UPLOAD_RING:: Frame region of " << mFrameSize << " bytes is full" << std::endl;
+		mIsFrameFull = true;
+		return false;
+	}
+	mFrameOffset = offset + size;
+
+	allocation.buffer = mBuffer;
+	allocation.offset = mFrameIndex * mFrameSize + offset;
+	allocation.size = size;
+
+	if (mMappedData != nullptr)
+	{
+		// coherent, visible to commands issued after this.
+		std::memcpy(mMappedData + allocation.offset, data, size);
+		return true;
+	}
+
+	// the fence of BeginFrame already synchronized the region, the driver must not wait again.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+	void* mappedRange = glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mappedRange != nullptr)
+	{
+		std::memcpy(mappedRange, data, size);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return mappedRange != nullptr;
+}
+void UploadRing::BindUniformBuffer(uint32_t binding, const UploadAllocation& allocation)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, allocation.buffer, allocation.offset, allocation.size);
+}
+
+uint32_t UploadRing::GetBuffer()
+{
+	return mBuffer;
+}
+bool UploadRing::IsPersistentlyMapped()
+{
+	return mMappedData != nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "Stdafx.h"
+
+// a range of the ring written this frame, valid until the ring comes back to this frame's region.
+struct UploadAllocation
+{
+	uint32_t buffer = 0;
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+// per-frame data (constants, dynamic vertices) goes into one buffer split into frameCount regions.
+// the region of a frame is fenced at EndFrame and only written again once the gpu is past the fence,
+// so uploads never orphan a buffer or wait for draws that still read it.
+// with gl 4.4 the buffer is persistently and coherently mapped, otherwise every upload maps its range unsynchronized.
+class UploadRing
+{
+public:
+	UploadRing() = default;
+
+	void CreateUploadRing(size_t frameSize, uint32_t frameCount = 3);
+	void DeleteUploadRing();
+
+	// waits for the fence of the region about to be reused, it has normally passed already.
+	void BeginFrame();
+	void EndFrame();
+
+	// alignment 0 uses the uniform buffer offset alignment. false when the region of this frame is full.
+	bool Upload(const void* data, size_t size, UploadAllocation& allocation, size_t alignment = 0);
+	// binds the allocation to a uniform block binding point.
+	void BindUniformBuffer(uint32_t binding, const UploadAllocation& allocation);
+
+	uint32_t GetBuffer();
+	bool IsPersistentlyMapped();
+private:
+	uint32_t mBuffer = 0;
+	uint8_t* mMappedData = nullptr; // persistent mapping, null when every upload maps its own range
+	size_t mFrameSize = 0;
+	size_t mUniformBufferAlignment = 256;
+
+	std::vector<GLsync> mFrameFences;
+	uint32_t mFrameIndex = 0; // region written between BeginFrame and EndFrame
+	size_t mFrameOffset = 0; // next free byte of the region
+	bool mIsFrameFull = false; // reported once per frame
+};
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include "CpuTracer.h"
 #include "Utility.h"
 
 void CheckCompileErrors(uint32_t id, std::string type)
@@ -92,6 +93,8 @@ std::vector<std::string> Split(std::string input, char delimiter)
 
 void SaveScreenshotToPNG(const std::string& filename, uint32_t width, uint32_t height)
 {
+	TRACE_CPU_ZONE("SaveScreenshotToPNG");
+
 	cv::Mat image(height, width, CV_8UC3);
 
 	//use fast 4-byte alignment (default anyway) if possible
@@ -109,3 +112,39 @@ void SaveScreenshotToPNG(const std::string& filename, uint32_t width, uint32_t h
 
 	cv::imwrite(filename, image);
 }
+
+
+bool IsExtensionSupported(const std::string& extensionName)
+{
+	int extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (int i = 0; i < extensionCount; i++)
+	{
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (name != nullptr && extensionName == name)
+			return true;
+	}
+	return false;
+}
+
+bool IsSphereInCubeFace(const glm::vec3& lightPosition, uint32_t face, float farPlane,
+	const glm::vec3& center, float radius)
+{
+	glm::vec3 toCenter = center - lightPosition;
+	if (glm::length(toCenter) - radius > farPlane)
+		return false;
+
+	uint32_t axis = face / 2;
+	float along = (face % 2 == 0) ? toCenter[axis] : -toCenter[axis];
+	if (along < -radius)
+		return false;
+
+	// the side planes of a 90 degree frustum are |other| = along, their normals are scaled by sqrt(2).
+	const float sideRadius = radius * glm::root_two<float>();
+	for (uint32_t i = 1; i < 3; i++)
+	{
+		if (std::abs(toCenter[(axis + i) % 3]) - along > sideRadius)
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -96,6 +96,7 @@ struct RenderItem
 	Mesh* mesh = nullptr;
 	Material* material = nullptr;
 	bool isTexture = false;
+	bool isStaticShadowCaster = false; // cached in the static shadow pages, only for items that never move
 	std::vector<Texture*> albedoMaps;
 	std::vector<Texture*> specularMaps;
 	std::vector<Texture*> normalMaps;
@@ -118,6 +119,16 @@ struct RenderItem
 	Texture* brdfLUT = nullptr;
 };
 
+// layout of one glDrawElementsIndirect command.
+struct DrawElementsIndirectCommand
+{
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
 struct Menu
 {
 	bool isUsingTexture = false;
@@ -125,6 +136,7 @@ struct Menu
 	bool enableEnvironment = false;
 	bool enableImageBasedLighting = false;
 	bool enableShadow = false;
+	bool enableClusteredLighting = false;
 };
 
 void CheckCompileErrors(uint32_t id, std::string type);
@@ -144,4 +156,10 @@ void SetMat4(uint32_t programID, const std::string& name, const glm::mat4& mat);
 
 std::vector<std::string> Split(std::string input, char delimiter);
 
-void SaveScreenshotToPNG(const std::string& filename, uint32_t width, uint32_t height);
\ No newline at end of file
+void SaveScreenshotToPNG(const std::string& filename, uint32_t width, uint32_t height);
+
+bool IsExtensionSupported(const std::string& extensionName);
+
+// conservative test of a bounding sphere against one 90 degree face frustum of a point light (face order +X, -X, +Y, -Y, +Z, -Z).
+bool IsSphereInCubeFace(const glm::vec3& lightPosition, uint32_t face, float farPlane,
+	const glm::vec3& center, float radius);
\ No newline at end of file
@@ -14,8 +14,10 @@ void main()
 {
 	vec3 envColor = texture(environmentMap, vs_out.texCoords).rgb;
 	
+#ifndef OUTPUT_LINEAR_HDR
 	envColor = envColor / (envColor + vec3(1.0));
     envColor = pow(envColor, vec3(1.0/2.2)); 
+#endif
     
     color = vec4(envColor, 1.0);
 }
\ No newline at end of file
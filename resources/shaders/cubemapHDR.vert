@@ -1,4 +1,12 @@
 #version 430 core
+#ifdef MULTI_VIEW
+// writing gl_Layer from the vertex shader needs one of these, the renderer picks the one the driver exposes.
+#ifdef USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY
+#extension GL_ARB_shader_viewport_layer_array : require
+#else
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+#endif
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
@@ -61,10 +69,27 @@ struct VS_OUT
 
 uniform SceneConstant sceneConstant;
 out VS_OUT vs_out;
+#ifdef MULTI_VIEW
+#ifndef MAX_MULTI_VIEW_COUNT
+#define MAX_MULTI_VIEW_COUNT 16
+#endif
+// one view per instance, filled by MultiViewTarget.
+layout (std140, binding = 1) uniform MultiViewConstant
+{
+	mat4 views[MAX_MULTI_VIEW_COUNT];
+	vec4 cameraPositions[MAX_MULTI_VIEW_COUNT];
+} multiView;
+#endif
 
 void main()
 {
 	vs_out.texCoords = aPos;
+#ifdef MULTI_VIEW
+	// the translation is dropped like the single view matrix the renderer passes in.
+	vec4 pos = sceneConstant.projection * mat4(mat3(multiView.views[gl_InstanceID])) * vec4(aPos, 1.0f);
+	gl_Layer = gl_InstanceID;
+#else
 	vec4 pos = sceneConstant.projection * sceneConstant.view * vec4(aPos, 1.0f);
+#endif
 	gl_Position = pos.xyww;
 }
\ No newline at end of file
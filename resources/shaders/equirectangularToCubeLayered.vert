@@ -0,0 +1,33 @@
+#version 430 core
+// writing gl_Layer from the vertex shader needs one of these, the renderer picks the one the driver exposes.
+#ifdef USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY
+#extension GL_ARB_shader_viewport_layer_array : require
+#else
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+struct SceneConstant
+{
+	mat4 projection;
+};
+
+struct VS_OUT
+{
+	vec3 texCoords;
+};
+
+uniform SceneConstant sceneConstant;
+uniform mat4 captureViews[6];
+out VS_OUT vs_out;
+
+void main()
+{
+	// one instance per cube face, the whole cube map is attached so the face is the layer.
+	vs_out.texCoords = aPos;
+	gl_Position = sceneConstant.projection * captureViews[gl_InstanceID] * vec4(aPos, 1.0f);
+	gl_Layer = gl_InstanceID;
+}
\ No newline at end of file
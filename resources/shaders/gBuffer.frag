@@ -1,10 +1,16 @@
 #version 430 core
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gAlbedo;
-layout (location = 2) out vec3 gNormal;
-layout (location = 3) out float gMetallic;
-layout (location = 4) out float gRoughness;
-layout (location = 5) out float gAo;
+#ifdef PACKED_G_BUFFER
+// packed layout: RGBA8 albedo + ao, RG16 octahedral normal, RG8 metallic + roughness
+layout (location = 0) out vec4 gAlbedoAo;
+layout (location = 1) out vec2 gNormal;
+layout (location = 2) out vec2 gMetallicRoughness;
+#else
+layout (location = 0) out vec3 gAlbedo;
+layout (location = 1) out vec3 gNormal;
+layout (location = 2) out float gMetallic;
+layout (location = 3) out float gRoughness;
+layout (location = 4) out float gAo;
+#endif
 
 struct SceneConstant
 {
@@ -52,25 +58,36 @@ uniform SceneConstant sceneConstant;
 const float PI = 3.14159265359f;
 
 vec3 GetNormalFromMap(sampler2D normalMap);
+vec2 EncodeOctahedralNormal(vec3 n);
 
 void main()
 {
-	gPosition = vs_out.worldPos;
-	gAlbedo = material.kd;
-	gMetallic = material.metallic;
-	gRoughness = material.roughness;
-	gAo = material.ao;
+	vec3 albedo = material.kd;
+	float metallic = material.metallic;
+	float roughness = material.roughness;
+	float ao = material.ao;
 	if (isUsingTexture)
 	{
-		gAlbedo = texture(albedoMap0, vs_out.texCoords).rgb;
-		gMetallic = texture(metallicMap0, vs_out.texCoords).r;
-		gRoughness = texture(roughnessMap0, vs_out.texCoords).r;
-		gAo = material.ao;
+		albedo = texture(albedoMap0, vs_out.texCoords).rgb;
+		metallic = texture(metallicMap0, vs_out.texCoords).r;
+		roughness = texture(roughnessMap0, vs_out.texCoords).r;
 	}
 
-	gNormal = normalize(vs_out.normal);
+	vec3 normal = normalize(vs_out.normal);
 	if (isUsingNormalMap)
-		gNormal = GetNormalFromMap(normalMap0);
+		normal = GetNormalFromMap(normalMap0);
+
+#ifdef PACKED_G_BUFFER
+	gAlbedoAo = vec4(albedo, ao);
+	gNormal = EncodeOctahedralNormal(normal);
+	gMetallicRoughness = vec2(metallic, roughness);
+#else
+	gAlbedo = albedo;
+	gNormal = normal * 0.5 + 0.5;
+	gMetallic = metallic;
+	gRoughness = roughness;
+	gAo = ao;
+#endif
 }
 
 vec3 GetNormalFromMap(sampler2D normalMap)
@@ -88,4 +105,14 @@ vec3 GetNormalFromMap(sampler2D normalMap)
 	mat3 TBN = mat3(T, B, N);
 
 	return normalize(TBN * tangentNormal);
+}
+
+// octahedral mapping of a unit vector into [0, 1]^2
+vec2 EncodeOctahedralNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	vec2 encoded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+
+	return encoded * 0.5 + 0.5;
 }
\ No newline at end of file
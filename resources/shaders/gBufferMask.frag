@@ -0,0 +1,25 @@
+#version 430 core
+
+struct VS_OUT
+{
+	vec2 texCoords;
+};
+
+in VS_OUT vs_out;
+out vec4 color;
+
+uniform sampler2D albedoMap0;
+uniform sampler2D maskMap0;
+
+void main()
+{
+#ifdef WRITE_BACKGROUND
+	// pixels outside the mask are not lit, they show the albedo like pbr_deferred.frag does for them.
+	color = texture(albedoMap0, vs_out.texCoords);
+#else
+	// marks the object pixels in the stencil, color writes are off.
+	if (texture(maskMap0, vs_out.texCoords).r != 1.0)
+		discard;
+	color = vec4(1.0);
+#endif
+}
\ No newline at end of file
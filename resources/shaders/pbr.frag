@@ -74,35 +74,112 @@ struct VS_OUT
 	mat3 TBN;
 
 	vec4 lightSpacePos[4];
+#ifdef MULTI_VIEW
+	vec3 cameraPos;
+#endif
 };
 
+// light counts and USE_* features are injected by ShaderPermutation.
+#ifndef NUM_DIRECTIONAL_LIGHTS
 #define NUM_DIRECTIONAL_LIGHTS 1
+#endif
+#ifndef NUM_POINT_LIGHTS
 #define NUM_POINT_LIGHTS 4
+#endif
+#ifndef NUM_SPOT_LIGHTS
 #define NUM_SPOT_LIGHTS 0
+#endif
 
 in VS_OUT vs_out;
 
 out vec4 color;
 
-uniform bool isUsingTexture;
-uniform bool isUsingNormalMap;
-uniform bool enableImageBasedLighting;
-uniform bool enableShadow;
-
+#ifdef USE_UPLOAD_RING
+// must match the blocks of pbr.vert.
+layout (std140, binding = 3) uniform DrawConstantBuffer
+{
+	mat4 world;
+	Material material;
+};
+#else
 uniform Material material;
+#endif
+#ifdef USE_TEXTURE
 uniform sampler2D albedoMap0;
-uniform sampler2D normalMap0;
 uniform sampler2D metallicMap0;
 uniform sampler2D roughnessMap0;
+#endif
+#ifdef USE_NORMAL_MAP
+uniform sampler2D normalMap0;
+#endif
 
+#ifdef USE_IMAGE_BASED_LIGHTING
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
+#ifndef USE_ANALYTIC_BRDF
 uniform sampler2D brdfLUT;
+#endif
+#endif
 
+#ifdef USE_SHADOW
 uniform sampler2D shadowMaps[4];
 uniform samplerCube shadowCubeMaps[4];
-
+#ifdef USE_POINT_SHADOW_ARRAY
+// every face of every point light, rendered by the layered shadow pass.
+uniform samplerCubeArray pointShadowCubeMapArray;
+#endif
+#ifdef USE_CASCADED_SHADOW
+#define MAX_CASCADES 4
+// cascades of the first directional light, see CascadedShadowMap.
+uniform sampler2DArray cascadedShadowMap;
+uniform mat4 cascadeMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES]; // far view depth of each cascade
+uniform int cascadeCount;
+#endif
+#endif
+
+#ifdef USE_UPLOAD_RING
+layout (std140, binding = 2) uniform SceneConstantBuffer
+{
+	SceneConstant sceneConstant;
+};
+#else
 uniform SceneConstant sceneConstant;
+#endif
+
+#ifdef USE_CLUSTERED_LIGHTING
+// cluster counts must match ClusteredLighting and lightCulling.comp.
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+
+struct ClusteredLight
+{
+	vec4 positionRange;
+	vec4 colorType;
+	vec4 directionCutOff;
+	vec4 outerCutOff;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+	ClusteredLight clusteredLights[];
+};
+
+layout (std430, binding = 1) readonly buffer LightGridBuffer
+{
+	uvec2 lightGrid[];
+};
+
+layout (std430, binding = 2) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uniform float clusterNearZ;
+uniform float clusterFarZ;
+uniform vec2 clusterScreenSize;
+#endif
 
 const float PI = 3.14159265359f;
 
@@ -120,21 +197,35 @@ vec3 BlinnPhong(vec3 ambient, vec3 diffuse, vec3 specular,
 vec3 CookTorrance(vec3 lightDir, vec3 radiance,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
-vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampler2D shadowMap,
+vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, int shadowMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
-vec3 CalculatePointLight(PointLight light, samplerCube shadowCubeMap,
+vec3 CalculatePointLight(PointLight light, int shadowCubeMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
 vec3 CalculateSpotLight(SpotLight light,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
 
+#ifdef USE_IMAGE_BASED_LIGHTING
 vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal, vec3 viewReflection);
+#endif
+
+#ifdef USE_CLUSTERED_LIGHTING
+vec3 CalculateClusteredLights(vec3 position,
+	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
+	vec3 viewDir, vec3 normal);
+#endif
 
 float CalculateShadow(vec4 lightSpacePos, vec3 normal, vec3 lightDir, sampler2D shadowMap);
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+float CalculateCascadedShadow(vec3 worldPos, vec3 normal, vec3 lightDir);
+#endif
 float CalculatePointShadow(vec3 worldPos, vec3 viewPos, vec3 lightPos, samplerCube shadowCubeMap);
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+float CalculatePointShadowFromArray(vec3 worldPos, vec3 viewPos, vec3 lightPos, int cubeIndex);
+#endif
 
 void main()
 {
@@ -142,19 +233,23 @@ void main()
 	float metallic = material.metallic;
 	float roughness = material.roughness;
 	float ao = material.ao;
-	if (isUsingTexture)
-	{
-		albedo = texture(albedoMap0, vs_out.texCoords).rgb;
-		metallic = texture(metallicMap0, vs_out.texCoords).r;
-		roughness = texture(roughnessMap0, vs_out.texCoords).r;
-		ao = material.ao;
-	}
+#ifdef USE_TEXTURE
+	albedo = texture(albedoMap0, vs_out.texCoords).rgb;
+	metallic = texture(metallicMap0, vs_out.texCoords).r;
+	roughness = texture(roughnessMap0, vs_out.texCoords).r;
+	ao = material.ao;
+#endif
 
 	vec3 N = vs_out.normal;
-	if (isUsingNormalMap)
-		N = GetNormalFromMapWithPreCalculatedTBN(normalMap0);
+#ifdef USE_NORMAL_MAP
+	N = GetNormalFromMapWithPreCalculatedTBN(normalMap0);
+#endif
 
+#ifdef MULTI_VIEW
+	vec3 V = normalize(vs_out.cameraPos - vs_out.worldPos);
+#else
 	vec3 V = normalize(sceneConstant.cameraPos - vs_out.worldPos);
+#endif
 	vec3 R = reflect(-V, N);
 
 	// calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -164,39 +259,49 @@ void main()
 
 	vec3 pointLightColor = vec3(0.0f);	
 
+#ifdef USE_CLUSTERED_LIGHTING
+	// point and spot lights come from the fragment's cluster instead of the uniform arrays.
+	pointLightColor = CalculateClusteredLights(vs_out.worldPos,
+		albedo, metallic, roughness, ao, F0,
+		V, N);
+#else
 	for (int i = 0; i < NUM_POINT_LIGHTS; i++)
 	{
 		pointLightColor += CalculatePointLight(sceneConstant.pointLights[i],
-			shadowCubeMaps[i],
+			i,
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
+#endif
 
 	vec3 directionalLightColor = vec3(0.0f);	
 
 	for (int i = 0; i < NUM_DIRECTIONAL_LIGHTS; i++)
 	{
 		directionalLightColor += CalculateDirectionalLight(sceneConstant.directionalLights[i],
-			vs_out.lightSpacePos[i], shadowMaps[0],
+			vs_out.lightSpacePos[i], 0,
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
 
 	vec3 spotLightColor = vec3(0.0f);	
 
+#ifndef USE_CLUSTERED_LIGHTING
 	for (int i = 0; i < NUM_SPOT_LIGHTS; i++)
 	{
 		spotLightColor += CalculateSpotLight(sceneConstant.spotLights[i],
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
+#endif
 
 	// ambient lighting (note that the next IBL tutorial will replace 
     // this ambient lighting with environment lighting).
 	vec3 ambient = vec3(0.002f);
 	ambient = ambient * albedo * ao;
-	if (enableImageBasedLighting)
-		ambient = CalculateImageBasedLight(albedo, metallic, roughness, ao, F0, V, N, R);
+#ifdef USE_IMAGE_BASED_LIGHTING
+	ambient = CalculateImageBasedLight(albedo, metallic, roughness, ao, F0, V, N, R);
+#endif
 	
 	vec3 result = ambient + pointLightColor + directionalLightColor + spotLightColor;
 
@@ -310,7 +415,7 @@ vec3 CookTorrance(vec3 lightDir, vec3 radiance,
 	return (kD * albedo / PI + specular) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
 }
 
-vec3 CalculatePointLight(PointLight light, samplerCube shadowCubeMap,
+vec3 CalculatePointLight(PointLight light, int shadowCubeMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal)
 {
@@ -322,17 +427,19 @@ vec3 CalculatePointLight(PointLight light, samplerCube shadowCubeMap,
 
 	// calculate shadow.
 	float shadow = 0.0f;
-	// if (enableShadow)
-	// 	shadow = CalculatePointShadow(vs_out.worldPos, sceneConstant.cameraPos, light.position, shadowCubeMap);
-	// else
-	// 	shadow = 0.0f;
+// #ifdef USE_SHADOW
+// 	shadow = CalculatePointShadow(vs_out.worldPos, sceneConstant.cameraPos, light.position, shadowCubeMaps[shadowCubeMapIndex]);
+// #endif
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+	shadow = CalculatePointShadowFromArray(vs_out.worldPos, sceneConstant.cameraPos, light.position, shadowCubeMapIndex);
+#endif
 
 	return (1.0f - shadow) * CookTorrance(lightDir, radiance,
 		albedo, metallic, roughness, ao, F0,
 		viewDir, normal);
 }
 
-vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampler2D shadowMap,
+vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, int shadowMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal)
 {
@@ -342,10 +449,14 @@ vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampl
 
 	// calculate shadow.
 	float shadow = 0.0f;
-	if (enableShadow)
-		shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMap);
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+	if (shadowMapIndex == 0)
+		shadow = CalculateCascadedShadow(vs_out.worldPos, normal, lightDir);
 	else
-		shadow = 0.0f;
+		shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMaps[shadowMapIndex]);
+#elif defined(USE_SHADOW)
+	shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMaps[shadowMapIndex]);
+#endif
 
 	return (1.0f - shadow) * CookTorrance(lightDir, radiance,
 		albedo, metallic, roughness, ao, F0,
@@ -372,6 +483,19 @@ vec3 CalculateSpotLight(SpotLight light,
 		viewDir, normal);
 }
 
+#ifdef USE_ANALYTIC_BRDF
+// analytic fit of the split-sum BRDF table (Karis, "Physically Based Shading on Mobile"), no texture fetch.
+vec2 EnvBRDFApprox(float NdotV, float roughness)
+{
+	const vec4 c0 = vec4(-1.0, -0.0275, -0.572, 0.022);
+	const vec4 c1 = vec4(1.0, 0.0425, 1.04, -0.04);
+	vec4 r = roughness * c0 + c1;
+	float a004 = min(r.x * r.x, exp2(-9.28 * NdotV)) * r.x + r.y;
+	return vec2(-1.04, 1.04) * a004 + r.zw;
+}
+#endif
+
+#ifdef USE_IMAGE_BASED_LIGHTING
 vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal, vec3 viewReflection)
 {
@@ -387,11 +511,16 @@ vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, floa
 	// sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
 	const float MAX_REFLECTION_LOD = 4.0;
 	vec3 prefilteredColor = textureLod(prefilterMap, viewReflection, roughness * MAX_REFLECTION_LOD).rgb;
+#ifdef USE_ANALYTIC_BRDF
+	vec2 brdf = EnvBRDFApprox(max(dot(normal, viewDir), 0.0), roughness);
+#else
 	vec2 brdf = texture(brdfLUT, vec2(max(dot(normal, viewDir), 0.0), roughness)).rg;
+#endif
 	vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 	
 	return (kD * diffuse + specular) * ao;
 }
+#endif
 
 float CalculateShadow(vec4 lightSpacePos, vec3 normal, vec3 lightDir, sampler2D shadowMap)
 {
@@ -460,4 +589,124 @@ float CalculatePointShadow(vec3 worldPos, vec3 viewPos, vec3 lightPos, samplerCu
 	shadow /= float(samples); 
 
     return shadow;
-}
\ No newline at end of file
+}
+
+#ifdef USE_CLUSTERED_LIGHTING
+vec3 CalculateClusteredLights(vec3 position,
+	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
+	vec3 viewDir, vec3 normal)
+{
+	// same exponential depth slicing as lightCulling.comp.
+	float viewDepth = -(sceneConstant.view * vec4(position, 1.0)).z;
+	float slice = log(max(viewDepth, clusterNearZ) / clusterNearZ) / log(clusterFarZ / clusterNearZ) * float(CLUSTER_COUNT_Z);
+	uint clusterZ = uint(clamp(slice, 0.0, float(CLUSTER_COUNT_Z - 1)));
+	vec2 tile = gl_FragCoord.xy / clusterScreenSize * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y);
+	uvec2 clusterXY = uvec2(clamp(tile, vec2(0.0), vec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1)));
+	uint clusterIndex = clusterXY.x + clusterXY.y * CLUSTER_COUNT_X + clusterZ * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+
+	uvec2 grid = lightGrid[clusterIndex]; // offset, count
+	vec3 result = vec3(0.0);
+	for (uint i = 0; i < grid.y; i++)
+	{
+		ClusteredLight light = clusteredLights[lightIndices[grid.x + i]];
+
+		vec3 toLight = light.positionRange.xyz - position;
+		float distance = length(toLight);
+		vec3 lightDir = toLight / max(distance, 0.0001);
+
+		// inverse-square falloff, windowed to reach zero at the culling range.
+		float ratio = distance / light.positionRange.w;
+		float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / max(distance * distance, 0.0001);
+
+		// spot light
+		if (light.colorType.w > 0.5)
+		{
+			float theta = dot(lightDir, -light.directionCutOff.xyz);
+			float epsilon = light.directionCutOff.w - light.outerCutOff.x;
+			attenuation *= clamp((theta - light.outerCutOff.x) / epsilon, 0.0, 1.0);
+		}
+
+		result += CookTorrance(lightDir, light.colorType.rgb * attenuation,
+			albedo, metallic, roughness, ao, F0,
+			viewDir, normal);
+	}
+
+	return result;
+}
+#endif
+
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+float CalculatePointShadowFromArray(vec3 worldPos, vec3 viewPos, vec3 lightPos, int cubeIndex)
+{
+	vec3 sampleOffsetDirections[20] = vec3[]
+	(
+	   vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1), 
+	   vec3( 1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1),
+	   vec3( 1,  1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1,  1,  0),
+	   vec3( 1,  0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1,  0, -1),
+	   vec3( 0,  1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0,  1, -1)
+	);
+
+	float shadow = 0.0;
+	vec3 worldToLight = worldPos - lightPos;
+	float currentDepth = length(worldToLight);
+
+	float bias = 0.15;
+	int samples = 20;
+	float viewDistance = length(viewPos - worldPos);
+	float diskRadius = (1.0 + (viewDistance / sceneConstant.farPlane)) / 25.0;
+	for (int i = 0; i < samples; ++i)
+	{
+		// the fourth coordinate selects the light's cube in the array.
+		float closestDepth = texture(pointShadowCubeMapArray, vec4(worldToLight + sampleOffsetDirections[i] * diskRadius, float(cubeIndex))).r;
+		closestDepth *= sceneConstant.farPlane;   // undo mapping [0;1]
+		if (currentDepth - bias > closestDepth)
+			shadow += 1.0;
+	}
+	shadow /= float(samples);
+
+	return shadow;
+}
+#endif
+
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+float CalculateCascadedShadow(vec3 worldPos, vec3 normal, vec3 lightDir)
+{
+	// pick the first cascade whose far split is behind the fragment.
+	float viewDepth = -(sceneConstant.view * vec4(worldPos, 1.0)).z;
+	int cascadeIndex = cascadeCount - 1;
+	for (int i = 0; i < cascadeCount; ++i)
+	{
+		if (viewDepth < cascadeSplits[i])
+		{
+			cascadeIndex = i;
+			break;
+		}
+	}
+
+	vec4 lightSpacePos = cascadeMatrices[cascadeIndex] * vec4(worldPos, 1.0);
+	vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
+	projCoords = projCoords * 0.5 + 0.5;
+	if (projCoords.z > 1.0)
+		return 0.0;
+
+	float currentDepth = projCoords.z;
+	// cascades have a deep depth range, so the bias is smaller than the single shadow map's.
+	float bias = max(0.005 * (1.0 - dot(normal, lightDir)), 0.0005);
+
+	float shadow = 0.0;
+	vec2 texelSize = 1.0 / vec2(textureSize(cascadedShadowMap, 0).xy);
+	for(int x = -1; x <= 1; ++x)
+	{
+	    for(int y = -1; y <= 1; ++y)
+	    {
+	        float pcfDepth = texture(cascadedShadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, float(cascadeIndex))).r;
+	        shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+	    }
+	}
+	shadow /= 9.0;
+
+	return shadow;
+}
+#endif
\ No newline at end of file
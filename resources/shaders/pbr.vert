@@ -1,4 +1,12 @@
 #version 430 core
+#ifdef MULTI_VIEW
+// writing gl_Layer from the vertex shader needs one of these, the renderer picks the one the driver exposes.
+#ifdef USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY
+#extension GL_ARB_shader_viewport_layer_array : require
+#else
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+#endif
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
@@ -58,8 +66,33 @@ struct SceneConstant
 	float farPlane;
 };
 
+#ifdef USE_UPLOAD_RING
+struct Material
+{
+	vec3 ka;
+	vec3 kd;
+	vec3 ks;
+
+	float metallic;
+	float roughness;
+	float ao;
+};
+
+// per-frame and per-draw constants written into the renderer's UploadRing, bound by range before each draw.
+// the blocks have no instance name, so the members keep the names of the plain uniforms.
+layout (std140, binding = 2) uniform SceneConstantBuffer
+{
+	SceneConstant sceneConstant;
+};
+layout (std140, binding = 3) uniform DrawConstantBuffer
+{
+	mat4 world;
+	Material material;
+};
+#else
 uniform mat4 world;
 uniform SceneConstant sceneConstant;
+#endif
 
 struct VS_OUT
 {
@@ -70,13 +103,34 @@ struct VS_OUT
 	mat3 TBN;
 
 	vec4 lightSpacePos[4];
+#ifdef MULTI_VIEW
+	vec3 cameraPos;
+#endif
 };
 
 out VS_OUT vs_out;
+#ifdef MULTI_VIEW
+#ifndef MAX_MULTI_VIEW_COUNT
+#define MAX_MULTI_VIEW_COUNT 16
+#endif
+// one view per instance, filled by MultiViewTarget.
+layout (std140, binding = 1) uniform MultiViewConstant
+{
+	mat4 views[MAX_MULTI_VIEW_COUNT];
+	vec4 cameraPositions[MAX_MULTI_VIEW_COUNT];
+} multiView;
+#endif
 
 void main()
 {
+#ifdef MULTI_VIEW
+	// every view is an instance, drawn into the array layer of the same index.
+	mat4 worldViewProj = sceneConstant.projection * multiView.views[gl_InstanceID] * world;
+	gl_Layer = gl_InstanceID;
+	vs_out.cameraPos = multiView.cameraPositions[gl_InstanceID].xyz;
+#else
 	mat4 worldViewProj = sceneConstant.projection * sceneConstant.view * world;
+#endif
 	gl_Position = worldViewProj * vec4(aPos, 1.0);
 
 	vs_out.worldPos = vec3(world * vec4(aPos, 1.0));
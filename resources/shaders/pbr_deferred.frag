@@ -78,19 +78,26 @@ struct VS_OUT
 	vec4 lightSpacePos[4];
 };
 
+// light counts and USE_* features are injected by ShaderPermutation.
+#ifndef NUM_DIRECTIONAL_LIGHTS
 #define NUM_DIRECTIONAL_LIGHTS 0
+#endif
+#ifndef NUM_POINT_LIGHTS
 #define NUM_POINT_LIGHTS 0
+#endif
+#ifndef NUM_SPOT_LIGHTS
 #define NUM_SPOT_LIGHTS 0
+#endif
+
+#ifdef USE_MASK_STENCIL
+// background pixels are rejected by the stencil test before they are shaded, see gBufferMask.frag.
+layout (early_fragment_tests) in;
+#endif
 
 in VS_OUT vs_out;
 
 out vec4 color;
 
-uniform bool isUsingTexture;
-uniform bool isUsingNormalMap;
-uniform bool enableImageBasedLighting;
-uniform bool enableShadow;
-
 uniform Material material;
 // uniform sampler2D positionMap0;
 uniform sampler2D albedoMap0;
@@ -103,19 +110,76 @@ uniform sampler2D maskMap0;
 uniform sampler2D depthMap0;
 uniform sampler2D viewMap0;
 
+#ifdef USE_IMAGE_BASED_LIGHTING
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
+#ifndef USE_ANALYTIC_BRDF
 uniform sampler2D brdfLUT;
+#endif
+#endif
 
+#ifdef USE_SHADOW
 uniform sampler2D shadowMaps[4];
 uniform samplerCube shadowCubeMaps[4];
+#ifdef USE_POINT_SHADOW_ARRAY
+// every face of every point light, rendered by the layered shadow pass.
+uniform samplerCubeArray pointShadowCubeMapArray;
+#endif
+#ifdef USE_CASCADED_SHADOW
+#define MAX_CASCADES 4
+// cascades of the first directional light, see CascadedShadowMap.
+uniform sampler2DArray cascadedShadowMap;
+uniform mat4 cascadeMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES]; // far view depth of each cascade
+uniform int cascadeCount;
+#endif
+#endif
 
 uniform SceneConstant sceneConstant;
 
+#ifdef USE_CLUSTERED_LIGHTING
+// cluster counts must match ClusteredLighting and lightCulling.comp.
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+
+struct ClusteredLight
+{
+	vec4 positionRange;
+	vec4 colorType;
+	vec4 directionCutOff;
+	vec4 outerCutOff;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+	ClusteredLight clusteredLights[];
+};
+
+layout (std430, binding = 1) readonly buffer LightGridBuffer
+{
+	uvec2 lightGrid[];
+};
+
+layout (std430, binding = 2) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uniform float clusterNearZ;
+uniform float clusterFarZ;
+uniform vec2 clusterScreenSize;
+#endif
+
+// shaded world position, written once in main and read by the light functions.
+vec3 worldPos;
+
 const float PI = 3.14159265359f;
 
 vec3 ScreenToWorld(vec2 screenCoords, float depth);
 vec3 WorldPosFromDepth(float depth);
+vec3 WorldPosFromReversedDepth(float depth);
+vec3 DecodeOctahedralNormal(vec2 encoded);
 
 float DistributionGGX(vec3 N, vec3 H, float roughness);
 float GeometrySchlickGGX(float NdotV, float roughness);
@@ -129,41 +193,92 @@ vec3 BlinnPhong(vec3 ambient, vec3 diffuse, vec3 specular,
 vec3 CookTorrance(vec3 lightDir, vec3 radiance,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
-vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampler2D shadowMap,
+vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, int shadowMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
-vec3 CalculatePointLight(PointLight light, samplerCube shadowCubeMap,
+vec3 CalculatePointLight(PointLight light, int shadowCubeMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
 vec3 CalculateSpotLight(SpotLight light,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal);
 
+#ifdef USE_IMAGE_BASED_LIGHTING
 vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 V, vec3 N, vec3 R);
+#endif
+
+#ifdef USE_CLUSTERED_LIGHTING
+vec3 CalculateClusteredLights(vec3 position,
+	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
+	vec3 viewDir, vec3 normal);
+#endif
 
 float CalculateShadow(vec4 lightSpacePos, vec3 normal, vec3 lightDir, sampler2D shadowMap);
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+float CalculateCascadedShadow(vec3 worldPos, vec3 normal, vec3 lightDir);
+#endif
 float CalculatePointShadow(vec3 worldPos, vec3 viewPos, vec3 lightPos, samplerCube shadowCubeMap);
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+float CalculatePointShadowFromArray(vec3 worldPos, vec3 viewPos, vec3 lightPos, int cubeIndex);
+#endif
 
 void main()
 {
+#ifdef PACKED_G_BUFFER
+	vec4 albedoAo = texture(albedoMap0, vs_out.texCoords);
+	vec2 metallicRoughness = texture(metallicRoughnessMap0, vs_out.texCoords).rg;
+
+	vec3 albedo = albedoAo.rgb;
+	float alphaChannel = 1.0;
+	float metallic = metallicRoughness.r;
+	float roughness = metallicRoughness.g;
+	float ao = albedoAo.a;
+	float mask = 1.0;
+#else
 	vec3 albedo = texture(albedoMap0, vs_out.texCoords).rgb;
 	float alphaChannel = texture(albedoMap0, vs_out.texCoords).a;
 	float metallic = texture(metallicMap0, vs_out.texCoords).r;
 	float roughness = texture(roughnessMap0, vs_out.texCoords).r;
 	float ao = texture(aoMap0, vs_out.texCoords).r;
+#ifdef USE_MASK_STENCIL
+	float mask = 1.0;
+#else
 	float mask = texture(maskMap0, vs_out.texCoords).r;
+#endif
+#endif
 	float depth = texture(depthMap0, vs_out.texCoords).r;
 
 	// vec2 pixelCoords = gl_FragCoord.xy;
 	// vec3 position = ScreenToWorld(pixelCoords, depth);
 	// vec3 position = texture(positionMap0, vs_out.texCoords).rgb;
-	vec3 position = vs_out.worldPos;
 	// vec3 position = WorldPosFromDepth(depth);
+#ifdef RECONSTRUCT_POSITION_FROM_DEPTH
+#ifdef REVERSED_DEPTH
+	vec3 position = WorldPosFromReversedDepth(depth);
+	// reversed depth is cleared to 0, which marks the background.
+	mask = depth > 0.0 ? 1.0 : 0.0;
+#else
+	vec3 position = WorldPosFromDepth(depth);
+	// standard depth is cleared to 1 at the far plane.
+	mask = depth < 1.0 ? 1.0 : 0.0;
+#endif
+#else
+	vec3 position = vs_out.worldPos;
+#endif
+	worldPos = position;
 
+#ifdef PACKED_G_BUFFER
+	vec3 N = DecodeOctahedralNormal(texture(normalMap0, vs_out.texCoords).rg);
+#else
 	vec3 N = 2.0 * texture(normalMap0, vs_out.texCoords).rgb - 1.0;
+#endif
 
+#ifdef RECONSTRUCT_POSITION_FROM_DEPTH
+	vec3 V = normalize(sceneConstant.cameraPos - position);
+#else
 	vec3 V = normalize(sceneConstant.cameraPos + normalize(sceneConstant.cameraFront) * 0.3 - position);
+#endif
 	// vec3 V = 2.0 * texture(viewMap0, vs_out.texCoords).rgb - 1.0;
 	// vec3 V = normalize(sceneConstant.cameraPos - position);
 	vec3 R = reflect(-V, N);
@@ -175,40 +290,52 @@ void main()
 
 	vec3 pointLightColor = vec3(0.0);	
 
+#ifdef USE_CLUSTERED_LIGHTING
+	// point and spot lights come from the fragment's cluster instead of the uniform arrays.
+	pointLightColor = CalculateClusteredLights(position,
+		albedo, metallic, roughness, ao, F0,
+		V, N);
+#else
 	for (int i = 0; i < NUM_POINT_LIGHTS; i++)
 	{
 		pointLightColor += CalculatePointLight(sceneConstant.pointLights[i],
-			shadowCubeMaps[i],
+			i,
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
+#endif
 
 	vec3 directionalLightColor = vec3(0.0);	
 
 	for (int i = 0; i < NUM_DIRECTIONAL_LIGHTS; i++)
 	{
+		// the fullscreen quad has no per-fragment light space position, it comes from the shaded position instead.
+		vec4 lightSpacePos = sceneConstant.directionalLights[i].lightSpaceMatrix * vec4(position, 1.0);
 		directionalLightColor += CalculateDirectionalLight(sceneConstant.directionalLights[i],
-			vs_out.lightSpacePos[i], shadowMaps[0],
+			lightSpacePos, i,
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
 
 	vec3 spotLightColor = vec3(0.0);	
 
+#ifndef USE_CLUSTERED_LIGHTING
 	for (int i = 0; i < NUM_SPOT_LIGHTS; i++)
 	{
 		spotLightColor += CalculateSpotLight(sceneConstant.spotLights[i],
 			albedo, metallic, roughness, ao, F0,
 			V, N);
 	}
+#endif
 
 	// ambient lighting (note that the next IBL tutorial will replace 
     // this ambient lighting with environment lighting).
 
 	vec3 ambient = vec3(0.002);
 	ambient = ambient * albedo * ao;
-	if (enableImageBasedLighting)
-		ambient = CalculateImageBasedLight(albedo, metallic, roughness, ao, F0, V, N, R);
+#ifdef USE_IMAGE_BASED_LIGHTING
+	ambient = CalculateImageBasedLight(albedo, metallic, roughness, ao, F0, V, N, R);
+#endif
 	
 	vec3 result = ambient + pointLightColor + directionalLightColor + spotLightColor;
 
@@ -234,10 +361,12 @@ void main()
 	
 	if (mask == 1.0)
 	{		
+#ifndef OUTPUT_LINEAR_HDR
 		// HDR tonemapping
 		result = result / (result + vec3(1.0));
 		// gamma correct
 		result = pow(result, vec3(1.0 / 2.2));
+#endif
 	
 		color = vec4(result, alphaChannel);
 		// color = vec4(prefilteredColor, 1.0);
@@ -280,6 +409,32 @@ vec3 WorldPosFromDepth(float depth)
 	return worldSpacePosition.xyz;
 }
 
+// reversed-Z uses zero-to-one clip control, so the stored depth already is the ndc z.
+vec3 WorldPosFromReversedDepth(float depth)
+{
+	vec4 clipSpacePosition = vec4(vs_out.texCoords * 2.0 - 1.0, depth, 1.0);
+
+	vec4 viewSpacePosition = sceneConstant.invProjection * clipSpacePosition;
+
+	viewSpacePosition /= viewSpacePosition.w;
+
+	vec4 worldSpacePosition = sceneConstant.invView * viewSpacePosition;
+
+	return worldSpacePosition.xyz;
+}
+
+// inverse of the octahedral mapping written by gBuffer.frag
+vec3 DecodeOctahedralNormal(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+
+	return normalize(n);
+}
+
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
 	float a = roughness * roughness;
@@ -358,29 +513,31 @@ vec3 CookTorrance(vec3 lightDir, vec3 radiance,
 	return (kD * albedo / PI + specular) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
 }
 
-vec3 CalculatePointLight(PointLight light, samplerCube shadowCubeMap,
+vec3 CalculatePointLight(PointLight light, int shadowCubeMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal)
 {
 	// calculate per-light radiance
-	vec3 lightDir = normalize(light.position - vs_out.worldPos);
-	float distance = length(light.position - vs_out.worldPos);
+	vec3 lightDir = normalize(light.position - worldPos);
+	float distance = length(light.position - worldPos);
 	float attenuation = 1.0 / (distance * distance);
 	vec3 radiance = light.diffuse * attenuation;
 
 	// calculate shadow.
 	float shadow = 0.0;
-	// if (enableShadow)
-	// 	shadow = CalculatePointShadow(vs_out.worldPos, sceneConstant.cameraPos, light.position, shadowCubeMap);
-	// else
-	// 	shadow = 0.0f;
+// #ifdef USE_SHADOW
+// 	shadow = CalculatePointShadow(worldPos, sceneConstant.cameraPos, light.position, shadowCubeMaps[shadowCubeMapIndex]);
+// #endif
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+	shadow = CalculatePointShadowFromArray(worldPos, sceneConstant.cameraPos, light.position, shadowCubeMapIndex);
+#endif
 
 	return (1.0 - shadow) * CookTorrance(lightDir, radiance,
 		albedo, metallic, roughness, ao, F0,
 		viewDir, normal);
 }
 
-vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampler2D shadowMap,
+vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, int shadowMapIndex,
 	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 viewDir, vec3 normal)
 {
@@ -390,10 +547,14 @@ vec3 CalculateDirectionalLight(DirectionalLight light, vec4 lightSpacePos, sampl
 
 	// calculate shadow.
 	float shadow = 0.0;
-	if (enableShadow)
-		shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMap);
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+	if (shadowMapIndex == 0)
+		shadow = CalculateCascadedShadow(worldPos, normal, lightDir);
 	else
-		shadow = 0.0;
+		shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMaps[shadowMapIndex]);
+#elif defined(USE_SHADOW)
+	shadow = CalculateShadow(lightSpacePos, normal, lightDir, shadowMaps[shadowMapIndex]);
+#endif
 
 	return (1.0f - shadow) * CookTorrance(lightDir, radiance,
 		albedo, metallic, roughness, ao, F0,
@@ -405,13 +566,13 @@ vec3 CalculateSpotLight(SpotLight light,
 	vec3 viewDir, vec3 normal)
 {
 	// calculate per-light radiance
-	vec3 lightDir = normalize(light.position - vs_out.worldPos);
+	vec3 lightDir = normalize(light.position - worldPos);
 
 	float theta = dot(lightDir, normalize(-light.direction)); 
     float epsilon = (light.cutOff - light.outerCutOff);
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
 
-	float distance = length(light.position - vs_out.worldPos);
+	float distance = length(light.position - worldPos);
 	float attenuation = 1.0f / (distance * distance);
 	vec3 radiance = light.diffuse * attenuation * intensity;
 
@@ -420,6 +581,19 @@ vec3 CalculateSpotLight(SpotLight light,
 		viewDir, normal);
 }
 
+#ifdef USE_ANALYTIC_BRDF
+// analytic fit of the split-sum BRDF table (Karis, "Physically Based Shading on Mobile"), no texture fetch.
+vec2 EnvBRDFApprox(float NdotV, float roughness)
+{
+	const vec4 c0 = vec4(-1.0, -0.0275, -0.572, 0.022);
+	const vec4 c1 = vec4(1.0, 0.0425, 1.04, -0.04);
+	vec4 r = roughness * c0 + c1;
+	float a004 = min(r.x * r.x, exp2(-9.28 * NdotV)) * r.x + r.y;
+	return vec2(-1.04, 1.04) * a004 + r.zw;
+}
+#endif
+
+#ifdef USE_IMAGE_BASED_LIGHTING
 vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
 	vec3 V, vec3 N, vec3 R)
 {
@@ -435,11 +609,16 @@ vec3 CalculateImageBasedLight(vec3 albedo, float metallic, float roughness, floa
 	// sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
 	const float MAX_REFLECTION_LOD = 4.0;
 	vec3 prefilteredColor = textureLod(prefilterMap, R, roughness * MAX_REFLECTION_LOD).rgb;
+#ifdef USE_ANALYTIC_BRDF
+	vec2 envBRDF = EnvBRDFApprox(max(dot(N, V), 0.0), roughness);
+#else
 	vec2 envBRDF = texture(brdfLUT, vec2(max(dot(N, V), 0.0), roughness)).rg;
+#endif
 	vec3 specular = prefilteredColor * (F * envBRDF.x + envBRDF.y);
 	
 	return (kD * diffuse + specular) * ao;
 }
+#endif
 
 float CalculateShadow(vec4 lightSpacePos, vec3 normal, vec3 lightDir, sampler2D shadowMap)
 {
@@ -508,4 +687,124 @@ float CalculatePointShadow(vec3 worldPos, vec3 viewPos, vec3 lightPos, samplerCu
 	shadow /= float(samples); 
 
     return shadow;
-}
\ No newline at end of file
+}
+
+#ifdef USE_CLUSTERED_LIGHTING
+vec3 CalculateClusteredLights(vec3 position,
+	vec3 albedo, float metallic, float roughness, float ao, vec3 F0,
+	vec3 viewDir, vec3 normal)
+{
+	// same exponential depth slicing as lightCulling.comp.
+	float viewDepth = -(sceneConstant.view * vec4(position, 1.0)).z;
+	float slice = log(max(viewDepth, clusterNearZ) / clusterNearZ) / log(clusterFarZ / clusterNearZ) * float(CLUSTER_COUNT_Z);
+	uint clusterZ = uint(clamp(slice, 0.0, float(CLUSTER_COUNT_Z - 1)));
+	vec2 tile = gl_FragCoord.xy / clusterScreenSize * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y);
+	uvec2 clusterXY = uvec2(clamp(tile, vec2(0.0), vec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1)));
+	uint clusterIndex = clusterXY.x + clusterXY.y * CLUSTER_COUNT_X + clusterZ * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+
+	uvec2 grid = lightGrid[clusterIndex]; // offset, count
+	vec3 result = vec3(0.0);
+	for (uint i = 0; i < grid.y; i++)
+	{
+		ClusteredLight light = clusteredLights[lightIndices[grid.x + i]];
+
+		vec3 toLight = light.positionRange.xyz - position;
+		float distance = length(toLight);
+		vec3 lightDir = toLight / max(distance, 0.0001);
+
+		// inverse-square falloff, windowed to reach zero at the culling range.
+		float ratio = distance / light.positionRange.w;
+		float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / max(distance * distance, 0.0001);
+
+		// spot light
+		if (light.colorType.w > 0.5)
+		{
+			float theta = dot(lightDir, -light.directionCutOff.xyz);
+			float epsilon = light.directionCutOff.w - light.outerCutOff.x;
+			attenuation *= clamp((theta - light.outerCutOff.x) / epsilon, 0.0, 1.0);
+		}
+
+		result += CookTorrance(lightDir, light.colorType.rgb * attenuation,
+			albedo, metallic, roughness, ao, F0,
+			viewDir, normal);
+	}
+
+	return result;
+}
+#endif
+
+#if defined(USE_SHADOW) && defined(USE_POINT_SHADOW_ARRAY)
+float CalculatePointShadowFromArray(vec3 worldPos, vec3 viewPos, vec3 lightPos, int cubeIndex)
+{
+	vec3 sampleOffsetDirections[20] = vec3[]
+	(
+	   vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1), 
+	   vec3( 1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1),
+	   vec3( 1,  1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1,  1,  0),
+	   vec3( 1,  0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1,  0, -1),
+	   vec3( 0,  1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0,  1, -1)
+	);
+
+	float shadow = 0.0;
+	vec3 worldToLight = worldPos - lightPos;
+	float currentDepth = length(worldToLight);
+
+	float bias = 0.15;
+	int samples = 20;
+	float viewDistance = length(viewPos - worldPos);
+	float diskRadius = (1.0 + (viewDistance / sceneConstant.farPlane)) / 25.0;
+	for (int i = 0; i < samples; ++i)
+	{
+		// the fourth coordinate selects the light's cube in the array.
+		float closestDepth = texture(pointShadowCubeMapArray, vec4(worldToLight + sampleOffsetDirections[i] * diskRadius, float(cubeIndex))).r;
+		closestDepth *= sceneConstant.farPlane;   // undo mapping [0;1]
+		if (currentDepth - bias > closestDepth)
+			shadow += 1.0;
+	}
+	shadow /= float(samples);
+
+	return shadow;
+}
+#endif
+
+#if defined(USE_SHADOW) && defined(USE_CASCADED_SHADOW)
+float CalculateCascadedShadow(vec3 worldPos, vec3 normal, vec3 lightDir)
+{
+	// pick the first cascade whose far split is behind the fragment.
+	float viewDepth = -(sceneConstant.view * vec4(worldPos, 1.0)).z;
+	int cascadeIndex = cascadeCount - 1;
+	for (int i = 0; i < cascadeCount; ++i)
+	{
+		if (viewDepth < cascadeSplits[i])
+		{
+			cascadeIndex = i;
+			break;
+		}
+	}
+
+	vec4 lightSpacePos = cascadeMatrices[cascadeIndex] * vec4(worldPos, 1.0);
+	vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
+	projCoords = projCoords * 0.5 + 0.5;
+	if (projCoords.z > 1.0)
+		return 0.0;
+
+	float currentDepth = projCoords.z;
+	// cascades have a deep depth range, so the bias is smaller than the single shadow map's.
+	float bias = max(0.005 * (1.0 - dot(normal, lightDir)), 0.0005);
+
+	float shadow = 0.0;
+	vec2 texelSize = 1.0 / vec2(textureSize(cascadedShadowMap, 0).xy);
+	for(int x = -1; x <= 1; ++x)
+	{
+	    for(int y = -1; y <= 1; ++y)
+	    {
+	        float pcfDepth = texture(cascadedShadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, float(cascadeIndex))).r;
+	        shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+	    }
+	}
+	shadow /= 9.0;
+
+	return shadow;
+}
+#endif
\ No newline at end of file
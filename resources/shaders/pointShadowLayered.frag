@@ -0,0 +1,14 @@
+#version 430 core
+#define MAX_POINT_LIGHTS 4
+
+in vec3 worldPos;
+flat in uint lightIndex;
+
+uniform vec3 lightPositions[MAX_POINT_LIGHTS];
+uniform float farPlane;
+
+void main()
+{
+	// linear distance to the light mapped to [0;1], same as pointShadow.frag
+	gl_FragDepth = length(worldPos - lightPositions[lightIndex]) / farPlane;
+}
\ No newline at end of file
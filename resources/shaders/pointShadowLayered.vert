@@ -0,0 +1,35 @@
+#version 430 core
+// writing gl_Layer from the vertex shader needs one of these, the renderer picks the one the driver exposes.
+#ifdef USE_ARB_SHADER_VIEWPORT_LAYER_ARRAY
+#extension GL_ARB_shader_viewport_layer_array : require
+#else
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+layout (location = 0) in vec3 aPos;
+// one entry per instance, render item index << 8 | light index * 6 + face.
+// the baseInstance of each draw command points at the first visible face of its render item.
+layout (location = 4) in uint aShadowFace;
+
+#define MAX_POINT_LIGHTS 4
+
+layout (std430, binding = 4) readonly buffer ShadowWorldBuffer
+{
+	mat4 worlds[];
+};
+
+uniform mat4 lightSpaceMatrices[6 * MAX_POINT_LIGHTS];
+
+out vec3 worldPos;
+flat out uint lightIndex;
+
+void main()
+{
+	// the cube map array layer is the same light * 6 + face index.
+	uint shadowFace = aShadowFace & 0xFFu;
+
+	worldPos = vec3(worlds[aShadowFace >> 8] * vec4(aPos, 1.0));
+	lightIndex = shadowFace / 6;
+
+	gl_Position = lightSpaceMatrices[shadowFace] * vec4(worldPos, 1.0);
+	gl_Layer = int(shadowFace);
+}
\ No newline at end of file